@@ -67,6 +67,9 @@ var WEATHER_API_KEY = "3183db8ec2fe4abfa2c133226251310";
 var WEATHER_LOCATION = "Mumbai";
 var WS_URL = "wss://echo-websocket.fly.dev/";  // Modern, reliable echo server
 
+// Shared helpers from /lib/format.js
+var format = require("format");
+
 // ============================================================================
 // LIFECYCLE METHODS
 // ============================================================================
@@ -296,14 +299,14 @@ function updateClock() {
                 var s = uptime % 60;
                 var m = Math.floor(uptime / 60) % 60;
                 var h = Math.floor(uptime / 3600);
-                updateLabel(clockLabel, pad(h) + ":" + pad(m) + ":" + pad(s) + " *");
+                updateLabel(clockLabel, format.clock(h, m, s) + " *");
             }
         }
         return;
     }
 
     // Real NTP time available!
-    var timeStr = pad(time.hour) + ":" + pad(time.minute) + ":" + pad(time.second);
+    var timeStr = format.clock(time.hour, time.minute, time.second);
 
     if (clockLabel !== null) {
         updateLabel(clockLabel, timeStr);
@@ -324,8 +327,11 @@ function updateWeather() {
     var url = "http://api.weatherapi.com/v1/current.json?key=" +
               WEATHER_API_KEY + "&q=" + WEATHER_LOCATION + "&aqi=no";
 
-    var response = httpGet(url);
+    // Runs in the background - the displays keep rendering meanwhile
+    httpGet(url, onWeatherResponse);
+}
 
+function onWeatherResponse(response, status) {
     if (response) {
         try {
             var data = JSON.parse(response);
@@ -350,7 +356,7 @@ function updateWeather() {
             }
         }
     } else {
-        log("Failed to fetch weather");
+        log("Failed to fetch weather (" + status + ")");
         if (weatherLabel !== null) {
             updateLabel(weatherLabel, "API Error");
         }
@@ -479,15 +485,6 @@ function pollWebSocket() {
     }
 }
 
-// ============================================================================
-// HELPER FUNCTIONS
-// ============================================================================
-
-
-function pad(num) {
-    return num < 10 ? "0" + num : num.toString();
-}
-
 // ============================================================================
 // END
 // ============================================================================
@@ -7,6 +7,9 @@
 
 var animId = -1;
 var isPlaying = false;
+var statusLabel = null;
+var speedLabel = null;
+var opacityLabel = null;
 
 function onCreate() {
     log("Animation Test App - Starting");
@@ -16,7 +19,7 @@ function onCreate() {
 
     // Create instructions
     createLabel("Animation Test", 120, 20);
-    createLabel("Loading animation...", 120, 60);
+    statusLabel = createLabel("Loading animation...", 120, 60);
 
     // Load test animation
     animId = loadAnimation("/animations/test.spr");
@@ -32,20 +35,20 @@ function onCreate() {
 
         if (success) {
             isPlaying = true;
-            updateLabel(1, "Playing (loop)");
+            updateLabel(statusLabel, "Playing (loop)");
             log("Animation playing");
         } else {
-            updateLabel(1, "Failed to play");
+            updateLabel(statusLabel, "Failed to play");
             log("Failed to start animation");
         }
     } else {
         log("Failed to load animation");
-        updateLabel(1, "Load failed!");
+        updateLabel(statusLabel, "Load failed!");
     }
 
     // Create control hints
-    createLabel("Speed: 1.0x", 120, 200);
-    createLabel("Opacity: 255", 120, 220);
+    speedLabel = createLabel("Speed: 1.0x", 120, 200);
+    opacityLabel = createLabel("Opacity: 255", 120, 220);
 }
 
 var frameCount = 0;
@@ -66,14 +69,14 @@ function onUpdate() {
                 // Test speed change
                 log("Testing speed: 2.0x");
                 setAnimationSpeed(animId, 2.0);
-                updateLabel(2, "Speed: 2.0x");
+                updateLabel(speedLabel, "Speed: 2.0x");
                 break;
 
             case 2:
                 // Test opacity change
                 log("Testing opacity: 128");
                 setAnimationOpacity(animId, 128);
-                updateLabel(3, "Opacity: 128");
+                updateLabel(opacityLabel, "Opacity: 128");
                 break;
 
             case 3:
@@ -81,7 +84,7 @@ function onUpdate() {
                 log("Testing pause");
                 pauseAnimation(animId);
                 isPlaying = false;
-                updateLabel(1, "Paused");
+                updateLabel(statusLabel, "Paused");
                 break;
 
             case 4:
@@ -89,7 +92,7 @@ function onUpdate() {
                 log("Testing resume");
                 resumeAnimation(animId);
                 isPlaying = true;
-                updateLabel(1, "Playing (loop)");
+                updateLabel(statusLabel, "Playing (loop)");
                 break;
 
             case 5:
@@ -97,8 +100,8 @@ function onUpdate() {
                 log("Reset to normal");
                 setAnimationSpeed(animId, 1.0);
                 setAnimationOpacity(animId, 255);
-                updateLabel(2, "Speed: 1.0x");
-                updateLabel(3, "Opacity: 255");
+                updateLabel(speedLabel, "Speed: 1.0x");
+                updateLabel(opacityLabel, "Opacity: 255");
                 break;
 
             case 6:
@@ -106,7 +109,7 @@ function onUpdate() {
                 log("Testing stop");
                 stopAnimation(animId);
                 isPlaying = false;
-                updateLabel(1, "Stopped");
+                updateLabel(statusLabel, "Stopped");
                 break;
 
             case 7:
@@ -114,7 +117,7 @@ function onUpdate() {
                 log("Testing replay");
                 playAnimation(animId, true);
                 isPlaying = true;
-                updateLabel(1, "Playing (loop)");
+                updateLabel(statusLabel, "Playing (loop)");
                 testPhase = 0; // Loop back
                 break;
         }
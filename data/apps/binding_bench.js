@@ -0,0 +1,128 @@
+/**
+ * Binding Benchmark App for Doki OS
+ *
+ * Measures how many native binding calls per second a JS context can
+ * make. Each onUpdate() runs one batch of a single binding and prints
+ * the calls/second figure to the log and the screen.
+ *
+ * Bindings measured:
+ *   getDisplayId   - baseline (no object lookup)
+ *   setOpacity     - handle lookup + one LVGL style call
+ *   setLabelColor  - handle lookup + one LVGL style call
+ *   updateLabel    - handle lookup + text update
+ *
+ * Frame budget (one "frame" = text, color and opacity on 10 labels):
+ *   frame/single   - 30 individual binding calls
+ *   frame/batch    - one applyUpdates() call
+ */
+
+var BATCH_SIZE = 200;
+var FRAMES_PER_BATCH = 20;
+var ROUNDS_PER_TEST = 5;
+var FRAME_LABELS = 10;
+
+var targetLabel = null;
+var frameLabels = [];
+var resultLabels = [];
+
+function runFrameSingle(frame) {
+    for (var i = 0; i < FRAME_LABELS; i++) {
+        updateLabel(frameLabels[i], "v" + ((frame + i) & 7));
+        setLabelColor(frameLabels[i], (frame & 1) ? 0xffffff : 0x888888);
+        setOpacity(frameLabels[i], (frame & 1) ? 255 : 200);
+    }
+}
+
+function runFrameBatch(frame) {
+    var updates = [];
+    for (var i = 0; i < FRAME_LABELS; i++) {
+        updates.push({
+            id: frameLabels[i],
+            text: "v" + ((frame + i) & 7),
+            color: (frame & 1) ? 0xffffff : 0x888888,
+            opacity: (frame & 1) ? 255 : 200
+        });
+    }
+    applyUpdates(updates);
+}
+
+var tests = [
+    { name: "getDisplayId", run: function(n) {
+        for (var i = 0; i < n; i++) getDisplayId();
+    }},
+    { name: "setOpacity", run: function(n) {
+        for (var i = 0; i < n; i++) setOpacity(targetLabel, 255 - (i & 63));
+    }},
+    { name: "setLabelColor", run: function(n) {
+        for (var i = 0; i < n; i++) setLabelColor(targetLabel, 0xffffff - i);
+    }},
+    { name: "updateLabel", run: function(n) {
+        for (var i = 0; i < n; i++) updateLabel(targetLabel, "n=" + i);
+    }},
+    { name: "frame/single", frames: true, run: function(n) {
+        for (var f = 0; f < n; f++) runFrameSingle(f);
+    }},
+    { name: "frame/batch", frames: true, run: function(n) {
+        for (var f = 0; f < n; f++) runFrameBatch(f);
+    }}
+];
+
+var testIndex = 0;
+var round = 0;
+var totalCalls = 0;
+var totalMs = 0;
+
+function onCreate() {
+    log("Binding benchmark created");
+    setBackgroundColor(0x000000);
+
+    var title = createLabel("Binding Benchmark", 40, 10);
+    setLabelColor(title, 0x00d4ff);
+
+    targetLabel = createLabel("target", 10, 280);
+
+    for (var i = 0; i < FRAME_LABELS; i++) {
+        frameLabels.push(createLabel("v", 10 + i * 22, 300));
+    }
+
+    for (var i = 0; i < tests.length; i++) {
+        resultLabels.push(createLabel(tests[i].name + ": ...", 10, 40 + i * 30));
+    }
+}
+
+function onUpdate() {
+    if (testIndex >= tests.length) {
+        return;
+    }
+
+    var test = tests[testIndex];
+    var batch = test.frames ? FRAMES_PER_BATCH : BATCH_SIZE;
+    var start = millis();
+    test.run(batch);
+    var elapsed = millis() - start;
+
+    totalCalls += batch;
+    totalMs += elapsed;
+    round++;
+
+    if (round < ROUNDS_PER_TEST) {
+        return;
+    }
+
+    var perSecond = totalMs > 0 ? Math.round(totalCalls * 1000 / totalMs) : totalCalls * 1000;
+    var line;
+    if (test.frames) {
+        // Frame budget: microseconds of JS + binding time per frame
+        var usPerFrame = Math.round(totalMs * 1000 / totalCalls);
+        line = test.name + ": " + usPerFrame + " us/frame";
+    } else {
+        line = test.name + ": " + perSecond + " calls/s";
+    }
+    updateLabel(resultLabels[testIndex], line);
+    log("[Bench] " + line + " (" + totalCalls + " runs in " + totalMs + " ms)");
+
+    testIndex++;
+    round = 0;
+    totalCalls = 0;
+    totalMs = 0;
+}
@@ -2,10 +2,13 @@
  * Counter JavaScript App for Doki OS
  *
  * Shows a simple counter that persists across app reloads.
+ * Driven by setInterval() - there is no onUpdate(), so the app is
+ * only called into once a second.
  */
 
 var count = 0;
 var countLabel = null;
+var tickTimer = 0;
 
 function onCreate() {
     log("Counter app created");
@@ -16,10 +19,8 @@ function onCreate() {
     // Title
     createLabel("Counter App", 60, 60);
 
-    // Counter display (we'll update this in onUpdate)
-    // Note: LVGL object references don't persist in JS yet,
-    // so we recreate the label each time
-    updateCounterDisplay();
+    // Counter display
+    countLabel = createLabel("Count: " + count, 60, 120);
 
     // Buttons
     createButton("+", 60, 180);
@@ -29,25 +30,25 @@ function onCreate() {
 
 function onStart() {
     log("Counter app started");
-}
 
-function onUpdate() {
     // In a real implementation, you'd handle button clicks here
     // For now, we'll auto-increment every second as a demo
+    tickTimer = setInterval(tick, 1000);
+}
+
+function tick() {
     count++;
     if (count > 999) count = 0;
 
-    // Update display
     updateCounterDisplay();
 }
 
 function updateCounterDisplay() {
-    // Create large counter label
-    // In real LVGL binding, we'd update existing label instead
-    createLabel("Count: " + count, 60, 120);
+    updateLabel(countLabel, "Count: " + count);
 }
 
 function onPause() {
+    clearInterval(tickTimer);
     log("Counter paused at: " + count);
 }
 
@@ -66,5 +67,6 @@ function onRestoreState(state) {
     if (savedCount) {
         count = parseInt(savedCount);
         log("Restored counter to: " + count);
+        updateCounterDisplay();
     }
 }
@@ -0,0 +1,105 @@
+/**
+ * Particles App for Doki OS
+ *
+ * Procedural graphics on a canvas: a fountain of particles drawn every
+ * frame without creating a single LVGL object per particle.
+ *
+ * - fb      240x280 canvas that is cleared and redrawn each frame
+ * - spark   4x4 sprite canvas, blitted with a color key
+ *
+ * The frame time (JS + native drawing) is shown at the top.
+ */
+
+var PARTICLES = 120;
+var KEY = 0xff00ff;
+
+var fb = null;
+var spark = null;
+var statsLabel = null;
+
+var px = [];
+var py = [];
+var vx = [];
+var vy = [];
+
+var frameId = 0;
+var frames = 0;
+var frameUs = 0;
+var lastReport = 0;
+
+function spawn(i) {
+    px[i] = 118;
+    py[i] = 270;
+    vx[i] = (Math.random() - 0.5) * 3;
+    vy[i] = -4 - Math.random() * 3;
+}
+
+function onCreate() {
+    log("Particles app created");
+    setBackgroundColor(0x000000);
+
+    statsLabel = createLabel("", 10, 10);
+    setLabelColor(statsLabel, 0x00d4ff);
+
+    fb = createCanvas(240, 280, 0, 40);
+    spark = createCanvas(4, 4, 0, 0);
+
+    if (!fb || !spark) {
+        updateLabel(statsLabel, "Out of memory");
+        return;
+    }
+
+    // Round-ish spark: key color in the corners
+    canvasFill(spark, 0xffaa00);
+    spark[0] = spark[3] = spark[12] = spark[15] = 0xf81f;  // KEY in RGB565
+    setOpacity(spark.id, 0);
+
+    for (var i = 0; i < PARTICLES; i++) {
+        spawn(i);
+        py[i] -= Math.random() * 270;  // Stagger the first wave
+    }
+}
+
+function onStart() {
+    if (fb && spark) {
+        frameId = requestAnimationFrame(frame);
+    }
+}
+
+function frame(now) {
+    var start = millis();
+
+    canvasFill(fb, 0x000000);
+
+    for (var i = 0; i < PARTICLES; i++) {
+        vy[i] += 0.12;
+        px[i] += vx[i];
+        py[i] += vy[i];
+
+        if (py[i] > 280 || px[i] < -4 || px[i] > 240) {
+            spawn(i);
+        }
+
+        canvasBlit(fb, spark, px[i] | 0, py[i] | 0, 0, 0, 4, 4, KEY);
+    }
+
+    frames++;
+    frameUs += (millis() - start) * 1000;
+
+    if (now - lastReport >= 1000) {
+        updateLabel(statsLabel, PARTICLES + " particles  " + (frameUs / frames / 1000).toFixed(1) + " ms/frame");
+        frames = 0;
+        frameUs = 0;
+        lastReport = now;
+    }
+
+    frameId = requestAnimationFrame(frame);
+}
+
+function onPause() {
+    cancelAnimationFrame(frameId);
+}
+
+function onDestroy() {
+    log("Particles app destroyed");
+}
@@ -190,78 +190,18 @@ function onRestoreState(state) {
 // ============================================================================
 
 function setupUI() {
-    // Dark blue background
-    setBackgroundColor(0x0f172a);
-
-    // Title
-    titleLabel = createLabel("WebSocket Test", 50, 10);
-    setLabelColor(titleLabel, 0x60a5fa);
-    setLabelSize(titleLabel, 20);
-
-    // Divider
-    drawRectangle(10, 35, 220, 2, 0x334155);
-
-    // Status section
-    createLabel("STATUS", 10, 45);
-    setLabelColor(0, 0x94a3b8);
-    setLabelSize(0, 12);
-
-    statusLabel = createLabel("Initializing...", 10, 65);
-    setLabelColor(statusLabel, 0xfbbf24);
-    setLabelSize(statusLabel, 14);
-
-    // Server section
-    createLabel("SERVER", 10, 90);
-    setLabelColor(1, 0x94a3b8);
-    setLabelSize(1, 12);
-
-    serverLabel = createLabel("echo.websocket.org", 10, 110);
-    setLabelColor(serverLabel, 0xa78bfa);
-    setLabelSize(serverLabel, 12);
-
-    // Divider
-    drawRectangle(10, 130, 220, 2, 0x334155);
-
-    // Log section
-    createLabel("MESSAGE LOG", 10, 140);
-    setLabelColor(2, 0x94a3b8);
-    setLabelSize(2, 12);
-
-    logLabel1 = createLabel("", 10, 160);
-    setLabelColor(logLabel1, 0xe2e8f0);
-    setLabelSize(logLabel1, 12);
-
-    logLabel2 = createLabel("", 10, 175);
-    setLabelColor(logLabel2, 0xe2e8f0);
-    setLabelSize(logLabel2, 12);
-
-    logLabel3 = createLabel("", 10, 190);
-    setLabelColor(logLabel3, 0xe2e8f0);
-    setLabelSize(logLabel3, 12);
-
-    logLabel4 = createLabel("", 10, 205);
-    setLabelColor(logLabel4, 0xe2e8f0);
-    setLabelSize(logLabel4, 12);
-
-    logLabel5 = createLabel("", 10, 220);
-    setLabelColor(logLabel5, 0xe2e8f0);
-    setLabelSize(logLabel5, 12);
-
-    // Divider
-    drawRectangle(10, 240, 220, 2, 0x334155);
-
-    // Test counter
-    createLabel("TEST STATS", 10, 250);
-    setLabelColor(3, 0x94a3b8);
-    setLabelSize(3, 12);
-
-    testCountLabel = createLabel("Attempts: 0 | Sent: 0 | Recv: 0", 10, 270);
-    setLabelColor(testCountLabel, 0x10b981);
-    setLabelSize(testCountLabel, 12);
-
-    // Decorative elements
-    drawCircle(220, 15, 5, 0x60a5fa);
-    drawCircle(15, 15, 3, 0xa78bfa);
+    // Whole screen built natively from /ui/websocket_test.json
+    var ui = createUI("websocket_test");
+
+    titleLabel = ui.title;
+    statusLabel = ui.status;
+    serverLabel = ui.server;
+    logLabel1 = ui.log1;
+    logLabel2 = ui.log2;
+    logLabel3 = ui.log3;
+    logLabel4 = ui.log4;
+    logLabel5 = ui.log5;
+    testCountLabel = ui.stats;
 
     logMessage("UI initialized");
 }
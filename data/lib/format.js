@@ -0,0 +1,37 @@
+/**
+ * Formatting helpers shared by Doki OS apps
+ *
+ * Usage:
+ *   var format = require("format");
+ *   updateLabel(clockLabel, format.clock(time.hour, time.minute, time.second));
+ *
+ * Compiled once per boot; every app that requires it loads the cached
+ * bytecode instead of parsing this file again.
+ */
+
+// Two-digit zero padding: 7 -> "07"
+function pad(num) {
+    return num < 10 ? "0" + num : num.toString();
+}
+
+// "HH:MM:SS"
+function clock(h, m, s) {
+    return pad(h) + ":" + pad(m) + ":" + pad(s);
+}
+
+// Milliseconds as "H:MM:SS" (uptime, elapsed time)
+function duration(ms) {
+    var total = Math.floor(ms / 1000);
+    return Math.floor(total / 3600) + ":" + pad(Math.floor(total / 60) % 60) + ":" + pad(total % 60);
+}
+
+// Fixed decimals, trimmed for display: 21.5 -> "21.5", 21 -> "21"
+function number(value, decimals) {
+    var text = value.toFixed(decimals === undefined ? 1 : decimals);
+    return text.indexOf(".") >= 0 ? text.replace(/\.?0+$/, "") : text;
+}
+
+exports.pad = pad;
+exports.clock = clock;
+exports.duration = duration;
+exports.number = number;
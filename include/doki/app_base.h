@@ -12,6 +12,9 @@
  * 3. onUpdate()  - Called every frame (app can skip if needed)
  * 4. onPause()   - App goes to background (optional)
  * 5. onDestroy() - Cleanup before unload
+ *
+ * Apps that opt in with supportsKeepAlive() may go from onPause() back
+ * to onStart() without being destroyed (see AppManager).
  */
 
 #ifndef DOKI_APP_BASE_H
@@ -97,19 +100,16 @@ public:
     virtual void onStart() = 0;
     
     /**
-     * @brief Update app state (called every frame)
+     * @brief Update app state
      * 
-     * Called repeatedly while app is running (typically 30-60 FPS).
-     * Apps can check elapsed time to decide if update is needed.
+     * Called repeatedly while app is running: on every pass of the main
+     * loop by default, or at the cadence returned by getUpdateInterval().
      * 
      * Example:
      * void onUpdate() {
-     *     uint32_t now = millis();
-     *     if (now - lastUpdate >= 1000) {  // Update every 1 second
-     *         // Update UI
-     *         lastUpdate = now;
-     *     }
+     *     // Update UI
      * }
+     * uint32_t getUpdateInterval() const { return 1000; }  // Update every 1 second
      */
     virtual void onUpdate() = 0;
     
@@ -122,7 +122,8 @@ public:
      * - Stop timers
      * - Save state
      * 
-     * Note: Not always called (depends on app manager implementation)
+     * Keep-alive apps may be started again afterwards instead of
+     * being destroyed.
      */
     virtual void onPause() {}
     
@@ -233,6 +234,50 @@ public:
      */
     uint8_t getDisplayId() const;
 
+    /**
+     * @brief Report runtime statistics (optional hook)
+     *
+     * Override this to add app-specific counters to GET /api/status.
+     *
+     * @param stats JSON object to populate
+     */
+    virtual void getRuntimeStats(JsonObject stats) {}
+
+    /**
+     * @brief Whether the app may be kept paused in memory (optional hook)
+     *
+     * Resident apps own their LVGL screen and are brought back with
+     * onStart() instead of being recreated (see APP_KEEP_ALIVE_MAX).
+     * Return true only if onPause()/onStart() can be called repeatedly,
+     * e.g. onStart() must not start a second background task.
+     *
+     * @return true to allow keep-alive (default: always destroy)
+     */
+    virtual bool supportsKeepAlive() const { return false; }
+
+    // onUpdate() cadences for getUpdateInterval()
+    static constexpr uint32_t UPDATE_EVERY_LOOP = 0;           ///< Every pass of the main loop
+    static constexpr uint32_t UPDATE_NEVER = 0xFFFFFFFF;       ///< Only when requestUpdate() asks
+
+    /**
+     * @brief How often onUpdate() should run (optional hook)
+     *
+     * Apps with an interval are kept in AppManager's deadline queue and
+     * called only when due, so they need no millis() checks of their own
+     * and the main loop can sleep in between.
+     *
+     * @return Interval in milliseconds, UPDATE_EVERY_LOOP (default) or UPDATE_NEVER
+     */
+    virtual uint32_t getUpdateInterval() const { return UPDATE_EVERY_LOOP; }
+
+    /**
+     * @brief Align deadlines to multiples of the interval on the system clock (optional hook)
+     *
+     * With a 1000 ms interval, onUpdate() runs just after each second
+     * boundary, so a clock face changes together with the second.
+     */
+    virtual bool alignUpdates() const { return false; }
+
 protected:
     // ========================================
     // Helper Methods (for subclasses)
@@ -257,6 +302,15 @@ protected:
      * @param message Message to log
      */
     void log(const char* message);
+
+    /**
+     * @brief Ask for an onUpdate() call ahead of the declared cadence
+     * @param delayMs Delay from now (0 = next loop pass)
+     *
+     * One-off; the regular cadence continues unchanged. Safe to call from
+     * other tasks (e.g. a network callback).
+     */
+    void requestUpdate(uint32_t delayMs = 0);
     
 public:
     // TEMPORARY: For testing without AppManager
@@ -276,6 +330,10 @@ private:
     AppState _state;              // Current state
     uint32_t _startTime;          // When onStart() was called
 
+    // Pending requestUpdate() (taken by AppManager)
+    volatile bool _updateRequested;
+    volatile uint32_t _updateRequestedAt;   // millis() deadline
+
     // Internal lifecycle management (called by AppManager)
     friend class AppManager;
 };
@@ -22,6 +22,22 @@
  *   
  *   // Switch to another app
  *   AppManager::loadApp("weather");  // Auto-unloads clock, loads weather
+ *
+ * App residency (keep-alive):
+ *   Apps that return true from supportsKeepAlive() get their own LVGL
+ *   screen. When another app takes over their display they are paused
+ *   (AppState::PAUSED) and kept in memory instead of destroyed, and
+ *   loading them again is an lv_scr_load() plus onStart(). At most
+ *   APP_KEEP_ALIVE_MAX apps stay resident; the least recently used one
+ *   is destroyed first when that limit is exceeded or free heap drops
+ *   below APP_KEEP_ALIVE_MIN_FREE_HEAP.
+ *
+ * Update cadence:
+ *   Apps that declare getUpdateInterval() are kept in a min-heap of
+ *   deadlines and get onUpdate() only when due (optionally aligned to
+ *   the system clock with alignUpdates()). Apps returning
+ *   UPDATE_EVERY_LOOP are called on every update() as before.
+ *   getNextUpdateDelay() lets the main loop sleep until the next one.
  */
 
 #ifndef DOKI_APP_MANAGER_H
@@ -66,10 +82,42 @@ struct DisplayState {
     DokiApp* currentApp;         // Currently running app
     std::string currentAppId;    // Current app ID
     lv_disp_t* lvglDisplay;      // LVGL display handle
+    lv_obj_t* baseScreen;        // Shared screen for apps without keep-alive
+    lv_obj_t* appScreen;         // Current app's own screen (keep-alive apps), or nullptr
+    uint32_t generation;         // Bumped each time an app starts here (invalidates old deadlines)
+    bool updateDue;              // Picked for onUpdate() in the current update() pass
+    volatile TaskHandle_t callbackTask; // Task inside the app's onUpdate(), or nullptr
+    volatile TaskHandle_t switchTask;   // Task loading/unloading an app here, or nullptr
+    uint8_t switchDepth;         // Nested switches by switchTask (loadApp -> unloadApp)
 
-    DisplayState() : displayId(0), currentApp(nullptr), currentAppId(""), lvglDisplay(nullptr) {}
+    DisplayState() : displayId(0), currentApp(nullptr), currentAppId(""), lvglDisplay(nullptr),
+                     baseScreen(nullptr), appScreen(nullptr), generation(0), updateDue(false), callbackTask(nullptr),
+                     switchTask(nullptr), switchDepth(0) {}
     DisplayState(uint8_t id, lv_disp_t* disp)
-        : displayId(id), currentApp(nullptr), currentAppId(""), lvglDisplay(disp) {}
+        : displayId(id), currentApp(nullptr), currentAppId(""), lvglDisplay(disp),
+          baseScreen(nullptr), appScreen(nullptr), generation(0), updateDue(false), callbackTask(nullptr),
+          switchTask(nullptr), switchDepth(0) {}
+};
+
+/**
+ * @brief Scheduled onUpdate() call
+ */
+struct UpdateDeadline {
+    uint32_t due;                // millis() when the call is due
+    uint32_t generation;         // DisplayState::generation it was scheduled for
+    uint8_t displayId;           // Display whose current app is called
+    bool periodic;               // Reschedules itself; false for requestUpdate()
+};
+
+/**
+ * @brief Paused app kept in memory with its screen
+ */
+struct ResidentApp {
+    uint8_t displayId;           // Display the app was created on
+    std::string appId;           // App ID
+    DokiApp* app;                // Paused app instance
+    lv_obj_t* screen;            // App's own screen (not shown)
+    uint32_t lastUsed;           // millis() when it was paused (LRU order)
 };
 
 /**
@@ -146,7 +194,8 @@ public:
      * @brief Update all running apps
      *
      * Call this in loop() to update all running apps across all displays.
-     * Calls each app's onUpdate() method.
+     * Calls onUpdate() of every app that updates each loop, then of the
+     * apps whose deadline has passed.
      *
      * Example:
      *   void loop() {
@@ -154,6 +203,14 @@ public:
      *   }
      */
     static void update();
+
+    /**
+     * @brief Get time until update() has work to do
+     *
+     * @return Milliseconds until the next deadline (0 if an app updates
+     *         every loop or one is already due, UINT32_MAX if none)
+     */
+    static uint32_t getNextUpdateDelay();
     
     /**
      * @brief Get app running on a specific display
@@ -232,6 +289,11 @@ public:
      */
     static uint8_t getDisplayIdForApp(DokiApp* app);
 
+    /**
+     * @brief Get number of paused apps kept in memory (all displays)
+     */
+    static uint8_t getResidentCount();
+
     /**
      * @brief Unregister all apps (for testing/cleanup)
      */
@@ -250,12 +312,54 @@ private:
     // App registry (maps app ID to registration info)
     static std::map<std::string, AppRegistration> _registry;
 
+    // Paused keep-alive apps, oldest first
+    static std::vector<ResidentApp> _resident;
+
+    // Pending onUpdate() deadlines (min-heap on due)
+    static std::vector<UpdateDeadline> _deadlines;
+
     // Helper: Find app registration
     static AppRegistration* _findRegistration(const char* appId);
 
     // Helper: Perform full app cleanup (after app deletion)
     static void _cleanupApp(uint8_t displayId, const char* appId);
 
+    // Helper: Call onSaveState() and persist the result
+    static void _saveAppState(DokiApp* app, const char* appId);
+
+    // Helper: Pause the current app of a display and keep it resident
+    static void _park(uint8_t displayId);
+
+    // Helper: Make a resident app (already taken out of _resident) current again
+    static void _resume(uint8_t displayId, const ResidentApp& entry);
+
+    // Helper: Destroy a resident app and its screen (removes it from _resident)
+    static void _evict(size_t index);
+
+    // Helper: Evict least recently used apps over the count / heap limits
+    static void _trimResident();
+
+    // Helper: Find a resident app (-1 if not resident)
+    static int _findResident(uint8_t displayId, const char* appId);
+
+    // Helper: Claim a display for a load/unload (waits out another task's
+    // onUpdate() or switch; update() skips the display until _endSwitch())
+    static void _beginSwitch(uint8_t displayId);
+    static void _endSwitch(uint8_t displayId);
+
+    // Helper: loadApp()/unloadApp() once the display is claimed
+    static bool _loadApp(uint8_t displayId, const char* appId, AppRegistration* reg);
+    static bool _unloadApp(uint8_t displayId);
+
+    // Helper: Start the update cadence of a display's new current app
+    static void _beginUpdates(uint8_t displayId);
+
+    // Helper: Add a deadline to the heap
+    static void _schedule(uint8_t displayId, uint32_t due, bool periodic);
+
+    // Helper: Next periodic deadline of an app after one at 'previous'
+    static uint32_t _nextDeadline(DokiApp* app, uint32_t previous, uint32_t now);
+
     // Helper: Validate display ID
     static bool _isValidDisplay(uint8_t displayId);
 };
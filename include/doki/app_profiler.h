@@ -0,0 +1,119 @@
+/**
+ * @file app_profiler.h
+ * @brief Per-app latency breakdown of app loads and unloads
+ *
+ * AppManager times each phase of a switch (factory, screen clean,
+ * onCreate, state load/restore, onStart, the save on unload, ...) and
+ * the time from the start of a load to the first completed refresh of
+ * the display. Every phase feeds a per-app histogram with power-of-two
+ * buckets from 250 us up, served by GET /api/perf (DELETE resets it).
+ *
+ * Tables live in PSRAM; record() is cheap enough to stay enabled in
+ * release builds.
+ */
+
+#ifndef DOKI_APP_PROFILER_H
+#define DOKI_APP_PROFILER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "hardware_config.h"
+
+namespace Doki {
+
+class AppProfiler {
+public:
+    /**
+     * @brief Timed phases of an app switch
+     */
+    enum Phase : uint8_t {
+        PHASE_FACTORY,           // App constructor (registration factory)
+        PHASE_CLEAN,             // lv_obj_clean of the shared screen, or a new keep-alive screen
+        PHASE_ON_CREATE,         // onCreate()
+        PHASE_LOAD_STATE,        // StatePersistence::loadState()
+        PHASE_RESTORE_STATE,     // onRestoreState()
+        PHASE_ON_START,          // onStart()
+        PHASE_LOAD,              // Whole loadApp(), including unloading the previous app
+        PHASE_RESUME,            // Whole loadApp() of a resident (keep-alive) app
+        PHASE_FIRST_FRAME,       // Start of loadApp() until the first completed refresh
+        PHASE_ON_PAUSE,          // onPause()
+        PHASE_SAVE_STATE,        // onSaveState() + StatePersistence::saveState()
+        PHASE_ON_DESTROY,        // onDestroy() and deleting the app
+        PHASE_UNLOAD,            // Whole unloadApp() or eviction
+        PHASE_COUNT
+    };
+
+    /**
+     * @brief Allocate the tables (call once at boot)
+     */
+    static bool init();
+
+    /**
+     * @brief Add one measurement
+     * @param appId App the phase belonged to
+     * @param phase Phase measured
+     * @param us Duration in microseconds
+     */
+    static void record(const char* appId, Phase phase, uint32_t us);
+
+    /**
+     * @brief Wait for the next refresh of a display after a load
+     * @param displayId Display the app was loaded on
+     * @param appId App that was loaded
+     * @param startUs micros() when the load started
+     */
+    static void expectFrame(uint8_t displayId, const char* appId, uint32_t startUs);
+
+    /**
+     * @brief Note a completed refresh (LVGL monitor callback)
+     *
+     * Records PHASE_FIRST_FRAME if a load on this display is waiting for it.
+     */
+    static void frameDone(uint8_t displayId);
+
+    /**
+     * @brief Clear all histograms
+     */
+    static void reset();
+
+    /**
+     * @brief Write every app's histograms
+     * @param out Object receiving "bucketsUs" and an "apps" object
+     */
+    static void toJson(JsonObject out);
+
+private:
+    struct PhaseStat {
+        uint32_t count;
+        uint32_t maxUs;
+        uint64_t totalUs;
+        uint16_t buckets[APP_PROFILER_BUCKETS];
+    };
+
+    struct AppStat {
+        char app[MAX_APP_NAME_LENGTH];
+        PhaseStat phases[PHASE_COUNT];
+    };
+
+    struct PendingFrame {
+        bool active;
+        uint32_t startUs;
+        char app[MAX_APP_NAME_LENGTH];
+    };
+
+    static AppStat* _apps;
+    static uint16_t _appCount;
+    static PendingFrame _pending[DISPLAY_COUNT];
+    static SemaphoreHandle_t _mutex;
+
+    static AppStat* _findOrAdd(const char* appId);
+    static uint8_t _bucketFor(uint32_t us);
+    static uint32_t _bucketLimit(uint8_t bucket);
+    static uint32_t _percentile(const PhaseStat& stat, uint8_t percent);
+};
+
+} // namespace Doki
+
+#endif // DOKI_APP_PROFILER_H
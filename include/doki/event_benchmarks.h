@@ -0,0 +1,32 @@
+/**
+ * @file event_benchmarks.h
+ * @brief Publish latency and throughput of the event bus
+ *
+ * Compiled only with -DDOKI_EVENT_BENCHMARKS (build_flags in platformio.ini).
+ * Results are written to the log at boot, right after EventSystem::init().
+ */
+
+#ifndef DOKI_EVENT_BENCHMARKS_H
+#define DOKI_EVENT_BENCHMARKS_H
+
+#include <Arduino.h>
+
+namespace Doki {
+
+class EventBenchmarks {
+public:
+    /**
+     * @brief Measure publish cost on the owning task and through the queue
+     *
+     * Direct: publish() on the owning task with 0, 1 and 4 subscribers,
+     * reported as ns per publish and publishes per second.
+     * Queued: a task on the other core publishes in bursts while the
+     * owner dispatches; reports throughput, publish cost on the producer
+     * and publish-to-callback latency (avg / max), plus drops.
+     */
+    static void run();
+};
+
+} // namespace Doki
+
+#endif // DOKI_EVENT_BENCHMARKS_H
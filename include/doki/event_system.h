@@ -5,20 +5,31 @@
  * The Event System allows components to communicate without tight coupling.
  * Components can publish events and subscribe to events they care about.
  * 
+ * Callbacks always run on the owning task (the one that called init(), the
+ * Arduino loop task). A publish on that task dispatches right away; from any
+ * other task or an ISR the event goes into a lock-free queue and is
+ * dispatched by the next dispatch() call in the main loop. Payloads are
+ * copied by value, so they stay valid however late that is.
+ * 
  * Example:
  *   // Subscribe to WiFi events
- *   EventSystem::subscribe(EVENT_WIFI_CONNECTED, onWiFiConnected);
+ *   EventSystem::subscribe(EventType::WIFI_CONNECTED, onWiFiConnected);
  *   
  *   // Publish an event
- *   EventSystem::publish(EVENT_WIFI_CONNECTED);
+ *   EventSystem::publish(EventType::WIFI_CONNECTED, "WiFiManager");
+ *   EventSystem::publish(EventType::APP_LOADED, "AppManager", EventPayload::fromText(appId));
  */
 
 #ifndef DOKI_EVENT_SYSTEM_H
 #define DOKI_EVENT_SYSTEM_H
 
 #include <Arduino.h>
+#include <atomic>
 #include <functional>
 #include <vector>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "hardware_config.h"
 
 namespace Doki {
 
@@ -59,6 +70,54 @@ enum class EventType {
     CUSTOM_EVENT_3
 };
 
+static constexpr size_t EVENT_TYPE_COUNT = (size_t)EventType::CUSTOM_EVENT_3 + 1;
+
+/**
+ * @brief Small event payload, copied by value
+ */
+struct EventPayload {
+    enum class Kind : uint8_t {
+        NONE,
+        INT,
+        FLOAT,
+        TEXT                  // Truncated to EVENT_PAYLOAD_TEXT_MAX - 1 characters
+    };
+
+    Kind kind;
+    union {
+        int32_t i;
+        float f;
+        char text[EVENT_PAYLOAD_TEXT_MAX];
+    };
+
+    EventPayload() : kind(Kind::NONE), i(0) {}
+
+    static EventPayload fromInt(int32_t value) {
+        EventPayload p;
+        p.kind = Kind::INT;
+        p.i = value;
+        return p;
+    }
+
+    static EventPayload fromFloat(float value) {
+        EventPayload p;
+        p.kind = Kind::FLOAT;
+        p.f = value;
+        return p;
+    }
+
+    static EventPayload fromText(const char* value) {
+        EventPayload p;
+        p.kind = Kind::TEXT;
+        snprintf(p.text, sizeof(p.text), "%s", value ? value : "");
+        return p;
+    }
+
+    int32_t asInt() const { return kind == Kind::INT ? i : 0; }
+    float asFloat() const { return kind == Kind::FLOAT ? f : 0.0f; }
+    const char* asText() const { return kind == Kind::TEXT ? text : ""; }
+};
+
 /**
  * @brief Event data structure
  * 
@@ -66,12 +125,13 @@ enum class EventType {
  */
 struct Event {
     EventType type;           // Type of event
-    const char* source;       // Component that published the event
-    void* data;               // Optional event data (can be nullptr)
+    const char* source;       // Component that published the event (string literal)
+    EventPayload payload;     // Optional event data (Kind::NONE if none)
     uint32_t timestamp;       // When event was published (millis())
     
-    Event(EventType t, const char* src, void* d = nullptr)
-        : type(t), source(src), data(d), timestamp(millis()) {}
+    Event() : type(EventType::SYSTEM_ERROR), source(""), timestamp(0) {}
+    Event(EventType t, const char* src, const EventPayload& p = EventPayload())
+        : type(t), source(src), payload(p), timestamp(millis()) {}
 };
 
 /**
@@ -88,6 +148,11 @@ using EventCallback = std::function<void(const Event&)>;
  */
 class EventSystem {
 public:
+    /**
+     * @brief Make the calling task the owner (call once from setup())
+     */
+    static void init();
+
     /**
      * @brief Subscribe to an event type
      * 
@@ -95,8 +160,10 @@ public:
      * @param callback Function to call when event occurs
      * @return Subscription ID (use to unsubscribe later)
      * 
+     * Owning task only.
+     * 
      * Example:
-     *   int id = EventSystem::subscribe(EVENT_WIFI_CONNECTED, [](const Event& e) {
+     *   int id = EventSystem::subscribe(EventType::WIFI_CONNECTED, [](const Event& e) {
      *       Serial.println("WiFi connected!");
      *   });
      */
@@ -107,6 +174,8 @@ public:
      * 
      * @param subscriptionId ID returned from subscribe()
      * 
+     * Owning task only; safe from inside a callback.
+     * 
      * Example:
      *   EventSystem::unsubscribe(id);
      */
@@ -117,13 +186,27 @@ public:
      * 
      * @param type Event type
      * @param source Component publishing the event (e.g., "WiFiManager")
-     * @param data Optional event data (default: nullptr)
+     * @param payload Optional event data, copied
+     * @return false if the event was queued and the queue was full
+     * 
+     * Safe from any task and from ISRs. Never allocates.
      * 
      * Example:
-     *   EventSystem::publish(EVENT_WIFI_CONNECTED, "WiFiManager");
-     *   EventSystem::publish(EVENT_APP_LOADED, "AppManager", (void*)appName);
+     *   EventSystem::publish(EventType::WIFI_CONNECTED, "WiFiManager");
+     *   EventSystem::publish(EventType::APP_LOADED, "AppManager", EventPayload::fromText(appName));
      */
-    static void publish(EventType type, const char* source, void* data = nullptr);
+    static bool publish(EventType type, const char* source, const EventPayload& payload = EventPayload());
+
+    /**
+     * @brief Dispatch events queued by other tasks (call from the main loop)
+     * @return Number of events dispatched
+     */
+    static uint32_t dispatch();
+
+    /**
+     * @brief Get number of events dropped because the queue was full
+     */
+    static uint32_t getDroppedCount() { return _dropped.load(std::memory_order_relaxed); }
     
     /**
      * @brief Get number of subscribers for an event type
@@ -160,12 +243,32 @@ private:
             : id(i), type(t), callback(cb), active(true) {}
     };
     
+    /**
+     * @brief Queue slot (bounded MPSC queue, sequence per slot)
+     */
+    struct Slot {
+        std::atomic<uint32_t> sequence;
+        Event event;
+    };
+    
     // Static members
-    static std::vector<Subscription> _subscriptions;  // All active subscriptions
+    static std::vector<Subscription> _subscribers[EVENT_TYPE_COUNT];  // Per event type
+    static std::vector<Subscription> _added;          // Subscribed during a dispatch
     static int _nextSubscriptionId;                   // Counter for unique IDs
+    static uint8_t _dispatchDepth;                    // Callbacks currently running
+    static bool _needsCompact;                        // Inactive entries to remove
+    static TaskHandle_t _owner;                       // Task that runs callbacks
+    
+    static Slot _queue[EVENT_QUEUE_SIZE];
+    static std::atomic<uint32_t> _enqueuePos;
+    static uint32_t _dequeuePos;                      // Owner task only
+    static std::atomic<uint32_t> _dropped;
     
     // Helper methods
-    static std::vector<Subscription*> _getSubscribers(EventType type);
+    static bool _enqueue(const Event& event);
+    static bool _dequeue(Event& event);
+    static void _deliver(const Event& event);
+    static void _compact();
 };
 
 } // namespace Doki
@@ -46,8 +46,11 @@ public:
      * @param id App unique ID (e.g., "hello_js")
      * @param name App display name (e.g., "Hello JS")
      * @param scriptPath Path to JavaScript file in SPIFFS (e.g., "/apps/hello.js")
+     * @param trusted Run in the shared JS heap when built with -DDOKI_JS_SHARED_HEAP
+     *                (bundled apps only: apps in one heap are not isolated from
+     *                each other's memory use or GC pauses)
      */
-    JSApp(const char* id, const char* name, const char* scriptPath);
+    JSApp(const char* id, const char* name, const char* scriptPath, bool trusted = false);
 
     /**
      * @brief Destructor
@@ -65,11 +68,22 @@ public:
     void onSaveState(JsonDocument& state) override;
     void onRestoreState(const JsonDocument& state) override;
 
+    // Reports JS CPU time, throttling and timeouts
+    void getRuntimeStats(JsonObject stats) override;
+
+    // Paused scripts keep their context; onStart()/onPause() reach JS again
+    bool supportsKeepAlive() const override { return true; }
+
 protected:
     String _scriptPath;          ///< Path to JS file
     void* _jsContext;            ///< Duktape context
+    bool _trusted;               ///< May share a heap with other trusted apps
     bool _scriptLoaded;          ///< Script loaded successfully
     uint32_t _lastUpdate;        ///< Last update time (for throttling)
+    uint32_t _updateInterval;    ///< Current onUpdate() interval (grows when throttled)
+    uint32_t _budgetWindowSeq;   ///< Last budget window acted on
+    uint32_t _lastDispatch;      ///< Last time any JS callback ran
+    uint32_t _lastFrame;         ///< Last requestAnimationFrame dispatch
     static const uint32_t UPDATE_INTERVAL = 100;  ///< Update every 100ms
 
     /**
@@ -77,6 +91,37 @@ protected:
      * @param message Error message
      */
     void _showError(const char* message);
+
+    /**
+     * @brief Throttle or terminate the script based on its CPU budget
+     * @return false if the script was terminated
+     */
+    bool _enforceBudget();
+
+    /**
+     * @brief Run a JS garbage collection if the app has idle slack
+     * @param now Current millis()
+     *
+     * Only collects after enough allocations, and only if the previous
+     * pause fits before the app's next frame, onUpdate() or timer.
+     */
+    void _collectIdleGarbage(uint32_t now);
+
+    /**
+     * @brief Give the JS context back (shared heap or context pool)
+     */
+    void _releaseContext();
+
+    /**
+     * @brief Get the requestAnimationFrame period (display refresh period)
+     */
+    uint32_t _getFramePeriod();
+
+    /**
+     * @brief Destroy the JS context and replace the UI with an error screen
+     * @param reason Reason shown on screen
+     */
+    void _terminate(const char* reason);
 };
 
 } // namespace Doki
@@ -0,0 +1,45 @@
+/**
+ * @file js_benchmarks.h
+ * @brief Native micro-benchmarks for the JS engine
+ *
+ * Compiled only with -DDOKI_JS_BENCHMARKS (build_flags in platformio.ini).
+ * Results are written to the log at boot, right after JSEngine::init().
+ *
+ * JS-visible costs (binding calls, frame updates) are measured by the
+ * data/apps/binding_bench.js app instead.
+ */
+
+#ifndef DOKI_JS_BENCHMARKS_H
+#define DOKI_JS_BENCHMARKS_H
+
+#include <Arduino.h>
+
+namespace Doki {
+
+class JSBenchmarks {
+public:
+    /**
+     * @brief Compare JSON text round-trips with direct JsonVariant conversion
+     *
+     * Runs on typical app state documents (counter, weather with hourly
+     * forecast, playlist) in both directions:
+     *   json->js  serializeJson + duk_json_decode  vs  JSEngine::pushJson
+     *   js->json  duk_json_encode + deserializeJson  vs  JSEngine::readJson
+     */
+    static void runJsonConversion();
+
+    /**
+     * @brief Measure what one context costs under the current Duktape profile
+     *
+     * Logs heap used and time taken by createContext() (averaged over a
+     * few contexts), plus an integer arithmetic loop. Build once with and
+     * once without -DDOKI_DUK_LOWMEM and compare the two boot logs.
+     * With -DDOKI_JS_SHARED_HEAP it also logs the cost of each additional
+     * app in the shared heap.
+     */
+    static void runContextFootprint();
+};
+
+} // namespace Doki
+
+#endif // DOKI_JS_BENCHMARKS_H
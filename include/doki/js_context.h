@@ -0,0 +1,335 @@
+/**
+ * @file js_context.h
+ * @brief Per-context native state for Duktape JS contexts
+ *
+ * Every JS context owns one JSContextData block, stored as the Duktape
+ * heap userdata when the heap is created. Bindings reach it through
+ * JSEngine::getContextData(ctx), which is a pointer load rather than a
+ * global stash property lookup.
+ *
+ * The handle table maps the numeric IDs returned to JavaScript
+ * (createLabel, createScrollingLabel, ...) to lv_obj_t pointers.
+ * A handle packs a slot index with a generation counter, so an ID that
+ * outlived its object (clearScreen(), or LVGL deleting the object on
+ * its own) resolves to nullptr instead of a dangling pointer.
+ *
+ * Handle layout (32-bit):
+ *   bits  0-15  slot index
+ *   bits 16-31  slot generation (never 0, so handle 0 is always invalid)
+ *
+ * The timer wheel backs setTimeout()/setInterval(). It only stores IDs
+ * and due times; the JS callbacks stay in the context's global stash.
+ *
+ * The message queues carry MQTT/WebSocket messages from the network
+ * callbacks to the JS thread without touching the Duktape heap.
+ */
+
+#ifndef DOKI_JS_CONTEXT_H
+#define DOKI_JS_CONTEXT_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include <atomic>
+#include <vector>
+#include "doki/js_engine.h"
+#include "hardware_config.h"
+
+namespace Doki {
+
+/**
+ * @brief Generation-checked table of LVGL objects owned by a JS context
+ */
+class JSHandleTable {
+public:
+    static constexpr uint32_t INVALID_HANDLE = 0;
+
+    JSHandleTable();
+
+    /**
+     * @brief Destructor - detaches the delete hooks from live objects
+     *
+     * Must run with the LVGL lock held.
+     */
+    ~JSHandleTable();
+
+    /**
+     * @brief Register an LVGL object and return its handle
+     * @param obj Object to track
+     * @return Handle for JavaScript, or INVALID_HANDLE if the table is full
+     */
+    uint32_t add(lv_obj_t* obj);
+
+    /**
+     * @brief Resolve a handle to its object
+     * @param handle Handle previously returned by add()
+     * @return Object pointer, or nullptr if the handle is unknown or stale
+     */
+    inline lv_obj_t* resolve(uint32_t handle) const {
+        uint32_t index = handle & 0xFFFF;
+        if (index >= _slots.size()) return nullptr;
+        const Slot& slot = _slots[index];
+        return (slot.generation == (handle >> 16)) ? slot.obj : nullptr;
+    }
+
+    /**
+     * @brief Invalidate every handle (objects are not deleted)
+     */
+    void clear();
+
+    /**
+     * @brief Get number of live handles
+     */
+    size_t size() const { return _live; }
+
+private:
+    struct Slot {
+        lv_obj_t* obj;           // nullptr when the slot is free
+        uint16_t generation;     // Bumped every time the slot is released
+    };
+
+    std::vector<Slot> _slots;
+    std::vector<uint16_t> _freeList;
+    size_t _live;
+
+    void _release(uint16_t index, bool detachHook);
+
+    // LV_EVENT_DELETE hook - user data is the owning table
+    static void _onObjectDeleted(lv_event_t* e);
+};
+
+/**
+ * @brief Hashed timer wheel for one JS context
+ *
+ * Timers hash into SLOTS buckets by due tick (TICK_MS resolution).
+ * advance() only visits the buckets for ticks that have elapsed since
+ * the previous call, so an idle wheel costs almost nothing per frame.
+ */
+class JSTimerWheel {
+public:
+    static constexpr uint32_t SLOTS = 64;
+    static constexpr uint32_t TICK_MS = 10;
+
+    /**
+     * @brief A timer that came due in advance()
+     */
+    struct Fired {
+        uint32_t id;
+        bool periodic;           // Still armed (setInterval)
+    };
+
+    JSTimerWheel();
+
+    /**
+     * @brief Arm a timer
+     * @param delayMs Delay before the first run
+     * @param intervalMs Repeat interval, 0 for a one-shot timer
+     * @param now Current millis()
+     * @return Timer ID (never 0)
+     */
+    uint32_t add(uint32_t delayMs, uint32_t intervalMs, uint32_t now);
+
+    /**
+     * @brief Disarm a timer
+     * @return true if the timer was armed
+     */
+    bool cancel(uint32_t id);
+
+    /**
+     * @brief Collect timers due at `now`
+     *
+     * One-shot timers are removed, periodic timers are re-armed before
+     * this returns, so callbacks may safely cancel them.
+     */
+    void advance(uint32_t now, std::vector<Fired>& fired);
+
+    /**
+     * @brief Milliseconds until the next timer is due
+     * @return 0 if one is already due, UINT32_MAX if none are armed
+     */
+    uint32_t nextDelay(uint32_t now) const;
+
+    /**
+     * @brief Get number of armed timers
+     */
+    size_t size() const { return _count; }
+
+private:
+    struct Timer {
+        uint32_t id;
+        uint32_t due;            // millis() when due
+        uint32_t interval;       // 0 = one-shot
+    };
+
+    std::vector<Timer> _slots[SLOTS];
+    uint32_t _lastTick;          // Tick processed by the previous advance()
+    uint32_t _nextId;
+    size_t _count;
+
+    void _insert(const Timer& timer);
+};
+
+/**
+ * @brief Bounded single-producer/single-consumer message ring
+ *
+ * One network callback pushes, the JS thread pops. Slots are allocated
+ * once by open() and push() only copies into them, so the producer may
+ * run on another core. A full ring drops the new message and counts it.
+ */
+class JSMessageQueue {
+public:
+    struct Message {
+        uint16_t topicLength;
+        uint16_t length;
+        bool truncated;                          // Payload was cut to fit
+        char topic[JS_MESSAGE_MAX_TOPIC];
+        char payload[JS_MESSAGE_MAX_PAYLOAD];
+    };
+
+    JSMessageQueue();
+    ~JSMessageQueue();
+
+    /**
+     * @brief Allocate the slots (before a producer is attached)
+     * @return true if the queue is ready
+     */
+    bool open();
+
+    bool isOpen() const { return _slots != nullptr; }
+
+    /**
+     * @brief Copy a message into the next free slot (producer only)
+     * @param topic Topic string, or nullptr
+     * @param payload Payload bytes (need not be terminated)
+     * @param length Payload length
+     * @return false if the queue is full or not open (message dropped)
+     */
+    bool push(const char* topic, const uint8_t* payload, size_t length);
+
+    /**
+     * @brief Oldest queued message (consumer only)
+     * @return nullptr if the queue is empty
+     */
+    const Message* front() const;
+
+    /**
+     * @brief Release the slot returned by front() (consumer only)
+     */
+    void pop();
+
+    size_t size() const;
+    uint32_t getReceived() const { return _received.load(std::memory_order_relaxed); }
+    uint32_t getDropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+private:
+    Message* _slots;
+    std::atomic<uint32_t> _head;             // Messages pushed (producer)
+    std::atomic<uint32_t> _tail;             // Messages popped (consumer)
+    std::atomic<uint32_t> _received;
+    std::atomic<uint32_t> _dropped;
+};
+
+/**
+ * @brief Pixel buffer behind a createCanvas() canvas
+ *
+ * The buffer belongs to the context rather than the lv_canvas: the
+ * Uint16Array handed to JavaScript aliases it, so it must outlive every
+ * JS reference. Once the lv_canvas is gone (clearScreen) and no array is
+ * left, the buffer is freed; the rest go together with the context.
+ */
+struct JSCanvas {
+    uint32_t handle;             // Handle of the lv_canvas object
+    uint16_t* pixels;            // RGB565, width * height
+    uint16_t width;
+    uint16_t height;
+    uint16_t jsRefs;             // Uint16Arrays not yet finalized
+};
+
+struct JSContextData;
+
+/**
+ * @brief Apps living in one shared Duktape heap (-DDOKI_JS_SHARED_HEAP)
+ *
+ * Hangs off the JSContextData that is the heap userdata; that block then
+ * only carries the heap-wide GC counters. Each app runs in its own
+ * thread with a fresh global environment and has its own JSContextData.
+ */
+struct JSSharedApps {
+    JSContextData* apps[JS_SHARED_HEAP_MAX_APPS];  // nullptr = free slot
+    JSContextData* running;      // App in a top-level call (for the timeout hook)
+    uint32_t heapBytes;          // Free heap taken by creating the heap itself
+    uint8_t count;
+
+    JSSharedApps() : apps(), running(nullptr), heapBytes(0), count(0) {}
+
+    /**
+     * @brief Find the app a Duktape thread belongs to
+     *
+     * Threads the script created itself (coroutines) are not registered;
+     * they can only run inside a top-level call, so fall back to the
+     * app that made it.
+     */
+    JSContextData* find(duk_context* ctx) const;
+};
+
+/**
+ * @brief Native state attached to one Duktape heap
+ *
+ * In a shared heap there is one block per app thread, plus the one
+ * stored as the heap userdata (see JSSharedApps).
+ */
+struct JSContextData {
+    uint8_t displayId;           // Display this context renders on
+    duk_context* thread;         // Own thread in a shared heap, nullptr for a private heap
+    JSSharedApps* shared;        // Set on a shared heap's userdata only
+    lv_obj_t* screen;            // Screen of that display
+    JSHandleTable handles;       // LVGL objects exposed to JS
+
+    // Execution deadline (checked from Duktape's interrupt hook)
+    uint8_t callDepth;           // Nesting of timed calls, 0 = idle
+    bool timedOut;               // Current/last call hit the deadline
+    uint32_t deadline;           // millis() deadline of the running call
+    uint32_t callStartUs;        // micros() when the running call started
+    uint32_t blockedUs;          // Time the running call spent waiting in blocking bindings
+    JSExecStats exec;            // CPU accounting
+    JSGcStats gc;                // Idle / emergency GC accounting
+
+    // Lifecycle functions (kept reachable by the stash __lifecycle array)
+    void* lifecycle[(uint8_t)JSLifecycle::COUNT];  // Duktape heap pointers, nullptr = undefined
+    uint8_t lifecycleGuarded;    // Bit set if the global is trapped by an accessor
+
+    // Timers (callbacks live in the stash under __timers / __raf)
+    JSTimerWheel timers;                 // setTimeout / setInterval
+    std::vector<uint32_t> frameRequests; // Pending requestAnimationFrame IDs
+    uint32_t nextFrameId;
+
+    // Network inboxes (callbacks live in the stash under __mqtt_cb / __ws_cb)
+    JSMessageQueue mqttInbox;
+    JSMessageQueue wsInbox;
+
+    // Async httpGet() (callbacks live in the stash under __http)
+    uint8_t httpPending;         // Requests submitted but not yet delivered
+
+    // createCanvas() pixel buffers (freed after the heap is destroyed)
+    std::vector<JSCanvas> canvases;
+
+    // saveState()/loadState() keys, one record per app (read on first use)
+    String stateRecord;          // "<appId>.kv", empty until setAppId()
+    JsonDocument kvState;
+    bool kvLoaded;
+
+    JSContextData()
+        : displayId(0), thread(nullptr), shared(nullptr), screen(nullptr),
+          callDepth(0), timedOut(false), deadline(0), callStartUs(0), blockedUs(0), exec(), gc(),
+          lifecycle(), lifecycleGuarded(0), nextFrameId(1), httpPending(0), kvLoaded(false) {}
+
+    ~JSContextData() {
+        for (JSCanvas& canvas : canvases) {
+            free(canvas.pixels);
+        }
+        delete shared;
+    }
+};
+
+} // namespace Doki
+
+#endif // DOKI_JS_CONTEXT_H
@@ -0,0 +1,81 @@
+/**
+ * @file js_context_pool.h
+ * @brief Warm pool of pre-built JS contexts for fast app switching
+ *
+ * Creating a Duktape heap and registering every Doki binding takes a
+ * noticeable slice of an app switch. A background task on core 0 keeps
+ * JS_CONTEXT_POOL_SIZE contexts ready, so JSApp::onCreate() only has to
+ * evaluate the script and run onCreate().
+ *
+ * Contexts handed back with release() are detached from LVGL and network
+ * callbacks on the caller's thread and destroyed by the background task.
+ *
+ * With -DDOKI_JS_SHARED_HEAP only untrusted apps get a private heap, so
+ * nothing is pre-built: acquire() creates the context and the task only
+ * tears down released ones.
+ *
+ * Usage:
+ *   JSContextPool::init();                 // Once, after JSEngine::init()
+ *   void* ctx = JSContextPool::acquire();  // Falls back to createContext()
+ *   ...
+ *   JSContextPool::release(ctx);
+ */
+
+#ifndef DOKI_JS_CONTEXT_POOL_H
+#define DOKI_JS_CONTEXT_POOL_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+namespace Doki {
+
+class JSContextPool {
+public:
+    /**
+     * @brief Start the pool task and begin pre-building contexts
+     * @return true if initialized successfully
+     */
+    static bool init();
+
+    /**
+     * @brief Take a ready context
+     * @return Context with all bindings registered, or nullptr on failure
+     *
+     * Never blocks on the pool: if no warm context is ready, one is
+     * created synchronously.
+     */
+    static void* acquire();
+
+    /**
+     * @brief Hand a context back for asynchronous destruction
+     * @param ctx Context from acquire() (nullptr is ignored)
+     */
+    static void release(void* ctx);
+
+    /**
+     * @brief Get number of warm contexts ready to be claimed
+     */
+    static uint32_t getReadyCount();
+
+    /**
+     * @brief Get number of acquire() calls served from the pool / total
+     */
+    static uint32_t getHits() { return _hits; }
+    static uint32_t getMisses() { return _misses; }
+
+private:
+    static QueueHandle_t _ready;        // Warm contexts
+    static QueueHandle_t _retired;      // Contexts waiting to be destroyed
+    static TaskHandle_t _task;
+    static uint32_t _hits;
+    static uint32_t _misses;
+
+    static void _poolTask(void* param);
+    static void _deleteQueues();
+};
+
+} // namespace Doki
+
+#endif // DOKI_JS_CONTEXT_POOL_H
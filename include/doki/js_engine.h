@@ -25,6 +25,8 @@
 
 #include <Arduino.h>
 #include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 
 // JavaScript support - ENABLED with proper duk_config.h from Duktape 2.7.0
 #define ENABLE_JAVASCRIPT_SUPPORT
@@ -36,6 +38,67 @@
 
 namespace Doki {
 
+struct JSContextData;
+
+/**
+ * @brief App lifecycle callbacks, resolved once per script evaluation
+ */
+enum class JSLifecycle : uint8_t {
+    ON_CREATE,
+    ON_START,
+    ON_UPDATE,
+    ON_PAUSE,
+    ON_DESTROY,
+    ON_SAVE_STATE,
+    ON_RESTORE_STATE,
+    COUNT
+};
+
+/**
+ * @brief JS execution time accounting for one context
+ *
+ * Only top-level calls from C++ (script load, lifecycle callbacks) are
+ * timed; work done inside them, including native bindings, is included.
+ */
+struct JSExecStats {
+    uint64_t totalUs;            // JS time since context creation
+    uint32_t calls;              // Top-level calls timed
+    uint32_t lastCallUs;         // Duration of the most recent call
+    uint32_t maxCallUs;          // Longest single call
+    uint32_t windowStart;        // millis() when the current budget window started
+    uint32_t windowUs;           // JS time in the current window
+    uint32_t lastWindowUs;       // JS time in the previous window
+    uint32_t windowSeq;          // Number of completed windows
+    uint16_t overBudgetWindows;  // Consecutive windows over JS_BUDGET_PERCENT
+    uint16_t timeouts;           // Calls aborted at TIMEOUT_JS_EXECUTION_MS
+};
+
+/**
+ * @brief Network message counters for one JS context
+ */
+struct JSMessageStats {
+    uint32_t mqttReceived;       // Messages queued for JS
+    uint32_t mqttDropped;        // Messages lost to a full queue
+    uint32_t wsReceived;
+    uint32_t wsDropped;
+};
+
+/**
+ * @brief Garbage collection counters for one JS context
+ *
+ * Duktape frees most garbage by reference counting; mark-and-sweep only
+ * runs for cycles. JSApp triggers it during idle slack (idle GCs) so the
+ * allocation-triggered collection rarely lands inside a frame.
+ */
+struct JSGcStats {
+    uint32_t idleRuns;           // Collections run by collectGarbage()
+    uint32_t idleTotalUs;        // Time spent in them
+    uint32_t lastPauseUs;        // Duration of the most recent one
+    uint32_t maxPauseUs;         // Longest one
+    uint32_t emergency;          // Failed allocations, each forcing an emergency GC
+    uint32_t allocsSinceGc;      // Allocations since the last idle GC
+};
+
 /**
  * @brief JavaScript execution context
  *
@@ -61,6 +124,53 @@ public:
      */
     static void destroyContext(void* ctx);
 
+    /**
+     * @brief Destroy a context that detachContext() already released
+     * @param ctx Context to destroy
+     *
+     * Touches neither LVGL nor the network clients, so it may run on any
+     * task (the context pool destroys retired contexts on core 0).
+     */
+    static void destroyDetachedContext(void* ctx);
+
+#if defined(DOKI_JS_SHARED_HEAP) && defined(ENABLE_JAVASCRIPT_SUPPORT)
+    /**
+     * @brief Create a context for a trusted app inside the shared heap
+     * @return Context (a Duktape thread with its own global environment),
+     *         or nullptr if the heap is full or out of memory
+     *
+     * All apps in the shared heap have separate globals and stashes but
+     * share the heap, its interned strings and its garbage collector.
+     * The heap is created on first use and kept for later apps. Must
+     * run on the UI loop, like every call into a shared context.
+     */
+    static void* createSharedContext();
+
+    /**
+     * @brief Remove a shared context and free its globals
+     * @param ctx Context from createSharedContext()
+     *
+     * Synchronous and on the caller's thread: the heap is still in use
+     * by other apps, so it cannot go to the context pool's task.
+     */
+    static void destroySharedContext(void* ctx);
+
+    /**
+     * @brief Check if a context lives in the shared heap
+     */
+    static bool isSharedContext(void* ctx);
+#endif
+
+    /**
+     * @brief Detach a context from LVGL objects and network callbacks
+     * @param ctx Context that is about to be handed to another thread
+     *
+     * Must run on the thread that owns the context (normally the UI loop).
+     * Afterwards the heap can be destroyed from any task with
+     * destroyDetachedContext(). destroyContext() calls this itself.
+     */
+    static void detachContext(void* ctx);
+
     /**
      * @brief Load and execute JavaScript file
      *
@@ -98,6 +208,59 @@ public:
      */
     static bool callFunctionWithArgs(void* ctx, const char* funcName, const JsonDocument& args);
 
+    /**
+     * @brief Cache references to the script's lifecycle functions
+     *
+     * Called automatically after every successful executeScript(). The
+     * globals (onCreate, onUpdate, ...) are turned into accessors so a
+     * script that reassigns one at runtime updates the cache too.
+     *
+     * @param ctx JS context
+     */
+    static void resolveLifecycle(void* ctx);
+
+    /**
+     * @brief Push a JSON value onto the context's value stack
+     *
+     * Walks the tree and creates the Duktape values directly, without
+     * serializing to text and parsing it again.
+     *
+     * @param ctx JS context
+     * @param value Value to push (nested deeper than JS_JSON_MAX_DEPTH becomes undefined)
+     */
+    static void pushJson(void* ctx, JsonVariantConst value);
+
+    /**
+     * @brief Convert a JS value on the value stack to JSON
+     *
+     * Follows JSON.stringify(): functions and undefined members are
+     * skipped, NaN/Infinity become null.
+     *
+     * @param ctx JS context
+     * @param index Value stack index of the value
+     * @param out Destination (overwritten)
+     * @return false if conversion threw (e.g. a getter) or nesting exceeded JS_JSON_MAX_DEPTH
+     */
+    static bool readJson(void* ctx, int index, JsonVariant out);
+
+    /**
+     * @brief Check if the script defines a lifecycle function
+     */
+    static bool hasLifecycle(void* ctx, JSLifecycle fn);
+
+    /**
+     * @brief Call a lifecycle function through its cached reference
+     *
+     * @param ctx JS context
+     * @param fn Lifecycle function
+     * @param args Optional JSON argument
+     * @param result Optional output for the return value (left empty if
+     *               the function is not defined or returns nothing)
+     * @return true if the function is not defined or ran successfully
+     */
+    static bool callLifecycle(void* ctx, JSLifecycle fn, const JsonDocument* args = nullptr,
+                              JsonDocument* result = nullptr);
+
     /**
      * @brief Register Doki OS APIs to JS context
      *
@@ -123,6 +286,9 @@ public:
      * - createScrollingLabel(text, x, y, width) - Auto-scrolling text
      * - setTextAlign(id, align) - Set text alignment (0=left, 1=center, 2=right)
      *
+     * Declarative UI:
+     * - createUI(template) - Build a widget tree from an object or a /ui JSON file (returns {id: handle})
+     *
      * Screen Info:
      * - getWidth() - Get screen width
      * - getHeight() - Get screen height
@@ -140,14 +306,23 @@ public:
      * - millis() - Get milliseconds since boot
      * - getTime() - Get real time (returns object with hour, minute, second, day, month, year)
      *
+     * Timers:
+     * - setTimeout(fn, ms) / clearTimeout(id) - One-shot timer
+     * - setInterval(fn, ms) / clearInterval(id) - Repeating timer
+     * - requestAnimationFrame(fn) / cancelAnimationFrame(id) - Run fn(timestamp) on the next display refresh
+     *
      * HTTP:
-     * - httpGet(url) - Fetch data from URL (returns response text or null)
+     * - httpGet(url, callback) - Fetch in the background, returns a request ID (0 if refused);
+     *   callback(body, status) runs from the UI loop, body is null on failure.
+     *   callback may also be the name of a global function
+     * - httpGet(url) - Blocking fetch (returns response text or null), stalls every display
      *
      * Animations:
      * - fadeIn(id, duration) - Fade in animation (ms)
      * - fadeOut(id, duration) - Fade out animation (ms)
      * - moveLabel(id, x, y, duration) - Move with animation (ms)
      * - setOpacity(id, opacity) - Set opacity 0-255
+     * - applyUpdates([{id, text, color, opacity, x, y}, ...]) - Batched label updates
      *
      * Multi-Display:
      * - getDisplayCount() - Get total number of displays
@@ -175,6 +350,13 @@ public:
      */
     static void setDisplayId(void* ctx, uint8_t displayId);
 
+    /**
+     * @brief Set the app that owns a JS context
+     * @param ctx JS context
+     * @param appId App ID; saveState()/loadState() keys are kept per app
+     */
+    static void setAppId(void* ctx, const char* appId);
+
     /**
      * @brief Set display screen pointer for this context
      * @param ctx JS context
@@ -184,9 +366,104 @@ public:
 
     /**
      * @brief Get last error message
-     * @return Error string
+     * @return Copy of the error string (any task may set it)
      */
-    static const char* getLastError();
+    static String getLastError();
+
+    /**
+     * @brief Check if a global function is defined
+     * @param ctx JS context
+     * @param funcName Function name (e.g., "onUpdate")
+     */
+    static bool hasFunction(void* ctx, const char* funcName);
+
+    /**
+     * @brief Run the setTimeout/setInterval callbacks that are due
+     *
+     * Does not enter Duktape at all when nothing is due.
+     *
+     * @param ctx JS context
+     * @param now Current millis()
+     * @return Number of callbacks run
+     */
+    static uint32_t runTimers(void* ctx, uint32_t now);
+
+    /**
+     * @brief Run pending requestAnimationFrame callbacks
+     * @param ctx JS context
+     * @param now Frame timestamp passed to the callbacks
+     * @return Number of callbacks run
+     */
+    static uint32_t runAnimationFrame(void* ctx, uint32_t now);
+
+    /**
+     * @brief Check if requestAnimationFrame callbacks are pending
+     */
+    static bool hasAnimationFrame(void* ctx);
+
+    /**
+     * @brief Poll this context's MQTT/WebSocket clients and deliver queued messages
+     *
+     * Messages are delivered in one batch to the callbacks registered with
+     * mqttSubscribe() / wsOnMessage(). Does not enter Duktape when the
+     * queues are empty.
+     *
+     * @param ctx JS context
+     * @return Number of messages delivered
+     */
+    static uint32_t dispatchMessages(void* ctx);
+
+    /**
+     * @brief Milliseconds until the next timer is due
+     * @return UINT32_MAX if no timers are armed
+     */
+    static uint32_t getNextTimerDelay(void* ctx, uint32_t now);
+
+    /**
+     * @brief Run a full mark-and-sweep now
+     *
+     * Must not be called from inside a JS call. Resets Duktape's
+     * allocation-triggered GC countdown as a side effect.
+     *
+     * @param ctx JS context
+     * @return Pause in microseconds
+     */
+    static uint32_t collectGarbage(void* ctx);
+
+    /**
+     * @brief Get garbage collection statistics for a context
+     * @param ctx JS context
+     * @param stats Output statistics
+     * @return true if ctx is valid
+     */
+    static bool getGcStats(void* ctx, JSGcStats& stats);
+
+    /**
+     * @brief Check if the last top-level call hit the execution deadline
+     * @param ctx JS context
+     * @return true if it was aborted after TIMEOUT_JS_EXECUTION_MS
+     *
+     * Time spent waiting in blocking bindings (legacy httpGet(url),
+     * mqttConnect, mqttPublish, mqttSubscribe, wsConnect) does not count
+     * toward the deadline, nor toward the CPU figures of JSExecStats.
+     */
+    static bool hasTimedOut(void* ctx);
+
+    /**
+     * @brief Get execution time statistics for a context
+     * @param ctx JS context
+     * @param stats Output statistics
+     * @return true if ctx is valid
+     */
+    static bool getExecStats(void* ctx, JSExecStats& stats);
+
+    /**
+     * @brief Get MQTT/WebSocket message counters for a context
+     * @param ctx JS context
+     * @param stats Output statistics
+     * @return true if ctx is valid
+     */
+    static bool getMessageStats(void* ctx, JSMessageStats& stats);
 
     /**
      * @brief Check if JavaScript support is enabled
@@ -194,9 +471,64 @@ public:
      */
     static bool isEnabled();
 
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+    /**
+     * @brief Get the native state attached to a JS context
+     * @param ctx Duktape context created by createContext()
+     * @return Context data (never nullptr for contexts from createContext())
+     */
+    static JSContextData* getContextData(duk_context* ctx);
+#endif
+
 private:
     static bool _initialized;
     static String _lastError;
+    static SemaphoreHandle_t _errorMutex;    // Guards _lastError
+
+    static void _setLastError(const String& error);
+
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+    // Data stored as the heap userdata (the app's own, unless the heap is shared)
+    static JSContextData* _getHeapData(duk_context* ctx);
+
+#ifdef DOKI_JS_SHARED_HEAP
+    static duk_context* _sharedHeap;     // Main thread of the shared heap
+    static JSContextData* _sharedData;   // Its userdata (GC counters, app registry)
+#endif
+
+    // Execution deadline and CPU accounting around top-level calls
+    static void _beginCall(duk_context* ctx);
+    static void _endCall(duk_context* ctx);
+
+    // Around network waits inside bindings: the wait neither runs down the
+    // deadline nor counts as JS time. Nothing between the two may throw
+    static uint32_t _pauseDeadline();
+    static void _resumeDeadline(duk_context* ctx, uint32_t pausedAt);
+
+    // Heap allocators (udata is the JSContextData), counting for JSGcStats
+    static void* _alloc(void* udata, duk_size_t size);
+    static void* _realloc(void* udata, void* ptr, duk_size_t size);
+    static void _free(void* udata, void* ptr);
+
+    // Define a global native function (through the profiler with -DDOKI_JS_PROFILER)
+    static void _bind(duk_context* ctx, const char* name, duk_c_function fn, duk_idx_t nargs);
+#ifdef DOKI_JS_PROFILER
+    static duk_ret_t _js_profiled(duk_context* ctx);
+#endif
+
+    // Timed pcall of the function + nargs on the stack top, pops them
+    static bool _invoke(duk_context* ctx, duk_idx_t nargs, const char* name, JsonDocument* result);
+
+    // Lifecycle cache
+    static const char* const _lifecycleNames[(uint8_t)JSLifecycle::COUNT];
+    static duk_ret_t _installLifecycleTrap(duk_context* ctx, void* udata);
+    static duk_ret_t _js_lifecycleGet(duk_context* ctx);
+    static duk_ret_t _js_lifecycleSet(duk_context* ctx);
+
+    // MQTT/WebSocket ownership
+    static void _detachNetwork(duk_context* ctx);
+    static void _pollNetwork(duk_context* ctx);
+#endif
 
 #ifdef ENABLE_JAVASCRIPT_SUPPORT
     // Duktape API binding functions - Basic
@@ -215,10 +547,19 @@ private:
     static duk_ret_t _js_drawRectangle(duk_context* ctx);
     static duk_ret_t _js_drawCircle(duk_context* ctx);
 
+    // Canvas (pixel buffers shared with JS)
+    static duk_ret_t _js_createCanvas(duk_context* ctx);
+    static duk_ret_t _js_canvasFill(duk_context* ctx);
+    static duk_ret_t _js_canvasBlit(duk_context* ctx);
+    static duk_ret_t _js_invalidate(duk_context* ctx);
+
     // Advanced Text
     static duk_ret_t _js_createScrollingLabel(duk_context* ctx);
     static duk_ret_t _js_setTextAlign(duk_context* ctx);
 
+    // Declarative UI
+    static duk_ret_t _js_createUI(duk_context* ctx);
+
     // Screen Info
     static duk_ret_t _js_getWidth(duk_context* ctx);
     static duk_ret_t _js_getHeight(duk_context* ctx);
@@ -231,20 +572,34 @@ private:
     // State Persistence
     static duk_ret_t _js_saveState(duk_context* ctx);
     static duk_ret_t _js_loadState(duk_context* ctx);
+    static bool _loadKeyValueState(JSContextData* data);  // Reads the app's record once
 
     // Time
     static duk_ret_t _js_millis(duk_context* ctx);
     static duk_ret_t _js_getTime(duk_context* ctx);
 
+    // Timers
+    static duk_ret_t _js_setTimeout(duk_context* ctx);
+    static duk_ret_t _js_setInterval(duk_context* ctx);
+    static duk_ret_t _js_clearTimer(duk_context* ctx);
+    static duk_ret_t _js_requestAnimationFrame(duk_context* ctx);
+    static duk_ret_t _js_cancelAnimationFrame(duk_context* ctx);
+
     // HTTP
     static duk_ret_t _js_httpGet(duk_context* ctx);
 
+    // Modules
+    static duk_ret_t _js_require(duk_context* ctx);
+
     // Animations
     static duk_ret_t _js_fadeIn(duk_context* ctx);
     static duk_ret_t _js_fadeOut(duk_context* ctx);
     static duk_ret_t _js_moveLabel(duk_context* ctx);
     static duk_ret_t _js_setOpacity(duk_context* ctx);
 
+    // Batched updates
+    static duk_ret_t _js_applyUpdates(duk_context* ctx);
+
     // Multi-Display
     static duk_ret_t _js_getDisplayCount(duk_context* ctx);
     static duk_ret_t _js_sendToDisplay(duk_context* ctx);
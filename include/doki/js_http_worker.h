@@ -0,0 +1,106 @@
+/**
+ * @file js_http_worker.h
+ * @brief Background HTTP requests for JS apps
+ *
+ * JS runs under the LVGL lock, so a blocking HTTPClient call inside a
+ * binding freezes every display until the server answers. httpGet(url,
+ * callback) instead submits the request here; JS_HTTP_WORKERS tasks on
+ * core 0 perform it and park the response until the owning context
+ * collects it on its next tick.
+ *
+ * Limits (hardware_config.h):
+ *   JS_HTTP_WORKERS             Requests in flight at once (all apps)
+ *   JS_HTTP_MAX_PENDING         Requests one app may have outstanding
+ *   JS_HTTP_MAX_RESPONSE_BYTES  Larger bodies fail with HTTPC_ERROR_STREAM_WRITE
+ *
+ * Usage:
+ *   uint32_t id = JSHttpWorker::submit(ctx, url);   // UI thread
+ *   ...
+ *   JSHttpWorker::collect(ctx, responses);          // Later tick
+ *   free(response.body);
+ */
+
+#ifndef DOKI_JS_HTTP_WORKER_H
+#define DOKI_JS_HTTP_WORKER_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <vector>
+#include "hardware_config.h"
+
+namespace Doki {
+
+class JSHttpWorker {
+public:
+    /**
+     * @brief A completed request
+     */
+    struct Response {
+        uint32_t id;                // ID returned by submit()
+        int status;                 // HTTP status, or negative HTTPClient error
+        char* body;                 // NUL-terminated body (malloc'd, caller frees), nullptr unless 200
+        size_t length;              // Body length in bytes
+    };
+
+    /**
+     * @brief Start the worker tasks
+     * @return true if initialized successfully
+     */
+    static bool init();
+
+    /**
+     * @brief Queue a GET request
+     * @param owner Context the response belongs to
+     * @param url Full URL
+     * @return Request ID (never 0), or 0 if the owner has too many
+     *         requests outstanding or the queue is full
+     */
+    static uint32_t submit(void* owner, const char* url);
+
+    /**
+     * @brief Take the owner's completed responses
+     * @param owner Context passed to submit()
+     * @param out Vector to append responses to
+     * @return Number of responses appended
+     */
+    static size_t collect(void* owner, std::vector<Response>& out);
+
+    /**
+     * @brief Drop all of the owner's requests
+     *
+     * Queued requests are skipped, in-flight ones are discarded when they
+     * finish. Call before the owner context is destroyed.
+     */
+    static void cancelAll(void* owner);
+
+private:
+    enum class State : uint8_t {
+        QUEUED,
+        RUNNING,
+        DONE
+    };
+
+    struct Request {
+        void* owner;                // nullptr once cancelled
+        uint32_t id;
+        State state;
+        String url;
+        Response response;
+    };
+
+    static std::vector<Request*> _requests;     // Guarded by _mutex
+    static SemaphoreHandle_t _mutex;
+    static QueueHandle_t _queue;                // Request* waiting for a worker
+    static uint32_t _nextId;
+
+    static void _workerTask(void* param);
+    static void _perform(Request* request);
+    static void _free(Request* request);
+};
+
+} // namespace Doki
+
+#endif // DOKI_JS_HTTP_WORKER_H
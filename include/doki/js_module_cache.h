@@ -0,0 +1,110 @@
+/**
+ * @file js_module_cache.h
+ * @brief Boot-wide bytecode cache for require() library modules
+ *
+ * Library modules live in /lib on LittleFS. The first require() of a
+ * module compiles it once and dumps the function to bytecode in PSRAM;
+ * every later context (any app, any display) instantiates it straight
+ * from that bytecode instead of reading and parsing the source again.
+ *
+ * /lib is only written by uploading a new filesystem image, so entries
+ * are never invalidated and stay valid until reboot.
+ *
+ * Usage (from the require() binding):
+ *   JSModuleCache::init();                       // Once, at boot
+ *   String path;
+ *   if (JSModuleCache::resolve("format", path)) {
+ *       JSModuleCache::pushFunction(ctx, path);  // function (exports, require, module)
+ *   }
+ */
+
+#ifndef DOKI_JS_MODULE_CACHE_H
+#define DOKI_JS_MODULE_CACHE_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "doki/js_engine.h"
+#include "hardware_config.h"
+
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+
+namespace Doki {
+
+class JSModuleCache {
+public:
+    /**
+     * @brief Create the cache lock (call once, after JSEngine::init())
+     * @return true if initialized successfully
+     */
+    static bool init();
+
+    /**
+     * @brief Map a require() name to a file under /lib
+     * @param id Module name ("format", "ui/list", "/lib/format.js")
+     * @param path Receives the resolved path
+     * @return true if the module file exists
+     *
+     * ".js" is appended when missing. Results (including misses) are
+     * remembered, so repeated require() calls skip the LittleFS lookup.
+     */
+    static bool resolve(const char* id, String& path);
+
+    /**
+     * @brief Push the module wrapper function onto the value stack
+     * @param ctx Duktape context
+     * @param path Path returned by resolve()
+     * @return true with the function pushed, false with an error pushed
+     *
+     * Loads from cached bytecode when available; otherwise compiles the
+     * source and caches its bytecode for the next context.
+     */
+    static bool pushFunction(duk_context* ctx, const String& path);
+
+    /**
+     * @brief Get number of modules held as bytecode
+     */
+    static uint32_t getModuleCount();
+
+    /**
+     * @brief Get PSRAM used by cached bytecode (bytes)
+     */
+    static size_t getBytes();
+
+    /**
+     * @brief Get number of loads served from bytecode / compiled from source
+     */
+    static uint32_t getHits() { return _hits; }
+    static uint32_t getMisses() { return _misses; }
+
+private:
+    struct Module {
+        String path;
+        uint8_t* bytecode;
+        size_t size;
+    };
+
+    struct PathEntry {
+        String id;
+        String path;        // Empty if the module does not exist
+    };
+
+    static Module _modules[JS_MODULE_CACHE_ENTRIES];
+    static uint32_t _moduleCount;
+    static size_t _bytes;
+    static PathEntry _paths[JS_MODULE_PATH_CACHE_SIZE];
+    static uint32_t _pathNext;
+    static SemaphoreHandle_t _mutex;
+    static uint32_t _hits;
+    static uint32_t _misses;
+
+    static const Module* _find(const String& path);
+    static bool _compile(duk_context* ctx, const String& path);
+    static void _store(const String& path, const void* bytecode, size_t size);
+};
+
+} // namespace Doki
+
+#endif // ENABLE_JAVASCRIPT_SUPPORT
+
+#endif // DOKI_JS_MODULE_CACHE_H
@@ -0,0 +1,127 @@
+/**
+ * @file js_profiler.h
+ * @brief Per-binding and per-callback timing for JS apps
+ *
+ * Compiled only with -DDOKI_JS_PROFILER (build_flags in platformio.ini).
+ * Without it, bindings are registered directly and nothing is measured.
+ *
+ * With it, every native binding is registered through a trampoline that
+ * counts calls and time per display, and each top-level call (onUpdate,
+ * timers, frames, ...) keeps its last JS_PROFILER_SAMPLES durations for
+ * p50/p99. Results are served by GET /api/js/profile, DELETE resets them.
+ *
+ * A binding that throws into JS is not counted.
+ */
+
+#ifndef DOKI_JS_PROFILER_H
+#define DOKI_JS_PROFILER_H
+
+#include "doki/js_engine.h"
+
+#if defined(DOKI_JS_PROFILER) && defined(ENABLE_JAVASCRIPT_SUPPORT)
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "hardware_config.h"
+
+namespace Doki {
+
+class JSProfiler {
+public:
+    /**
+     * @brief Kinds of top-level calls: JSLifecycle values, then these
+     */
+    enum Call : uint8_t {
+        CALL_SCRIPT = (uint8_t)JSLifecycle::COUNT,  // Script evaluation
+        CALL_TIMERS,                                // setTimeout/setInterval batch
+        CALL_FRAME,                                 // requestAnimationFrame batch
+        CALL_MESSAGES,                              // MQTT/WebSocket/httpGet delivery
+        CALL_COUNT
+    };
+
+    /**
+     * @brief Create the binding table lock (called by JSEngine::init())
+     */
+    static bool init();
+
+    /**
+     * @brief Add a binding to the table (idempotent)
+     * @param name Global name in JS
+     * @param fn Native implementation
+     * @return Table index (the trampoline's magic), or -1 if the table is full
+     *
+     * Safe to call from the pool task and the UI loop at the same time.
+     */
+    static int registerBinding(const char* name, duk_c_function fn);
+
+    /**
+     * @brief Get the native implementation behind a table index
+     */
+    static duk_c_function getBinding(uint16_t index) { return _bindings[index].fn; }
+
+    /**
+     * @brief Count one binding call
+     */
+    static void recordBinding(uint8_t displayId, uint16_t index, uint32_t us);
+
+    /**
+     * @brief Record the duration of one top-level call
+     * @param kind JSLifecycle value or CALL_* constant
+     */
+    static void recordCall(uint8_t displayId, uint8_t kind, uint32_t us);
+
+    /**
+     * @brief Start a fresh profile for an app taking over a display
+     */
+    static void beginApp(uint8_t displayId, const char* appId);
+
+    /**
+     * @brief Clear all counters (apps keep their names)
+     */
+    static void reset();
+
+    /**
+     * @brief Write the profile of every display
+     * @param out Object receiving a "displays" array
+     */
+    static void toJson(JsonObject out);
+
+private:
+    struct Binding {
+        const char* name;
+        duk_c_function fn;
+    };
+
+    struct BindingStat {
+        uint32_t calls;
+        uint32_t maxUs;
+        uint64_t totalUs;
+    };
+
+    struct CallStat {
+        uint32_t count;
+        uint32_t maxUs;
+        uint64_t totalUs;
+        uint32_t samples[JS_PROFILER_SAMPLES];  // Ring of recent durations
+    };
+
+    struct Slot {
+        char app[MAX_APP_NAME_LENGTH];
+        BindingStat bindings[JS_PROFILER_MAX_BINDINGS];
+        CallStat calls[CALL_COUNT];
+    };
+
+    static Binding _bindings[JS_PROFILER_MAX_BINDINGS];
+    static volatile uint16_t _bindingCount;
+    static Slot _slots[DISPLAY_COUNT];
+    static SemaphoreHandle_t _mutex;
+
+    static void _clear(Slot& slot);
+    static uint32_t _percentile(const CallStat& stat, uint8_t percent);
+};
+
+} // namespace Doki
+
+#endif // DOKI_JS_PROFILER && ENABLE_JAVASCRIPT_SUPPORT
+
+#endif // DOKI_JS_PROFILER_H
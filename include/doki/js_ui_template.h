@@ -0,0 +1,186 @@
+/**
+ * @file js_ui_template.h
+ * @brief Declarative widget trees for createUI()
+ *
+ * A template describes a screen as JSON (or an equivalent JS object):
+ *
+ *   {
+ *     "bg": "#000000",
+ *     "children": [
+ *       { "type": "label", "id": "time", "text": "--:--:--",
+ *         "x": 0, "y": 120, "w": 240, "font": 24, "align": "center",
+ *         "color": "#00FF88" },
+ *       { "type": "container", "x": 10, "y": 200, "w": 220, "h": 60,
+ *         "bg": "#1E1E1E", "radius": 8,
+ *         "children": [ { "type": "label", "id": "status", "text": "OK", "x": 8, "y": 20 } ] }
+ *     ]
+ *   }
+ *
+ * compile() flattens the tree into a node array plus a string pool, so
+ * instantiate() builds every widget in one native pass without looking
+ * at JSON again. Templates loaded from /ui on LittleFS are compiled
+ * once per boot and kept in PSRAM; like /lib, /ui only changes with a
+ * new filesystem image.
+ *
+ * Node properties:
+ *   type       "label" (default) or "container"
+ *   id         Key in the handle map returned to JavaScript
+ *   x, y       Position relative to the parent
+ *   w, h       Size (labels: w only, enables wrapping / align)
+ *   text       Label text
+ *   color      Text color, number or "#RRGGBB"
+ *   bg         Background color (containers, or the screen at the root)
+ *   font       12, 14, 16, 20 or 24
+ *   align      "left" | "center" | "right" (or 0/1/2 as in setTextAlign)
+ *   scroll     true for a circular scrolling label (needs w)
+ *   radius     Container corner radius
+ *   opacity    0-255
+ *   children   Nested nodes (containers and the root only)
+ *
+ * The root object stands for the screen: only "bg" and "children" are
+ * read from it. A bare array is taken as the root's children.
+ */
+
+#ifndef DOKI_JS_UI_TEMPLATE_H
+#define DOKI_JS_UI_TEMPLATE_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <lvgl.h>
+#include <vector>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "doki/js_context.h"
+#include "hardware_config.h"
+
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+
+namespace Doki {
+
+class JSUITemplate {
+public:
+    static constexpr uint16_t NO_STRING = 0xFFFF;
+    static constexpr int16_t NO_PARENT = -1;
+
+    enum NodeType : uint8_t {
+        NODE_LABEL,
+        NODE_CONTAINER
+    };
+
+    /**
+     * @brief One widget, with its properties already decoded
+     */
+    struct Node {
+        uint8_t type;            // NodeType
+        uint8_t font;            // Font size, 0 = theme default
+        int8_t align;            // 0/1/2, -1 = unset
+        int16_t opacity;         // 0-255, -1 = unset
+        bool scroll;             // Circular scrolling label
+        int16_t parent;          // Index of the parent node, NO_PARENT = screen
+        int16_t x, y;
+        int16_t w, h;            // -1 = unset
+        int16_t radius;          // -1 = unset
+        int32_t color;           // 0xRRGGBB, -1 = unset
+        int32_t bg;              // 0xRRGGBB, -1 = unset
+        uint16_t text;           // Offset into the string pool, NO_STRING = none
+        uint16_t id;             // Offset into the string pool, NO_STRING = no handle
+    };
+
+    /**
+     * @brief Read-only view of a compiled template
+     */
+    struct Template {
+        const Node* nodes;
+        uint16_t count;
+        int32_t screenBg;        // Root "bg", -1 = unset
+        const char* strings;
+    };
+
+    /**
+     * @brief Compiled template owned by the caller (createUI() with an object)
+     */
+    struct Compiled {
+        std::vector<Node> nodes;
+        std::vector<char> strings;
+        int32_t screenBg = -1;
+
+        Template view() const {
+            return { nodes.data(), (uint16_t)nodes.size(), screenBg, strings.data() };
+        }
+    };
+
+    /**
+     * @brief Create the cache lock (call once at boot)
+     */
+    static bool init();
+
+    /**
+     * @brief Flatten a template tree
+     * @param root Root object, or an array of nodes
+     * @param out Receives nodes in creation order (parents before children)
+     * @param error Receives a static message on failure
+     * @return false if the template is malformed or too large
+     */
+    static bool compile(JsonVariantConst root, Compiled& out, const char*& error);
+
+    /**
+     * @brief Get a template file from the boot-wide cache, compiling it on first use
+     * @param path Template under /ui ("/ui/clock.json", or "clock")
+     * @param scratch Holds the template if the cache has no room for it
+     * @param out Receives a view (valid until reboot, or while scratch lives)
+     * @param error Receives a static message on failure
+     */
+    static bool load(const char* path, Compiled& scratch, Template& out, const char*& error);
+
+    /**
+     * @brief Create the widgets of a compiled template
+     * @param tmpl Template to build
+     * @param screen Screen the root nodes are created on
+     * @param handles Table receiving the nodes that have an id
+     * @param out One handle per node (INVALID_HANDLE if it has no id)
+     * @return Number of widgets created
+     *
+     * Caller holds the LVGL lock.
+     */
+    static uint16_t instantiate(const Template& tmpl, lv_obj_t* screen,
+                                JSHandleTable& handles, uint32_t* out);
+
+    /**
+     * @brief Map a font size to the closest built-in Montserrat font
+     */
+    static const lv_font_t* fontForSize(int size);
+
+    /**
+     * @brief Get number of template files held compiled
+     */
+    static uint32_t getTemplateCount() { return _entryCount; }
+
+    /**
+     * @brief Get number of loads served from cache / compiled from LittleFS
+     */
+    static uint32_t getHits() { return _hits; }
+    static uint32_t getMisses() { return _misses; }
+
+private:
+    struct Entry {
+        String path;
+        Template tmpl;           // nodes and strings share one PSRAM block
+    };
+
+    static Entry _entries[JS_UI_TEMPLATE_CACHE_ENTRIES];
+    static uint32_t _entryCount;
+    static SemaphoreHandle_t _mutex;
+    static uint32_t _hits;
+    static uint32_t _misses;
+
+    static const Entry* _find(const String& path);
+    static bool _compileNode(JsonVariantConst node, int16_t parent, uint8_t depth,
+                             Compiled& out, const char*& error);
+    static bool _store(const String& path, const Compiled& compiled, Template& out);
+};
+
+} // namespace Doki
+
+#endif // ENABLE_JAVASCRIPT_SUPPORT
+
+#endif // DOKI_JS_UI_TEMPLATE_H
@@ -0,0 +1,224 @@
+/**
+ * @file logger.h
+ * @brief Structured logging for Doki OS
+ *
+ * Replaces direct Serial.printf() on hot paths. A log call:
+ * - compiles to nothing when its level is above the module's
+ *   compile-time threshold (arguments are not even evaluated)
+ * - checks the module's runtime level before formatting anything
+ * - formats into a preallocated slot of a lock-free ring buffer and
+ *   returns; it never waits for Serial, a mutex or an allocation
+ *
+ * A low-priority task on core 0 drains the ring to Serial and keeps a
+ * short history that is served over HTTP (GET /api/logs).
+ * When the ring is full the record is dropped and counted.
+ *
+ * Compile-time thresholds (build_flags in platformio.ini):
+ *   -DDOKI_LOG_LEVEL=3           Default for all modules (INFO)
+ *   -DDOKI_LOG_LEVEL_JS=4        Override per module (DEBUG for JS)
+ *
+ * Example:
+ *   DOKI_LOGI(JS_ENGINE, "Loaded %u bytes from %s", size, path);
+ *   DOKI_LOGD(JS, "Updated label ID=%u", id);   // Compiled out at INFO
+ */
+
+#ifndef DOKI_LOGGER_H
+#define DOKI_LOGGER_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <vector>
+
+// ========================================
+// Log Levels
+// ========================================
+
+#define DOKI_LOG_NONE       0
+#define DOKI_LOG_ERROR      1
+#define DOKI_LOG_WARN       2
+#define DOKI_LOG_INFO       3
+#define DOKI_LOG_DEBUG      4
+#define DOKI_LOG_VERBOSE    5
+
+#ifndef DOKI_LOG_LEVEL
+    #define DOKI_LOG_LEVEL  DOKI_LOG_INFO
+#endif
+
+// Per-module compile-time thresholds (default to DOKI_LOG_LEVEL)
+#ifndef DOKI_LOG_LEVEL_CORE
+    #define DOKI_LOG_LEVEL_CORE         DOKI_LOG_LEVEL
+#endif
+#ifndef DOKI_LOG_LEVEL_APP
+    #define DOKI_LOG_LEVEL_APP          DOKI_LOG_LEVEL
+#endif
+#ifndef DOKI_LOG_LEVEL_JS_ENGINE
+    #define DOKI_LOG_LEVEL_JS_ENGINE    DOKI_LOG_LEVEL
+#endif
+#ifndef DOKI_LOG_LEVEL_JS
+    #define DOKI_LOG_LEVEL_JS           DOKI_LOG_LEVEL
+#endif
+#ifndef DOKI_LOG_LEVEL_EVENT
+    #define DOKI_LOG_LEVEL_EVENT        DOKI_LOG_LEVEL
+#endif
+#ifndef DOKI_LOG_LEVEL_HTTP
+    #define DOKI_LOG_LEVEL_HTTP         DOKI_LOG_LEVEL
+#endif
+#ifndef DOKI_LOG_LEVEL_STATE
+    #define DOKI_LOG_LEVEL_STATE        DOKI_LOG_LEVEL
+#endif
+#ifndef DOKI_LOG_LEVEL_MQTT
+    #define DOKI_LOG_LEVEL_MQTT         DOKI_LOG_LEVEL
+#endif
+#ifndef DOKI_LOG_LEVEL_WEBSOCKET
+    #define DOKI_LOG_LEVEL_WEBSOCKET    DOKI_LOG_LEVEL
+#endif
+#ifndef DOKI_LOG_LEVEL_ANIMATION
+    #define DOKI_LOG_LEVEL_ANIMATION    DOKI_LOG_LEVEL
+#endif
+
+// ========================================
+// Log Macros
+// ========================================
+
+#define DOKI_LOG_ENABLED(module, level) ((level) <= DOKI_LOG_LEVEL_##module)
+
+#define DOKI_LOG(module, level, fmt, ...)                                           \
+    do {                                                                            \
+        if (DOKI_LOG_ENABLED(module, level) &&                                      \
+            ::Doki::Logger::isEnabled(::Doki::LogModule::module, level)) {          \
+            ::Doki::Logger::write(::Doki::LogModule::module, level, fmt, ##__VA_ARGS__); \
+        }                                                                           \
+    } while (0)
+
+#define DOKI_LOGE(module, fmt, ...) DOKI_LOG(module, DOKI_LOG_ERROR, fmt, ##__VA_ARGS__)
+#define DOKI_LOGW(module, fmt, ...) DOKI_LOG(module, DOKI_LOG_WARN, fmt, ##__VA_ARGS__)
+#define DOKI_LOGI(module, fmt, ...) DOKI_LOG(module, DOKI_LOG_INFO, fmt, ##__VA_ARGS__)
+#define DOKI_LOGD(module, fmt, ...) DOKI_LOG(module, DOKI_LOG_DEBUG, fmt, ##__VA_ARGS__)
+#define DOKI_LOGV(module, fmt, ...) DOKI_LOG(module, DOKI_LOG_VERBOSE, fmt, ##__VA_ARGS__)
+
+namespace Doki {
+
+/**
+ * @brief Log source modules
+ *
+ * Add new modules here, in getModuleName() and as a
+ * DOKI_LOG_LEVEL_<MODULE> default above.
+ */
+enum class LogModule : uint8_t {
+    CORE,           // Boot and main loop
+    APP,            // AppManager and app lifecycle
+    JS_ENGINE,      // Duktape context management
+    JS,             // JS bindings and script log() output
+    EVENT,          // EventSystem
+    HTTP,           // SimpleHttpServer
+    STATE,          // StatePersistence
+    MQTT,           // MQTT client
+    WEBSOCKET,      // WebSocket client
+    ANIMATION,      // Animation system
+    COUNT
+};
+
+/**
+ * @brief One log line as stored in the ring buffer and history
+ */
+struct LogRecord {
+    static constexpr size_t TEXT_SIZE = 112;
+
+    uint32_t seq;               // Monotonic sequence number
+    uint32_t timestamp;         // millis() when logged
+    uint8_t level;              // DOKI_LOG_* level
+    uint8_t module;             // LogModule
+    uint16_t length;            // Bytes used in text
+    char text[TEXT_SIZE];       // Formatted message (truncated if longer)
+};
+
+/**
+ * @brief Lock-free structured logger
+ */
+class Logger {
+public:
+    /**
+     * @brief Allocate the ring buffer and start the drain task
+     * @return true if initialized successfully
+     *
+     * Call right after Serial.begin(). Until then, and for good if
+     * init() fails, log calls are written straight to Serial.
+     */
+    static bool init();
+
+    /**
+     * @brief Runtime level check (compile-time check happens in the macros)
+     */
+    static inline bool isEnabled(LogModule module, uint8_t level) {
+        return level <= _levels[(uint8_t)module];
+    }
+
+    /**
+     * @brief Set runtime level for a module
+     *
+     * Cannot raise a module above its compile-time threshold.
+     */
+    static void setLevel(LogModule module, uint8_t level);
+
+    /**
+     * @brief Format and enqueue a record (use the DOKI_LOG* macros)
+     */
+    static void write(LogModule module, uint8_t level, const char* fmt, ...)
+        __attribute__((format(printf, 3, 4)));
+
+    /**
+     * @brief Copy recent records from the history buffer
+     *
+     * @param sinceSeq Only return records with seq >= sinceSeq
+     * @param out Vector to append records to (oldest first)
+     * @param maxRecords Maximum number of records to return
+     */
+    static void getHistory(uint32_t sinceSeq, std::vector<LogRecord>& out, size_t maxRecords);
+
+    /**
+     * @brief Get number of records dropped because the ring was full
+     */
+    static uint32_t getDroppedCount() { return _dropped.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Get module name (e.g. "JSEngine")
+     */
+    static const char* getModuleName(LogModule module);
+
+    /**
+     * @brief Get level name (e.g. "INFO")
+     */
+    static const char* getLevelName(uint8_t level);
+
+private:
+    // Ring size must be a power of two
+    static constexpr uint32_t RING_SIZE = 64;
+    static constexpr uint32_t RING_MASK = RING_SIZE - 1;
+    static constexpr uint32_t HISTORY_SIZE = 64;
+
+    // Bounded MPSC queue cell (Vyukov sequence scheme)
+    struct Cell {
+        std::atomic<uint32_t> sequence;
+        LogRecord record;
+    };
+
+    static Cell* _cells;
+    static std::atomic<uint32_t> _enqueuePos;
+    static uint32_t _dequeuePos;            // Drain task only
+    static std::atomic<uint32_t> _dropped;
+    static uint8_t _levels[(uint8_t)LogModule::COUNT];
+
+    static LogRecord* _history;
+    static uint32_t _historyCount;
+    static SemaphoreHandle_t _historyMutex;
+    static TaskHandle_t _drainTask;
+
+    static void _freeBuffers();
+    static bool _pop(LogRecord& out);
+    static void _drainTaskEntry(void* param);
+    static void _print(const LogRecord& record);
+};
+
+} // namespace Doki
+
+#endif // DOKI_LOGGER_H
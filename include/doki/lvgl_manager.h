@@ -6,17 +6,27 @@
  * LVGL from multiple cores (e.g., HTTP server on Core 0, rendering on Core 1).
  *
  * Usage:
- *   LVGLManager::lock();
+ *   LVGLManager::lock(displayId);
  *   lv_obj_clean(screen); // Safe LVGL operation
  *   LVGLManager::unlock();
+ *
+ * LVGL 8 is a single instance, so there is still one mutex behind every
+ * display. What keeps one panel from stalling the other is how long it is
+ * held: rendering runs on its own task (startRenderTask()) and AppManager
+ * takes the lock once per app callback instead of across all displays.
+ * Each acquisition names a scope (a display id, SCOPE_RENDER or
+ * SCOPE_SYSTEM) so wait and hold times can be attributed; see toJson().
  */
 
 #ifndef DOKI_LVGL_MANAGER_H
 #define DOKI_LVGL_MANAGER_H
 
 #include <Arduino.h>
+#include <ArduinoJson.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
+#include <freertos/task.h>
+#include "hardware_config.h"
 
 namespace Doki {
 
@@ -28,6 +38,11 @@ namespace Doki {
  */
 class LVGLManager {
 public:
+    // Scopes 0..DISPLAY_COUNT-1 are the displays
+    static constexpr uint8_t SCOPE_RENDER = DISPLAY_COUNT;       // lv_timer_handler() on the render task
+    static constexpr uint8_t SCOPE_SYSTEM = DISPLAY_COUNT + 1;   // Anything not tied to one display
+    static constexpr uint8_t SCOPE_COUNT = DISPLAY_COUNT + 2;
+
     /**
      * @brief Initialize LVGL mutex
      * @return true if initialized successfully
@@ -36,11 +51,12 @@ public:
 
     /**
      * @brief Acquire LVGL mutex (blocking)
+     * @param scope Display id, SCOPE_RENDER or SCOPE_SYSTEM (for the stats)
      *
      * Must be called before ANY LVGL operation (lv_*).
-     * Always pair with unlock().
+     * Always pair with unlock(). Nested calls keep the outermost scope.
      */
-    static void lock();
+    static void lock(uint8_t scope = SCOPE_SYSTEM);
 
     /**
      * @brief Release LVGL mutex
@@ -53,13 +69,81 @@ public:
     /**
      * @brief Try to acquire LVGL mutex (non-blocking)
      * @param timeoutMs Timeout in milliseconds
+     * @param scope Display id, SCOPE_RENDER or SCOPE_SYSTEM (for the stats)
      * @return true if mutex acquired, false if timeout
      */
-    static bool tryLock(uint32_t timeoutMs = 100);
+    static bool tryLock(uint32_t timeoutMs = 100, uint8_t scope = SCOPE_SYSTEM);
+
+    /**
+     * @brief Start the task that runs lv_timer_handler()
+     *
+     * Call once LVGL and the displays are set up; from then on nothing
+     * else should call lv_timer_handler().
+     */
+    static bool startRenderTask();
+
+    /**
+     * @brief Write per-scope contention and hold-time stats
+     * @param out Object receiving one entry per scope
+     */
+    static void toJson(JsonObject out);
+
+    /**
+     * @brief Clear the stats
+     */
+    static void resetStats();
+
+    /**
+     * @brief Drops the lock for blocking work inside a locked section
+     *
+     * Releases every level the calling task holds and takes them back,
+     * under the same scope, when it goes out of scope. Does nothing if
+     * the task does not hold the lock. LVGL objects may change while it
+     * is released, so re-check anything that could have been deleted.
+     *
+     *   {
+     *       LVGLManager::Unlocked unlocked;
+     *       ok = WeatherService::getCurrentWeather(location, data);
+     *   }
+     */
+    class Unlocked {
+    public:
+        Unlocked();
+        ~Unlocked();
+        Unlocked(const Unlocked&) = delete;
+        Unlocked& operator=(const Unlocked&) = delete;
+
+    private:
+        uint32_t _depth;
+        uint8_t _scope;
+    };
 
 private:
+    struct ScopeStats {
+        uint32_t acquisitions;
+        uint32_t contended;      // Had to wait for another task
+        uint32_t slowHolds;      // Held longer than LVGL_LOCK_SLOW_HOLD_MS
+        uint32_t waitMaxUs;
+        uint32_t holdMaxUs;
+        uint64_t waitTotalUs;
+        uint64_t holdTotalUs;
+    };
+
     static SemaphoreHandle_t _mutex;
     static bool _initialized;
+
+    // Written only by the task holding the mutex
+    static volatile TaskHandle_t _owner;
+    static uint32_t _depth;
+    static uint8_t _holdScope;
+    static uint32_t _holdStart;
+    static ScopeStats _stats[SCOPE_COUNT];
+
+    static TaskHandle_t _renderTask;
+
+    static void _acquired(uint8_t scope, bool contended, uint32_t waitUs);
+    static void _release(uint32_t depth);
+    static void _renderTaskFunc(void* param);
 };
 
 } // namespace Doki
@@ -59,6 +59,17 @@ private:
     static void handleGetApps(AsyncWebServerRequest* request);
     static void handleLoadApp(AsyncWebServerRequest* request);
     static void handleGetStatus(AsyncWebServerRequest* request);
+    static void handleGetLogs(AsyncWebServerRequest* request);
+    static void handleGetPerf(AsyncWebServerRequest* request);
+    static void handleResetPerf(AsyncWebServerRequest* request);
+#ifdef DOKI_JS_PROFILER
+    static void handleGetJSProfile(AsyncWebServerRequest* request);
+    static void handleResetJSProfile(AsyncWebServerRequest* request);
+#endif
+#ifdef DOKI_TRACE
+    static void handleGetTrace(AsyncWebServerRequest* request);
+    static void handleClearTrace(AsyncWebServerRequest* request);
+#endif
     static void handleMediaInfo(AsyncWebServerRequest* request);
     static void handleMediaDelete(AsyncWebServerRequest* request);
     static void handleUploadJS(AsyncWebServerRequest* request);
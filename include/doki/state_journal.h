@@ -0,0 +1,136 @@
+/**
+ * @file state_journal.h
+ * @brief Append-only app state store on the filesystem
+ *
+ * Backend of StatePersistence. Every commit appends one record to
+ * /state.journal:
+ *
+ *   [header: magic, sequence, length, crc, key length][app id][payload]
+ *
+ * A record with length 0 removes the app's state. The sequence number
+ * increases with every record, so a later record for the same app
+ * supersedes earlier ones. The CRC32 covers app id and payload.
+ *
+ * init() replays the journal into a RAM index (app id -> record offset),
+ * so a load is one seek and one read. Replay stops at the first record
+ * that is truncated or fails its CRC (power lost mid-append); the journal
+ * is then compacted, which drops the damaged tail. Compaction copies the
+ * live records to /state.journal.tmp and renames it over the journal once
+ * superseded records take up more than half the file.
+ *
+ * Not thread-safe: StatePersistence serializes all calls.
+ */
+
+#ifndef DOKI_STATE_JOURNAL_H
+#define DOKI_STATE_JOURNAL_H
+
+#include <Arduino.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "doki/filesystem_manager.h"
+#include "hardware_config.h"
+
+namespace Doki {
+
+class StateJournal {
+public:
+    /**
+     * @brief Replay the journal into the index (filesystem must be mounted)
+     * @return true if the journal is usable
+     */
+    static bool init();
+
+    /**
+     * @brief Check if the journal is usable
+     */
+    static bool isReady() { return _ready; }
+
+    /**
+     * @brief Check if the journal holds state for an app
+     */
+    static bool contains(const char* appId);
+
+    /**
+     * @brief Get the size of an app's state
+     * @return Payload bytes, 0 if none
+     */
+    static size_t getSize(const char* appId);
+
+    /**
+     * @brief Read an app's state
+     * @param appId App unique identifier
+     * @param out Receives the payload
+     * @return false if there is none or it fails its CRC
+     */
+    static bool read(const char* appId, std::vector<uint8_t>& out);
+
+    /**
+     * @brief Append a new version of an app's state
+     * @param appId App unique identifier
+     * @param data Payload (at most STATE_JOURNAL_MAX_RECORD bytes)
+     * @param size Payload bytes, > 0
+     */
+    static bool append(const char* appId, const uint8_t* data, size_t size);
+
+    /**
+     * @brief Append a removal record for an app's state
+     */
+    static bool remove(const char* appId);
+
+    /**
+     * @brief Delete the journal and every state in it
+     */
+    static bool clear();
+
+    /**
+     * @brief Rewrite the journal with only the latest record of each app
+     */
+    static bool compact();
+
+    /**
+     * @brief Get journal file size / bytes of records still current
+     */
+    static uint32_t getFileSize() { return _fileSize; }
+    static uint32_t getLiveBytes() { return _liveBytes; }
+
+private:
+    struct RecordHeader {
+        uint32_t magic;          // RECORD_MAGIC
+        uint32_t sequence;       // Journal-wide, increases with every record
+        uint32_t length;         // Payload bytes, 0 = state removed
+        uint32_t crc;            // CRC32 of app id and payload
+        uint8_t keyLength;       // App id bytes (no terminator)
+        uint8_t reserved[3];
+    };
+
+    struct IndexEntry {
+        uint32_t offset;         // Start of the record
+        uint32_t length;         // Payload bytes
+        uint32_t sequence;
+        uint32_t crc;
+    };
+
+    static constexpr uint32_t RECORD_MAGIC = 0x4A534B44; // "DKSJ"
+    static constexpr const char* JOURNAL_PATH = "/state.journal";
+    static constexpr const char* COMPACT_PATH = "/state.journal.tmp";
+
+    static bool _ready;
+    static std::unordered_map<std::string, IndexEntry> _index;
+    static uint32_t _sequence;
+    static uint32_t _fileSize;
+    static uint32_t _liveBytes;
+
+    static uint32_t _recordSize(size_t keyLength, uint32_t length);
+    static bool _replay(uint32_t& validBytes);
+    static bool _write(const char* appId, const uint8_t* data, uint32_t size);
+    static bool _writeRecord(File& file, const std::string& key, uint32_t sequence,
+                             const uint8_t* data, uint32_t size);
+    static void _apply(const std::string& key, uint32_t offset, uint32_t length,
+                       uint32_t sequence, uint32_t crc);
+    static void _maybeCompact();
+};
+
+} // namespace Doki
+
+#endif // DOKI_STATE_JOURNAL_H
@@ -3,7 +3,20 @@
  * @brief State Persistence Module for Doki OS
  *
  * Allows apps to save and restore their state across unload/load cycles.
- * Uses NVS (Non-Volatile Storage) for persistent storage.
+ * States are stored in an append-only journal on LittleFS (StateJournal),
+ * up to STATE_JOURNAL_MAX_RECORD bytes each. NVS (Non-Volatile Storage) is
+ * the fallback when the journal is unavailable, limited to MAX_STATE_SIZE;
+ * states found in NVS are moved to the journal on first access.
+ *
+ * States are kept MessagePack-encoded in a RAM write-back cache. saveState()
+ * only updates the cache; dirty entries are committed by update()
+ * once no state has been saved for STATE_FLUSH_QUIET_MS (at the latest
+ * STATE_FLUSH_MAX_DELAY_MS after the first unsaved change), by flush(),
+ * and from a shutdown handler before esp_restart(). Committed states larger
+ * than STATE_CACHE_MAX_BYTES are dropped from RAM and read back from the
+ * journal when needed. The NVS namespace is opened once at init() and
+ * stays open. A state saved within the last
+ * few seconds is lost on power loss or a crash.
  *
  * Example:
  *   // In onPause():
@@ -24,6 +37,11 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <Preferences.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 
 namespace Doki {
 
@@ -41,11 +59,11 @@ public:
     static bool init();
 
     /**
-     * @brief Save app state to NVS
+     * @brief Save app state (committed to NVS later, see update())
      *
      * @param appId App unique identifier
      * @param state JSON document containing state data
-     * @return true if saved successfully
+     * @return true if the state was accepted
      *
      * Example:
      *   JsonDocument state;
@@ -56,7 +74,7 @@ public:
     static bool saveState(const char* appId, const JsonDocument& state);
 
     /**
-     * @brief Load app state from NVS
+     * @brief Load app state (from the cache, or NVS on first access)
      *
      * @param appId App unique identifier
      * @param state JSON document to populate with loaded state
@@ -74,7 +92,9 @@ public:
      * @brief Check if state exists for an app
      *
      * @param appId App unique identifier
-     * @return true if state exists in NVS
+     * @return true if state exists
+     *
+     * No need to call it before loadState(), which returns false as well.
      */
     static bool hasState(const char* appId);
 
@@ -97,22 +117,75 @@ public:
      * @brief Get size of saved state
      *
      * @param appId App unique identifier
-     * @return Size in bytes, or 0 if not found
+     * @return Size in bytes (MessagePack), or 0 if not found
      */
     static size_t getStateSize(const char* appId);
 
+    /**
+     * @brief Commit pending states once the quiet period has passed
+     *
+     * Call regularly from the main loop.
+     */
+    static void update();
+
+    /**
+     * @brief Commit every pending state now
+     * @return Number of states written or removed
+     */
+    static uint32_t flush();
+
+    /**
+     * @brief Get number of states not yet committed to NVS
+     */
+    static uint32_t getPendingCount();
+
 private:
+    struct Entry {
+        std::vector<uint8_t> packed; // MessagePack, empty = no state (when resident)
+        bool resident;               // packed holds the state, else it is only in the journal
+        bool dirty;                  // Differs from storage
+        bool nvs;                    // A blob in NVS still has to go (moved to the journal)
+        bool legacy;                 // A JSON string under the old key still has to go
+    };
+
     static bool _initialized;
+    static bool _journal;            // StateJournal is the backend (else NVS)
     static Preferences _prefs;
+    static SemaphoreHandle_t _mutex;
+    static std::map<std::string, Entry> _cache;
+    static uint32_t _pending;
+    static uint32_t _firstDirtyAt;
+    static uint32_t _lastSaveAt;
 
     // NVS namespace for app states
     static constexpr const char* NAMESPACE = "doki_states";
 
-    // Maximum state size (4KB)
+    // Maximum state size in NVS (4KB); see STATE_JOURNAL_MAX_RECORD for the journal
     static constexpr size_t MAX_STATE_SIZE = 4096;
 
-    // Helper: Generate NVS key from app ID
+    // Helper: Generate NVS key from app ID (MessagePack blob)
     static String _makeKey(const char* appId);
+
+    // Helper: Key of the JSON string written before the cache existed
+    static String _makeLegacyKey(const char* appId);
+
+    // Helper: Get the cache entry, reading NVS on first access (mutex held)
+    static Entry& _entry(const char* appId);
+
+    // Helper: Get an entry's state, from RAM or the journal (mutex held)
+    static bool _read(const char* appId, const Entry& entry, std::vector<uint8_t>& out);
+
+    // Helper: Largest state the backend takes
+    static size_t _maxStateSize();
+
+    // Helper: Mark an entry changed (mutex held)
+    static void _markDirty(Entry& entry);
+
+    // Helper: Write every dirty entry (mutex held)
+    static uint32_t _commit();
+
+    // Shutdown handler: commit before esp_restart()
+    static void _onShutdown();
 };
 
 } // namespace Doki
@@ -0,0 +1,201 @@
+/**
+ * @file tracer.h
+ * @brief Timeline of spans and instant events, exported as Chrome trace JSON
+ *
+ * Compiled only with -DDOKI_TRACE (build_flags in platformio.ini). Without
+ * it the DOKI_TRACE_* macros expand to nothing, their arguments are not
+ * evaluated and GET /api/trace does not exist.
+ *
+ * With it, each core writes into its own ring of the most recent
+ * TRACE_BUFFER_EVENTS events (PSRAM). Writers claim a slot with one atomic
+ * increment and never wait; once a ring is full the oldest events are
+ * overwritten. Timestamps are esp_timer microseconds since boot.
+ *
+ * Usage:
+ *   void AppManager::update() {
+ *       DOKI_TRACE_SCOPE("app", "AppManager::update");
+ *       ...
+ *   }
+ *   DOKI_TRACE_INSTANT("wifi", "reconnect");
+ *
+ * Names and categories are stored as pointers: pass string literals or
+ * other strings that live for the whole run.
+ *
+ * GET /api/trace serves the rings in the Chrome trace-event format, which
+ * Perfetto (ui.perfetto.dev) and chrome://tracing open directly. Each core
+ * is a process, each FreeRTOS task a thread.
+ */
+
+#ifndef DOKI_TRACER_H
+#define DOKI_TRACER_H
+
+#ifdef DOKI_TRACE
+
+#include <Arduino.h>
+#include <atomic>
+#include <vector>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "hardware_config.h"
+
+namespace Doki {
+
+class Tracer {
+public:
+    enum Phase : uint8_t {
+        PHASE_SPAN,              // Complete event ("X")
+        PHASE_INSTANT            // Instant event ("i")
+    };
+
+    struct Event {
+        const char* category;
+        const char* name;
+        int64_t startUs;
+        uint32_t durationUs;     // 0 for instants
+        uint8_t task;            // Index into the task table, 0 = ISR / other
+        uint8_t core;
+        uint8_t phase;           // Phase
+    };
+
+    /**
+     * @brief Allocate the rings (events before this are ignored)
+     */
+    static bool init();
+
+    /**
+     * @brief Current trace clock
+     */
+    static int64_t now() { return esp_timer_get_time(); }
+
+    /**
+     * @brief Record a span that started at startUs and ends now
+     */
+    static void complete(const char* category, const char* name, int64_t startUs);
+
+    /**
+     * @brief Record an instant event
+     */
+    static void instant(const char* category, const char* name);
+
+    /**
+     * @brief Copy the events currently in the rings, core by core
+     * @param out Receives the events, oldest first per core
+     * @return Events lost to overwriting since the last clear()
+     *
+     * Recording goes on meanwhile; slots overwritten during the copy
+     * are left out.
+     */
+    static uint32_t snapshot(std::vector<Event>& out);
+
+    /**
+     * @brief Drop everything recorded so far
+     */
+    static void clear();
+
+    /**
+     * @brief Get the name of a task table entry
+     *
+     * Tasks are added the first time they record an event. A task created
+     * in the memory of a deleted one keeps the old name.
+     */
+    static const char* getTaskName(uint8_t task);
+
+private:
+    struct Slot {
+        volatile uint32_t sequence;   // Position + 1 once written, 0 while being written
+        Event event;
+    };
+
+    struct TaskEntry {
+        std::atomic<TaskHandle_t> handle;
+        char name[configMAX_TASK_NAME_LEN];
+    };
+
+    static constexpr uint32_t RING_MASK = TRACE_BUFFER_EVENTS - 1;
+    static_assert((TRACE_BUFFER_EVENTS & RING_MASK) == 0, "TRACE_BUFFER_EVENTS must be a power of 2");
+    static_assert(TRACE_MAX_TASKS <= 32, "Tasks seen per core are tracked in a 32-bit mask");
+
+    static Slot* _rings[portNUM_PROCESSORS];
+    static std::atomic<uint32_t> _head[portNUM_PROCESSORS];
+    static uint32_t _floor[portNUM_PROCESSORS];      // Positions below were cleared
+    static TaskEntry _tasks[TRACE_MAX_TASKS];
+
+    static void _record(const char* category, const char* name, int64_t startUs,
+                        uint32_t durationUs, Phase phase);
+    static uint8_t _taskIndex();
+};
+
+/**
+ * @brief RAII span, see DOKI_TRACE_SCOPE
+ */
+class TraceScope {
+public:
+    TraceScope(const char* category, const char* name)
+        : _category(category), _name(name), _start(Tracer::now()) {}
+    ~TraceScope() { Tracer::complete(_category, _name, _start); }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* _category;
+    const char* _name;
+    int64_t _start;
+};
+
+/**
+ * @brief Streams a snapshot of the rings as Chrome trace JSON
+ *
+ * Feeds a chunked HTTP response: read() fills the buffer with the next
+ * part of the document and returns 0 at the end.
+ */
+class TraceExport {
+public:
+    TraceExport();
+
+    size_t read(uint8_t* buffer, size_t maxLen);
+
+private:
+    enum Stage : uint8_t {
+        STAGE_HEADER,
+        STAGE_PROCESSES,
+        STAGE_THREADS,
+        STAGE_EVENTS,
+        STAGE_FOOTER,
+        STAGE_DONE
+    };
+
+    std::vector<Tracer::Event> _events;
+    uint32_t _overwritten;
+    uint32_t _seenTasks[portNUM_PROCESSORS];   // Bit per task index seen on each core
+    Stage _stage;
+    size_t _next;             // Position within the current stage
+    bool _first;              // No event written yet (comma handling)
+    char _line[256];
+    size_t _lineLen;
+    size_t _lineSent;
+
+    bool _nextLine();
+    void _format(const char* fmt, ...);
+};
+
+} // namespace Doki
+
+#define DOKI_TRACE_CONCAT_(a, b) a##b
+#define DOKI_TRACE_CONCAT(a, b) DOKI_TRACE_CONCAT_(a, b)
+
+/** Span from here to the end of the enclosing block */
+#define DOKI_TRACE_SCOPE(category, name) \
+    ::Doki::TraceScope DOKI_TRACE_CONCAT(_traceScope, __LINE__)(category, name)
+
+/** Single point in time */
+#define DOKI_TRACE_INSTANT(category, name) ::Doki::Tracer::instant(category, name)
+
+#else
+
+#define DOKI_TRACE_SCOPE(category, name) ((void)0)
+#define DOKI_TRACE_INSTANT(category, name) ((void)0)
+
+#endif // DOKI_TRACE
+
+#endif // DOKI_TRACER_H
@@ -11,12 +11,20 @@
  *       Serial.printf("Temperature: %.1f°C\n", data.tempC);
  *       Serial.printf("Condition: %s\n", data.condition.c_str());
  *   }
+ *
+ * getCurrentWeather() blocks for the whole request (seconds, with
+ * retries). Apps fetch from onUpdate() with requestWeather() and pick
+ * the result up later with pollWeather(); a task on core 0 performs the
+ * request, so neither display's loop waits for the network.
  */
 
 #ifndef DOKI_WEATHER_SERVICE_H
 #define DOKI_WEATHER_SERVICE_H
 
 #include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
 
 namespace Doki {
 
@@ -61,17 +69,56 @@ struct WeatherData {
  */
 class WeatherService {
 public:
+    /**
+     * @brief Result of pollWeather()
+     */
+    enum class FetchStatus : uint8_t {
+        PENDING,            // Requested, not finished yet
+        READY,              // Data copied out
+        FAILED              // Last request failed, or nothing was requested
+    };
+
     /**
      * @brief Initialize weather service
      * 
      * @param apiKey Your WeatherAPI.com API key
      * 
-     * Must be called before using the service.
+     * Must be called before using the service. Also starts the
+     * background fetch task used by requestWeather().
      * 
      * Example:
      *   WeatherService::init("3183db8ec2fe4abfa2c133226251310");
      */
     static void init(const char* apiKey);
+
+    /**
+     * @brief Start fetching weather in the background
+     *
+     * @param location City name
+     * @return true if the data is cached or a fetch is under way,
+     *         false if the service is not initialized
+     *
+     * Never blocks. A newer request for another location replaces one
+     * that has not started yet.
+     *
+     * Example:
+     *   WeatherService::requestWeather("Mumbai");       // onStart()
+     *   ...
+     *   if (WeatherService::pollWeather("Mumbai", weather)
+     *           == WeatherService::FetchStatus::READY) {  // onUpdate()
+     *       showWeather(weather);
+     *   }
+     */
+    static bool requestWeather(const String& location);
+
+    /**
+     * @brief Check on a requestWeather() fetch
+     *
+     * @param location City name passed to requestWeather()
+     * @param data Output: Weather data, only written when READY
+     * @return Fetch status
+     */
+    static FetchStatus pollWeather(const String& location, WeatherData& data);
     
     /**
      * @brief Get current weather for a location
@@ -124,6 +171,18 @@ private:
     static WeatherData _cachedData;
     static String _cachedLocation;
     static const uint32_t CACHE_DURATION_MS = 600000;  // 10 minutes
+
+    // Background fetches (strings and cache guarded by _mutex)
+    static SemaphoreHandle_t _mutex;
+    static TaskHandle_t _fetchTask;
+    static String _requestedLocation;   // Waiting for the task
+    static String _fetchingLocation;    // Being fetched
+    static String _failedLocation;      // Last fetch for it failed
+
+    static void _lock();
+    static void _unlock();
+    static bool _cacheValidFor(const String& location);  // Caller holds the lock
+    static void _fetchTaskEntry(void* param);
     
     /**
      * @brief Fetch weather from API
@@ -60,6 +60,49 @@
 // JavaScript Engine
 #define JS_HEAP_SIZE_KB                 128     // Duktape heap size per app (kilobytes)
 #define JS_CODE_MAX_SIZE_BYTES          16384   // Max JavaScript source code size (16 KB)
+#define JS_MAX_TIMERS                   32      // setTimeout/setInterval timers per app
+#define JS_MAX_FRAME_REQUESTS           16      // Pending requestAnimationFrame callbacks per app
+#define JS_MAX_CANVASES                 4       // Live createCanvas() canvases per app
+#define JS_JSON_MAX_DEPTH               16      // Nesting limit for JSON <-> JS value conversion
+#define JS_MESSAGE_QUEUE_SLOTS          16      // Pending MQTT/WebSocket messages per app (each)
+#define JS_MESSAGE_MAX_TOPIC            64      // MQTT topic bytes kept per message
+#define JS_MESSAGE_MAX_PAYLOAD          512     // Payload bytes kept per message (longer is truncated)
+#define JS_HTTP_WORKERS                 2       // Async httpGet() requests in flight (all apps)
+#define JS_HTTP_MAX_PENDING             4       // Outstanding httpGet() requests per app
+#define JS_HTTP_QUEUE_SIZE              8       // Requests waiting for a worker (all apps)
+#define JS_HTTP_MAX_RESPONSE_BYTES      16384   // Larger httpGet() responses fail
+#define JS_CONTEXT_POOL_SIZE            2       // Warm contexts kept ready for app switches
+#define JS_CONTEXT_RETIRE_QUEUE_SIZE    4       // Contexts waiting for background teardown
+#define JS_CONTEXT_POOL_MIN_FREE_HEAP   65536   // Stop pre-building contexts below this free heap (bytes)
+#define JS_MODULE_CACHE_ENTRIES         16      // require() modules kept as bytecode (all apps)
+#define JS_MODULE_CACHE_MAX_BYTES       65536   // PSRAM for cached module bytecode (bytes)
+#define JS_MODULE_PATH_CACHE_SIZE       16      // require() name -> path lookups remembered
+#define JS_PROFILER_MAX_BINDINGS        96      // Bindings tracked with -DDOKI_JS_PROFILER
+#define JS_PROFILER_SAMPLES             64      // Recent call durations kept for p50/p99
+#define JS_UI_TEMPLATE_MAX_NODES        64      // Widgets per createUI() template
+#define JS_UI_TEMPLATE_CACHE_ENTRIES    8       // /ui template files kept compiled (all apps)
+#define JS_SHARED_HEAP_MAX_APPS         4       // Trusted apps per heap with -DDOKI_JS_SHARED_HEAP
+
+// App Residency (keep-alive)
+#define APP_KEEP_ALIVE_MAX              2       // Paused apps kept in memory, all displays (0 = always destroy)
+#define APP_KEEP_ALIVE_MIN_FREE_HEAP    98304   // Evict paused apps while free heap is below this (bytes)
+
+// App Load Profiler (GET /api/perf)
+#define APP_PROFILER_MAX_APPS           32      // Apps with load/unload histograms
+#define APP_PROFILER_BUCKETS            14      // Histogram buckets: <250 us, doubling, last open (>= 1 s)
+
+// App State Journal (LittleFS)
+#define STATE_JOURNAL_MAX_RECORD        65536   // Largest app state on the journal (bytes, MessagePack)
+#define STATE_JOURNAL_COMPACT_MIN_BYTES 65536   // Don't compact a journal smaller than this (bytes)
+#define STATE_CACHE_MAX_BYTES           4096    // States up to this size also stay in RAM after a commit
+
+// Event System
+#define EVENT_QUEUE_SIZE                32      // Events from other tasks / ISRs awaiting dispatch (power of 2)
+#define EVENT_PAYLOAD_TEXT_MAX          32      // Text payload bytes, including the terminator
+
+// Tracing (-DDOKI_TRACE, GET /api/trace)
+#define TRACE_BUFFER_EVENTS             1024    // Most recent spans/instants kept per core (power of 2)
+#define TRACE_MAX_TASKS                 24      // Tasks named on the timeline, later ones show as "other"
 
 // Animation System
 #define ANIMATION_POOL_SIZE_KB          1024    // Total PSRAM for animations (1MB)
@@ -90,15 +133,27 @@
 #define TASK_STACK_DISPLAY              8192    // Display rendering task
 #define TASK_STACK_NTP_SYNC             4096    // NTP background sync
 #define TASK_STACK_WEBSOCKET            4096    // WebSocket handling
+#define TASK_STACK_LOGGER               3072    // Log drain to Serial
+#define TASK_STACK_JS_POOL              6144    // JS context pre-build / teardown
+#define TASK_STACK_JS_HTTP              8192    // Async httpGet() worker (TLS needs the room)
+#define TASK_STACK_WEATHER              8192    // WeatherService background fetch
 
 // Task Priorities (0-25, higher = more priority)
 #define TASK_PRIORITY_DISPLAY           2       // Display rendering priority
 #define TASK_PRIORITY_NETWORK           1       // Network operations priority
 #define TASK_PRIORITY_NTP               1       // NTP sync priority (low, background)
+#define TASK_PRIORITY_LOGGER            1       // Log drain priority (low, background)
+#define TASK_PRIORITY_JS_POOL           1       // JS context pool priority (low, background)
+#define TASK_PRIORITY_JS_HTTP           1       // Async httpGet() worker priority
+#define TASK_PRIORITY_WEATHER           1       // Weather fetch priority (low, background)
 
 // Task Core Assignment (0 or 1)
 #define TASK_CORE_NETWORK               0       // Core 0 for network operations
 #define TASK_CORE_DISPLAY               1       // Core 1 for display rendering
+#define TASK_CORE_LOGGER                0       // Core 0, away from the UI loop
+#define TASK_CORE_JS_POOL               0       // Core 0, away from the UI loop
+#define TASK_CORE_JS_HTTP               0       // Core 0 for network operations
+#define TASK_CORE_WEATHER               0       // Core 0 for network operations
 
 // FreeRTOS
 #define FREERTOS_TICK_RATE_HZ           1000    // OS tick rate (default is usually fine)
@@ -16,6 +16,18 @@
 #define UPDATE_INTERVAL_CLOCK_MS        1000    // Clock refresh (1 second)
 #define UPDATE_INTERVAL_SYSINFO_MS      2000    // System info refresh (2 seconds)
 #define UPDATE_INTERVAL_DISPLAY_MS      1000    // General display update (1 second)
+#define UPDATE_ALIGN_SLACK_MS           2       // Run aligned updates this far past the boundary
+
+// Main Loop
+#define LOOP_MAX_IDLE_MS                20      // Longest sleep between app deadlines
+
+// LVGL Render Task
+#define LVGL_RENDER_MAX_IDLE_MS         20      // Longest sleep between lv_timer_handler() calls
+#define LVGL_LOCK_SLOW_HOLD_MS          100     // Warn when one LVGL lock hold runs longer
+
+// App State Persistence
+#define STATE_FLUSH_QUIET_MS            5000    // Commit pending states after this long without a save
+#define STATE_FLUSH_MAX_DELAY_MS        30000   // ...but no later than this after the first change
 
 // Network Services
 #define UPDATE_INTERVAL_WEATHER_MS      600000  // Weather fetch (10 minutes)
@@ -24,6 +36,12 @@
 #define UPDATE_INTERVAL_MQTT_CHECK_MS   100     // MQTT message check (100ms)
 #define UPDATE_INTERVAL_WS_POLL_MS      20      // WebSocket poll (20ms)
 
+// Logging
+#define UPDATE_INTERVAL_LOG_DRAIN_MS    20      // Log ring drain poll when idle
+
+// JavaScript Context Pool
+#define UPDATE_INTERVAL_JS_POOL_MS      5000    // Pool refill retry (e.g. after low heap)
+
 // Multi-Display Coordination
 #define UPDATE_INTERVAL_DISPLAY_SYNC_MS 5000    // Inter-display sync (5 seconds)
 
@@ -46,10 +64,20 @@
 
 // Application Timeouts
 #define TIMEOUT_APP_LOAD_MS             5000    // Max time to load app
-#define TIMEOUT_JS_EXECUTION_MS         1000    // JavaScript execution limit
+#define TIMEOUT_JS_EXECUTION_MS         1000    // JavaScript execution limit (per call)
 #define TIMEOUT_ANIMATION_LOAD_MS       5000    // Max time to load animation
 #define TIMEOUT_ANIMATION_DOWNLOAD_MS   30000   // Max time to download sprite (30s)
 
+// JavaScript CPU Budget
+#define JS_BUDGET_WINDOW_MS             1000    // Per-app JS CPU accounting window
+#define JS_BUDGET_PERCENT               25      // Max share of a window one app may spend in JS
+#define JS_THROTTLE_MAX_INTERVAL_MS     1600    // Slowest onUpdate() rate for a throttled app
+#define JS_BUDGET_MAX_STRIKES           10      // Over-budget windows at max throttle before termination
+
+// JavaScript Garbage Collection
+#define JS_GC_IDLE_MIN_SLACK_MS         4       // Idle time before the app's next callback needed for a GC
+#define JS_GC_IDLE_MIN_ALLOCS           512     // Allocations since the last GC before an idle GC is worth it
+
 // ==========================================
 // Delays
 // ==========================================
@@ -59,6 +87,7 @@
 #define DELAY_WEATHER_INIT_MS           5000    // Wait before first weather fetch
 #define DELAY_WS_INIT_MS                8000    // Wait before WebSocket connect
 #define DELAY_NTP_INIT_MS               2000    // Wait for WiFi stabilization
+#define DELAY_JS_POOL_START_MS          2000    // Wait before pre-building JS contexts
 
 // Retry Delays
 #define DELAY_WIFI_RETRY_MS             1000    // Between WiFi reconnection attempts
@@ -3097,6 +3097,44 @@ typedef struct duk_hthread duk_context;
 
 /* __OVERRIDE_DEFINES__ */
 
+/* Doki OS: per-call execution deadline, see JSEngine and
+ * TIMEOUT_JS_EXECUTION_MS.  The check runs on every executor interrupt
+ * (DUK_HTHREAD_INTCTR_DEFAULT bytecode instructions).
+ */
+#define DUK_USE_INTERRUPT_COUNTER
+#undef DUK_USE_EXEC_TIMEOUT_CHECK
+#define DUK_USE_EXEC_TIMEOUT_CHECK(udata) doki_js_exec_timeout_check((udata))
+#if defined(__cplusplus)
+extern "C"
+#endif
+duk_bool_t doki_js_exec_timeout_check(void *udata);
+
+/* Doki OS: low-memory build profile, selected with -DDOKI_DUK_LOWMEM.
+ * Only options that need no regenerated sources:
+ *   - fastint: integer arithmetic without soft-float doubles (the S3 FPU
+ *     is single precision only)
+ *   - built-in functions as lightfuncs instead of one object each per
+ *     heap (the RAM half of ROM built-ins)
+ *   - a 128-entry initial string table instead of 1024
+ *   - no CBOR and JX/JC encodings (unused by Doki OS); the generated
+ *     built-in data still creates the CBOR object, registerDokiAPIs()
+ *     deletes the global
+ * True ROM built-ins (DUK_USE_ROM_OBJECTS/ROM_STRINGS) need duktape.c to
+ * be regenerated, see docs/TECHNICAL_NOTES.md.
+ */
+#if defined(DOKI_DUK_LOWMEM)
+#define DUK_USE_FASTINT
+#define DUK_USE_LIGHTFUNC_BUILTINS
+#undef DUK_USE_STRTAB_MINSIZE
+#define DUK_USE_STRTAB_MINSIZE 128
+#undef DUK_USE_CBOR_SUPPORT
+#undef DUK_USE_CBOR_BUILTIN
+#undef DUK_USE_JX
+#undef DUK_USE_JC
+#undef DUK_USE_TRACEBACK_DEPTH
+#define DUK_USE_TRACEBACK_DEPTH 4
+#endif
+
 /*
  *  Conditional includes
  */
@@ -32698,7 +32698,10 @@ DUK_EXTERNAL void duk_cbor_decode(duk_hthread *thr, duk_idx_t idx, duk_uint_t de
 	duk__cbor_decode(thr, idx, decode_flags);
 }
 
-#if defined(DUK_USE_CBOR_BUILTIN)
+/* Doki OS: the generated native function table references these even
+ * without DUK_USE_CBOR_BUILTIN (DOKI_DUK_LOWMEM in duk_config.h).
+ */
+#if defined(DUK_USE_CBOR_BUILTIN) || defined(DOKI_DUK_LOWMEM)
 #if defined(DUK_USE_CBOR_SUPPORT)
 DUK_INTERNAL duk_ret_t duk_bi_cbor_encode(duk_hthread *thr) {
 	DUK_ASSERT_TOP(thr, 1);
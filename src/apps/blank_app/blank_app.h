@@ -53,6 +53,8 @@ public:
         // If you want animation, uncomment addZoomAnimation() above
     }
     
+    uint32_t getUpdateInterval() const override { return UPDATE_NEVER; }
+    
     void onPause() override {
         log("Screensaver paused");
     }
@@ -83,13 +83,17 @@ public:
         // Uptime
         _uptimeLabel = createInfoLabel(getScreen(), "", LV_ALIGN_BOTTOM_MID, 0, -10);
         
-        _lastUpdate = 0;
         _timeValid = false;
     }
     
     void onStart() override {
         log("Clock App started!");
         
+        // Resumed from keep-alive: the NTP task is still running
+        if (_ntpTaskHandle != nullptr) {
+            return;
+        }
+        
         // Start NTP client in BACKGROUND TASK (non-blocking!)
         _ntpClient->begin();
         
@@ -108,19 +112,19 @@ public:
     }
     
     void onUpdate() override {
-        uint32_t now = millis();
-        
-        // Update display every 1 second
-        if (now - _lastUpdate >= 1000) {
-            updateDisplay();
-            _lastUpdate = now;
-        }
+        updateDisplay();
     }
     
+    // Called once a second, on the second
+    uint32_t getUpdateInterval() const override { return UPDATE_INTERVAL_CLOCK_MS; }
+    bool alignUpdates() const override { return true; }
+    
     void onPause() override {
         log("Clock App paused");
     }
     
+    bool supportsKeepAlive() const override { return true; }
+    
     void onDestroy() override {
         log("Clock App destroyed");
         
@@ -159,7 +163,6 @@ private:
     WiFiUDP* _udp;
     TaskHandle_t _ntpTaskHandle;
     
-    uint32_t _lastUpdate;
     volatile bool _timeValid;  // Volatile because accessed from multiple tasks
     
     // Static task function for FreeRTOS
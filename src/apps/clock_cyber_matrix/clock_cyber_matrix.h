@@ -11,6 +11,7 @@
 #include "doki/app_base.h"
 #include "doki/lvgl_helpers.h"
 #include "doki/time_service.h"
+#include "timing_constants.h"
 #include "assets/fonts/fonts.h"
 #include <lvgl.h>
 #include <time.h>
@@ -27,12 +28,10 @@ private:
     lv_obj_t* _stepsLabel;         // Steps counter
     lv_obj_t* _batteryLabel;       // Battery percentage
 
-    uint32_t _lastUpdate;
     int _mockSteps;
 
 public:
     ClockCyberMatrixApp() : DokiApp("clock_cyber_matrix", "Clock: Cyber Matrix") {
-        _lastUpdate = 0;
         _mockSteps = 2444;
     }
 
@@ -50,22 +49,22 @@ public:
     void onStart() override {}
 
     void onUpdate() override {
-        uint32_t now = millis();
-
-        // Update every second
-        if (now - _lastUpdate >= 1000) {
-            _lastUpdate = now;
-            updateDisplay();
+        updateDisplay();
 
-            // Simulate step increments
-            if (rand() % 30 == 0) {
-                _mockSteps += rand() % 5;
-            }
+        // Simulate step increments
+        if (rand() % 30 == 0) {
+            _mockSteps += rand() % 5;
         }
     }
 
+    // Called once a second, on the second
+    uint32_t getUpdateInterval() const override { return UPDATE_INTERVAL_CLOCK_MS; }
+    bool alignUpdates() const override { return true; }
+
     void onPause() override {}
 
+    bool supportsKeepAlive() const override { return true; }
+
     void onDestroy() override {}
 
 private:
@@ -12,6 +12,7 @@
 #include "doki/app_base.h"
 #include "doki/lvgl_helpers.h"
 #include "doki/time_service.h"
+#include "timing_constants.h"
 #include "assets/fonts/fonts.h"
 #include <lvgl.h>
 #include <time.h>
@@ -33,12 +34,8 @@ private:
     lv_obj_t* _humidityValue;
     lv_obj_t* _ampmLabel;         // Right bottom
 
-    uint32_t _lastUpdate;
-
 public:
-    ClockFitnessProApp() : DokiApp("clock_fitness_pro", "Clock: Fitness Pro") {
-        _lastUpdate = 0;
-    }
+    ClockFitnessProApp() : DokiApp("clock_fitness_pro", "Clock: Fitness Pro") {}
 
     void onCreate() override {
         // Black background
@@ -54,17 +51,17 @@ public:
     void onStart() override {}
 
     void onUpdate() override {
-        uint32_t now = millis();
-
-        // Update every second
-        if (now - _lastUpdate >= 1000) {
-            _lastUpdate = now;
-            updateDisplay();
-        }
+        updateDisplay();
     }
 
+    // Called once a second, on the second
+    uint32_t getUpdateInterval() const override { return UPDATE_INTERVAL_CLOCK_MS; }
+    bool alignUpdates() const override { return true; }
+
     void onPause() override {}
 
+    bool supportsKeepAlive() const override { return true; }
+
     void onDestroy() override {}
 
 private:
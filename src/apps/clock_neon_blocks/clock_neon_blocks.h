@@ -11,6 +11,7 @@
 #include "doki/app_base.h"
 #include "doki/lvgl_helpers.h"
 #include "doki/time_service.h"
+#include "timing_constants.h"
 #include "assets/fonts/fonts.h"
 #include <lvgl.h>
 #include <time.h>
@@ -41,13 +42,8 @@ private:
     lv_obj_t* _humidityLabel;
     lv_obj_t* _humidityValue;
 
-    // Update tracking
-    uint32_t _lastUpdate;
-
 public:
-    ClockNeonBlocksApp() : DokiApp("clock_neon_blocks", "Clock: Neon Blocks") {
-        _lastUpdate = 0;
-    }
+    ClockNeonBlocksApp() : DokiApp("clock_neon_blocks", "Clock: Neon Blocks") {}
 
     void onCreate() override {
         // Black background
@@ -63,17 +59,17 @@ public:
     void onStart() override {}
 
     void onUpdate() override {
-        uint32_t now = millis();
-
-        // Update every second
-        if (now - _lastUpdate >= 1000) {
-            _lastUpdate = now;
-            updateDisplay();
-        }
+        updateDisplay();
     }
 
+    // Called once a second, on the second
+    uint32_t getUpdateInterval() const override { return UPDATE_INTERVAL_CLOCK_MS; }
+    bool alignUpdates() const override { return true; }
+
     void onPause() override {}
 
+    bool supportsKeepAlive() const override { return true; }
+
     void onDestroy() override {}
 
 private:
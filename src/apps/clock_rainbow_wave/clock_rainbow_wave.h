@@ -11,6 +11,7 @@
 #include "doki/app_base.h"
 #include "doki/lvgl_helpers.h"
 #include "doki/time_service.h"
+#include "timing_constants.h"
 #include "assets/fonts/fonts.h"
 #include <lvgl.h>
 #include <time.h>
@@ -24,12 +25,8 @@ private:
     lv_obj_t* _weatherLabel;     // Weather temp
     lv_obj_t* _weatherIcon;      // Weather icon placeholder
 
-    uint32_t _lastUpdate;
-
 public:
-    ClockRainbowWaveApp() : DokiApp("clock_rainbow_wave", "Clock: Rainbow Wave") {
-        _lastUpdate = 0;
-    }
+    ClockRainbowWaveApp() : DokiApp("clock_rainbow_wave", "Clock: Rainbow Wave") {}
 
     void onCreate() override {
         // Create vibrant gradient background (deep blue to purple)
@@ -45,17 +42,17 @@ public:
     void onStart() override {}
 
     void onUpdate() override {
-        uint32_t now = millis();
-
-        // Update every second
-        if (now - _lastUpdate >= 1000) {
-            _lastUpdate = now;
-            updateDisplay();
-        }
+        updateDisplay();
     }
 
+    // Called once a second, on the second
+    uint32_t getUpdateInterval() const override { return UPDATE_INTERVAL_CLOCK_MS; }
+    bool alignUpdates() const override { return true; }
+
     void onPause() override {}
 
+    bool supportsKeepAlive() const override { return true; }
+
     void onDestroy() override {}
 
 private:
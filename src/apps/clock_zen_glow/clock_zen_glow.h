@@ -11,6 +11,7 @@
 #include "doki/app_base.h"
 #include "doki/lvgl_helpers.h"
 #include "doki/time_service.h"
+#include "timing_constants.h"
 #include "assets/fonts/fonts.h"
 #include <lvgl.h>
 #include <time.h>
@@ -24,12 +25,8 @@ private:
     lv_obj_t* _dateLabel;        // Date (TUE 09)
     lv_obj_t* _glowCircle;       // Orange glow element at bottom
 
-    uint32_t _lastUpdate;
-
 public:
-    ClockZenGlowApp() : DokiApp("clock_zen_glow", "Clock: Zen Glow") {
-        _lastUpdate = 0;
-    }
+    ClockZenGlowApp() : DokiApp("clock_zen_glow", "Clock: Zen Glow") {}
 
     void onCreate() override {
         // Black background
@@ -48,17 +45,17 @@ public:
     void onStart() override {}
 
     void onUpdate() override {
-        uint32_t now = millis();
-
-        // Update every second
-        if (now - _lastUpdate >= 1000) {
-            _lastUpdate = now;
-            updateDisplay();
-        }
+        updateDisplay();
     }
 
+    // Called once a second, on the second
+    uint32_t getUpdateInterval() const override { return UPDATE_INTERVAL_CLOCK_MS; }
+    bool alignUpdates() const override { return true; }
+
     void onPause() override {}
 
+    bool supportsKeepAlive() const override { return true; }
+
     void onDestroy() override {}
 
 private:
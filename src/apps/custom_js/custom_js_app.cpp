@@ -10,8 +10,6 @@
 
 CustomJSApp::CustomJSApp()
     : JSApp("custom", "Custom JS", "/js/custom_disp0.js")  // Default path, will be updated
-    , _lastWatchdogReset(0)
-    , _creationStartTime(0)
 {
     // Update script path based on which display this app is running on
     // This will be determined when setDisplay() is called by AppManager
@@ -22,9 +20,6 @@ CustomJSApp::~CustomJSApp() {
 }
 
 void CustomJSApp::onCreate() {
-    _creationStartTime = millis();
-    _resetWatchdog();
-
     // Determine which display we're on and update the script path
     uint8_t displayId = getDisplayId();
     char scriptPath[32];
@@ -93,29 +88,8 @@ void CustomJSApp::onCreate() {
     }
 
     // Call parent onCreate to load and execute the script
+    // (JSApp stops it with an error screen if it exceeds TIMEOUT_JS_EXECUTION_MS)
     JSApp::onCreate();
-
-    // Check for watchdog timeout during onCreate
-    if (_watchdogTimeout()) {
-        Serial.println("[CustomJSApp] ✗ Watchdog timeout during onCreate!");
-        _showError("Script timeout\n(infinite loop?)");
-    }
-
-    _resetWatchdog();
-}
-
-void CustomJSApp::onUpdate() {
-    // Reset watchdog before update
-    _resetWatchdog();
-
-    // Call parent onUpdate
-    JSApp::onUpdate();
-
-    // Check for timeout after update
-    if (_watchdogTimeout()) {
-        Serial.println("[CustomJSApp] ✗ Watchdog timeout during onUpdate!");
-        // Don't show error repeatedly, just log it
-    }
 }
 
 bool CustomJSApp::hasCustomCode() {
@@ -131,12 +105,3 @@ bool CustomJSApp::hasCustomCode() {
     size_t size = Doki::FilesystemManager::getFileSize(scriptPath);
     return size > 0;
 }
-
-void CustomJSApp::_resetWatchdog() {
-    _lastWatchdogReset = millis();
-}
-
-bool CustomJSApp::_watchdogTimeout() {
-    uint32_t elapsed = millis() - _lastWatchdogReset;
-    return elapsed > WATCHDOG_TIMEOUT;
-}
@@ -26,7 +26,7 @@
  * @brief Custom JavaScript App
  *
  * Loads and executes user-provided JavaScript code from SPIFFS.
- * Includes watchdog protection and memory monitoring.
+ * Runaway scripts are stopped by JSApp's execution deadline and CPU budget.
  */
 class CustomJSApp : public Doki::JSApp {
 public:
@@ -43,31 +43,17 @@ public:
      */
     virtual ~CustomJSApp();
 
-    // Override lifecycle to add watchdog protection
+    // Override to resolve the per-display script path
     void onCreate() override;
-    void onUpdate() override;
+
+    // Never kept resident: loading the app again must pick up edited code
+    bool supportsKeepAlive() const override { return false; }
 
     /**
      * @brief Check if custom JS file exists for this app
      * @return true if the JS file exists in SPIFFS
      */
     bool hasCustomCode();
-
-private:
-    uint32_t _lastWatchdogReset;     ///< Last time watchdog was reset
-    uint32_t _creationStartTime;     ///< onCreate start time
-    static const uint32_t WATCHDOG_TIMEOUT = 5000;  ///< 5 second timeout
-
-    /**
-     * @brief Reset watchdog timer
-     */
-    void _resetWatchdog();
-
-    /**
-     * @brief Check if watchdog has timed out
-     * @return true if execution has exceeded timeout
-     */
-    bool _watchdogTimeout();
 };
 
 #endif // CUSTOM_JS_APP_H
@@ -87,6 +87,8 @@ public:
         // No manual frame management needed
     }
 
+    uint32_t getUpdateInterval() const override { return UPDATE_NEVER; }
+
     void onPause() override {
         log("GIF Player paused");
         // Optional: Pause GIF animation
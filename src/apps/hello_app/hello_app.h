@@ -10,6 +10,7 @@
 #define HELLO_APP_H
 
 #include "doki/app_base.h"
+#include "timing_constants.h"
 
 class HelloApp : public Doki::DokiApp {
 public:
@@ -28,8 +29,6 @@ public:
         _uptimeLabel = lv_label_create(getScreen());
         lv_label_set_text(_uptimeLabel, "Uptime: 0s");
         lv_obj_align(_uptimeLabel, LV_ALIGN_CENTER, 0, 20);
-        
-        _lastUpdate = 0;  // Force update on first call
     }
     
     void onStart() override {
@@ -37,17 +36,15 @@ public:
     }
     
     void onUpdate() override {
-        // Update every 1 second
-        uint32_t now = millis();
-        if (now - _lastUpdate >= 1000) {
-            uint32_t uptime = getUptime() / 1000;  // Convert to seconds
-            char buf[32];
-            snprintf(buf, sizeof(buf), "Uptime: %lus", uptime);
-            lv_label_set_text(_uptimeLabel, buf);
-            _lastUpdate = now;
-        }
+        uint32_t uptime = getUptime() / 1000;  // Convert to seconds
+        char buf[32];
+        snprintf(buf, sizeof(buf), "Uptime: %lus", uptime);
+        lv_label_set_text(_uptimeLabel, buf);
     }
     
+    // Update every 1 second
+    uint32_t getUpdateInterval() const override { return UPDATE_INTERVAL_DISPLAY_MS; }
+    
     void onPause() override {
         log("Hello App paused");
     }
@@ -60,7 +57,6 @@ public:
 private:
     lv_obj_t* _label;
     lv_obj_t* _uptimeLabel;
-    uint32_t _lastUpdate;
 };
 
 #endif // HELLO_APP_H
\ No newline at end of file
@@ -115,6 +115,8 @@ public:
         // Static image - no updates needed
     }
 
+    uint32_t getUpdateInterval() const override { return UPDATE_NEVER; }
+
     void onPause() override {
         log("Image Preview paused");
     }
@@ -7,6 +7,7 @@
 #define SYSINFO_APP_H
 
 #include "doki/app_base.h"
+#include "timing_constants.h"
 #include <WiFi.h>
 
 class SysInfoApp : public Doki::DokiApp {
@@ -102,8 +103,6 @@ public:
         lv_obj_align(_appUptimeLabel, LV_ALIGN_TOP_RIGHT, -10, 255);
         lv_obj_set_style_text_font(_appUptimeLabel, &lv_font_montserrat_12, 0);
         
-        _lastUpdate = 0;
-        
         // Fade in
         lv_obj_set_style_opa(getScreen(), LV_OPA_0, 0);
         lv_obj_fade_in(getScreen(), 350, 0);
@@ -114,19 +113,17 @@ public:
     }
     
     void onUpdate() override {
-        uint32_t now = millis();
-        
-        // Update every second
-        if (now - _lastUpdate >= 1000) {
-            updateDisplay();
-            _lastUpdate = now;
-        }
+        updateDisplay();
     }
     
+    uint32_t getUpdateInterval() const override { return UPDATE_INTERVAL_DISPLAY_MS; }
+    
     void onPause() override {
         log("System Info App paused");
     }
     
+    bool supportsKeepAlive() const override { return true; }
+    
     void onDestroy() override {
         log("System Info App destroyed");
     }
@@ -146,8 +143,6 @@ private:
     lv_obj_t* _tempLabel;
     lv_obj_t* _appUptimeLabel;
     
-    uint32_t _lastUpdate;
-    
     void updateDisplay() {
         // System uptime
         uint32_t uptime = millis() / 1000;
@@ -113,7 +113,7 @@ public:
         
         _lastUpdate = 0;
         _lastWeatherFetch = 0;
-        _lastAnimation = 0;
+        _fetchPending = false;
         _location = "Mumbai";
         _animPhase = 0;
         
@@ -135,23 +135,30 @@ public:
             _lastWeatherFetch = now;
         }
         
+        // Pick up a finished background fetch
+        if (_fetchPending) {
+            checkWeather();
+        }
+        
         // Update status every 1 second
         if (now - _lastUpdate >= 1000) {
             updateStatus();
             _lastUpdate = now;
         }
         
-        // Simple icon pulse at 10 FPS (100ms interval)
-        if (now - _lastAnimation >= 100) {
-            animateWeatherIcon();
-            _lastAnimation = now;
-        }
+        // Simple icon pulse, one step per update
+        animateWeatherIcon();
     }
     
+    // 10 FPS for the icon pulse
+    uint32_t getUpdateInterval() const override { return 100; }
+    
     void onPause() override {
         log("Weather App paused");
     }
     
+    bool supportsKeepAlive() const override { return true; }
+    
     void onDestroy() override {
         log("Weather App destroyed");
     }
@@ -173,21 +180,40 @@ private:
     Doki::WeatherData _currentWeather;
     uint32_t _lastUpdate;
     uint32_t _lastWeatherFetch;
-    uint32_t _lastAnimation;
+    bool _fetchPending;
     float _animPhase;
     
     void fetchWeather() {
         log(("Fetching weather for " + _location).c_str());
         
-        if (Doki::WeatherService::getCurrentWeather(_location, _currentWeather)) {
-            updateWeatherDisplay();
-            log("Weather updated successfully");
+        // The request runs on WeatherService's task; onUpdate() collects it
+        _fetchPending = Doki::WeatherService::requestWeather(_location);
+        if (_fetchPending) {
+            checkWeather();  // Cached data is ready right away
         } else {
             log("Failed to fetch weather");
             lv_label_set_text(_statusLabel, "Failed to fetch");
         }
     }
     
+    void checkWeather() {
+        switch (Doki::WeatherService::pollWeather(_location, _currentWeather)) {
+            case Doki::WeatherService::FetchStatus::PENDING:
+                return;
+            
+            case Doki::WeatherService::FetchStatus::READY:
+                updateWeatherDisplay();
+                log("Weather updated successfully");
+                break;
+            
+            case Doki::WeatherService::FetchStatus::FAILED:
+                log("Failed to fetch weather");
+                lv_label_set_text(_statusLabel, "Failed to fetch");
+                break;
+        }
+        _fetchPending = false;
+    }
+    
     void updateWeatherDisplay() {
         if (!_currentWeather.valid) return;
         
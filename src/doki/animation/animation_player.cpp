@@ -5,6 +5,7 @@
 
 #include "doki/animation/animation_player.h"
 #include "doki/lvgl_manager.h"
+#include "doki/tracer.h"
 #include <esp_heap_caps.h>
 
 namespace Doki {
@@ -147,6 +148,8 @@ bool AnimationPlayer::update() {
         return false;
     }
 
+    DOKI_TRACE_SCOPE("animation", "frame");
+
     _currentFrame = nextFrame;
     _lastFrameTime = millis();
 
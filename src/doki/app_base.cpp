@@ -18,6 +18,8 @@ DokiApp::DokiApp(const char* id, const char* name)
     , _display(nullptr)
     , _state(AppState::IDLE)
     , _startTime(0)
+    , _updateRequested(false)
+    , _updateRequestedAt(0)
 {
     // Constructor - app is in IDLE state
     Serial.printf("[DokiApp] Created app: %s (%s)\n", _name, _id);
@@ -104,4 +106,9 @@ void DokiApp::log(const char* message) {
     Serial.printf("[DokiApp:%s] %s\n", _id, message);
 }
 
+void DokiApp::requestUpdate(uint32_t delayMs) {
+    _updateRequestedAt = millis() + delayMs;
+    _updateRequested = true;
+}
+
 } // namespace Doki
\ No newline at end of file
@@ -9,7 +9,13 @@
 #include "doki/task_scheduler.h"
 #include "doki/state_persistence.h"
 #include "doki/lvgl_manager.h"
+#include "doki/app_profiler.h"
+#include "doki/tracer.h"
+#include "hardware_config.h"
+#include "timing_constants.h"
 #include <ArduinoJson.h>
+#include <algorithm>
+#include <sys/time.h>
 
 namespace Doki {
 
@@ -21,6 +27,13 @@ bool AppManager::_initialized = false;
 uint8_t AppManager::_numDisplays = 0;
 std::vector<DisplayState> AppManager::_displays;
 std::map<std::string, AppRegistration> AppManager::_registry;
+std::vector<ResidentApp> AppManager::_resident;
+std::vector<UpdateDeadline> AppManager::_deadlines;
+
+// Heap order for _deadlines: earliest due on top (wrap-safe)
+static bool _dueLater(const UpdateDeadline& a, const UpdateDeadline& b) {
+    return (int32_t)(a.due - b.due) > 0;
+}
 
 // ========================================
 // Public Methods
@@ -54,9 +67,12 @@ bool AppManager::init(uint8_t numDisplays, lv_disp_t** displays) {
             return false;
         }
         _displays.push_back(DisplayState(i, displays[i]));
+        _displays.back().baseScreen = lv_disp_get_scr_act(displays[i]);
         Serial.printf("[AppManager] Display %d initialized\n", i);
     }
 
+    AppProfiler::init();
+
     _initialized = true;
     Serial.println("[AppManager] ✓ Initialization complete");
 
@@ -110,6 +126,13 @@ bool AppManager::loadApp(uint8_t displayId, const char* appId) {
         return false;
     }
 
+    _beginSwitch(displayId);
+    bool ok = _loadApp(displayId, appId, reg);
+    _endSwitch(displayId);
+    return ok;
+}
+
+bool AppManager::_loadApp(uint8_t displayId, const char* appId, AppRegistration* reg) {
     DisplayState& display = _displays[displayId];
 
     // If same app already running on this display, do nothing
@@ -118,11 +141,39 @@ bool AppManager::loadApp(uint8_t displayId, const char* appId) {
         return true;
     }
 
-    // Unload current app if any
+    uint32_t switchStart = micros();
+
+    // Take the target out of the resident list first, so parking the
+    // current app cannot evict it
+    ResidentApp resumed;
+    int residentIndex = _findResident(displayId, appId);
+    if (residentIndex >= 0) {
+        resumed = _resident[residentIndex];
+        _resident.erase(_resident.begin() + residentIndex);
+    }
+
+    // Pause or unload current app if any
     if (display.currentApp) {
-        Serial.printf("[AppManager] Unloading '%s' from display %d before loading '%s'\n",
-                      display.currentAppId.c_str(), displayId, appId);
-        unloadApp(displayId);
+        if (display.currentApp->supportsKeepAlive() && APP_KEEP_ALIVE_MAX > 0) {
+            Serial.printf("[AppManager] Pausing '%s' on display %d before loading '%s'\n",
+                          display.currentAppId.c_str(), displayId, appId);
+            _park(displayId);
+        } else {
+            Serial.printf("[AppManager] Unloading '%s' from display %d before loading '%s'\n",
+                          display.currentAppId.c_str(), displayId, appId);
+            _unloadApp(displayId);
+        }
+    }
+
+    // Still in memory from an earlier visit: show its screen again
+    if (residentIndex >= 0) {
+        _resume(displayId, resumed);
+        uint32_t switchUs = micros() - switchStart;
+        AppProfiler::record(appId, AppProfiler::PHASE_RESUME, switchUs);
+        AppProfiler::expectFrame(displayId, appId, switchStart);
+        Serial.printf("[AppManager] ✓ App '%s' resumed on display %d in %lu us\n\n",
+                      reg->name.c_str(), displayId, (unsigned long)switchUs);
+        return true;
     }
 
     Serial.println("╔═══════════════════════════════════╗");
@@ -136,69 +187,99 @@ bool AppManager::loadApp(uint8_t displayId, const char* appId) {
 
     // Create app instance using factory
     Serial.printf("[AppManager] Creating app instance...\n");
-    display.currentApp = reg->factory();
+    uint32_t phaseStart = micros();
+    DokiApp* app = reg->factory();
+    AppProfiler::record(appId, AppProfiler::PHASE_FACTORY, micros() - phaseStart);
 
-    if (!display.currentApp) {
+    if (!app) {
         Serial.printf("[AppManager] Error: Failed to create app '%s'\n", appId);
         MemoryManager::stopTracking(trackingId);
         return false;
     }
 
-    display.currentAppId = appId;
-
     // Set the app's display
-    display.currentApp->setDisplay(display.lvglDisplay);
+    app->setDisplay(display.lvglDisplay);
 
-    // CRITICAL: Acquire LVGL mutex before any LVGL operations
-    LVGLManager::lock();
+    // CRITICAL: Acquire LVGL mutex before any LVGL operations, and swap
+    // the current app under it (other tasks read it under the same lock)
+    LVGLManager::lock(displayId);
+    display.currentApp = app;
+    display.currentAppId = appId;
 
     // CRITICAL: Set LVGL default display BEFORE onCreate()
     // This ensures all UI elements are created on the correct display
     lv_disp_set_default(display.lvglDisplay);
 
-    // Clear the screen to ensure clean slate (removes any remnants from previous app)
-    Serial.printf("[AppManager] Clearing screen...\n");
-    lv_obj_t* screen = lv_disp_get_scr_act(display.lvglDisplay);
-    if (screen) {
-        lv_obj_clean(screen);
+    phaseStart = micros();
+    lv_obj_t* screen = nullptr;
+    if (display.currentApp->supportsKeepAlive() && APP_KEEP_ALIVE_MAX > 0) {
+        // Own screen, so the app can stay resident when another app takes over
+        screen = lv_obj_create(NULL);
         lv_obj_set_style_bg_color(screen, lv_color_hex(0x000000), 0); // Black background
-        Serial.printf("[AppManager] ✓ Screen cleared\n");
+        lv_scr_load(screen);
+        display.appScreen = screen;
+    } else {
+        // Clear the shared screen to ensure clean slate (removes any remnants from previous app)
+        Serial.printf("[AppManager] Clearing screen...\n");
+        screen = display.baseScreen;
+        if (screen && lv_disp_get_scr_act(display.lvglDisplay) != screen) {
+            lv_scr_load(screen);
+        }
+        if (screen) {
+            lv_obj_clean(screen);
+            lv_obj_set_style_bg_color(screen, lv_color_hex(0x000000), 0); // Black background
+            Serial.printf("[AppManager] ✓ Screen cleared\n");
+        }
     }
+    AppProfiler::record(appId, AppProfiler::PHASE_CLEAN, micros() - phaseStart);
 
     // Publish APP_LOADED event
-    EventSystem::publish(EventType::APP_LOADED, "AppManager", (void*)appId);
+    EventSystem::publish(EventType::APP_LOADED, "AppManager", EventPayload::fromText(appId));
 
     // Call onCreate (may create LVGL objects)
     Serial.printf("[AppManager] Calling onCreate()...\n");
+    phaseStart = micros();
     display.currentApp->onCreate();
     display.currentApp->_setState(AppState::CREATED);
+    AppProfiler::record(appId, AppProfiler::PHASE_ON_CREATE, micros() - phaseStart);
 
     // Release LVGL mutex after onCreate
     LVGLManager::unlock();
 
-    // Restore state if it exists
-    if (StatePersistence::hasState(appId)) {
-        Serial.printf("[AppManager] Restoring saved state...\n");
-        JsonDocument state;
-        if (StatePersistence::loadState(appId, state)) {
-            const JsonDocument& constState = state;
-            display.currentApp->onRestoreState(constState);
-            Serial.printf("[AppManager] ✓ State restored\n");
-        }
+    // Restore state if it exists (served from the state cache after the first load)
+    JsonDocument state;
+    phaseStart = micros();
+    bool loaded = StatePersistence::loadState(appId, state);
+    AppProfiler::record(appId, AppProfiler::PHASE_LOAD_STATE, micros() - phaseStart);
+
+    // onRestoreState and onStart may modify LVGL objects
+    LVGLManager::lock(displayId);
+    if (loaded) {
+        const JsonDocument& constState = state;
+        phaseStart = micros();
+        display.currentApp->onRestoreState(constState);
+        AppProfiler::record(appId, AppProfiler::PHASE_RESTORE_STATE, micros() - phaseStart);
+        Serial.printf("[AppManager] ✓ State restored\n");
     }
 
-    // Call onStart (may modify LVGL objects)
-    LVGLManager::lock();
     Serial.printf("[AppManager] Calling onStart()...\n");
+    phaseStart = micros();
     display.currentApp->onStart();
     display.currentApp->_setState(AppState::STARTED);
     display.currentApp->_markStarted();
+    AppProfiler::record(appId, AppProfiler::PHASE_ON_START, micros() - phaseStart);
+    _beginUpdates(displayId);
     LVGLManager::unlock();
 
     // Publish APP_STARTED event
-    EventSystem::publish(EventType::APP_STARTED, "AppManager", (void*)appId);
+    EventSystem::publish(EventType::APP_STARTED, "AppManager", EventPayload::fromText(appId));
+
+    uint32_t switchUs = micros() - switchStart;
+    AppProfiler::record(appId, AppProfiler::PHASE_LOAD, switchUs);
+    AppProfiler::expectFrame(displayId, appId, switchStart);
 
-    Serial.printf("[AppManager] ✓ App '%s' loaded on display %d\n", reg->name.c_str(), displayId);
+    Serial.printf("[AppManager] ✓ App '%s' loaded on display %d in %lu us\n", reg->name.c_str(), displayId,
+                  (unsigned long)switchUs);
     Serial.printf("[AppManager] Uptime: 0ms\n\n");
 
     return true;
@@ -215,6 +296,13 @@ bool AppManager::unloadApp(uint8_t displayId) {
         return false;
     }
 
+    _beginSwitch(displayId);
+    bool ok = _unloadApp(displayId);
+    _endSwitch(displayId);
+    return ok;
+}
+
+bool AppManager::_unloadApp(uint8_t displayId) {
     DisplayState& display = _displays[displayId];
 
     if (!display.currentApp) {
@@ -223,6 +311,7 @@ bool AppManager::unloadApp(uint8_t displayId) {
     }
 
     const char* appId = display.currentAppId.c_str();
+    uint32_t unloadStart = micros();
 
     Serial.println("╔═══════════════════════════════════╗");
     Serial.printf("║ Display %d: Unloading %-12s ║\n", displayId, display.currentApp->getName());
@@ -233,41 +322,49 @@ bool AppManager::unloadApp(uint8_t displayId) {
     Serial.printf("[AppManager] App uptime: %lu ms\n", uptime);
 
     // Publish APP_PAUSED event
-    EventSystem::publish(EventType::APP_PAUSED, "AppManager", (void*)appId);
+    EventSystem::publish(EventType::APP_PAUSED, "AppManager", EventPayload::fromText(appId));
+
+    // Held through the teardown: it touches LVGL, and other tasks only
+    // look at currentApp under this lock
+    LVGLManager::lock(displayId);
 
     // Call onPause
     Serial.printf("[AppManager] Calling onPause()...\n");
+    uint32_t phaseStart = micros();
     display.currentApp->onPause();
     display.currentApp->_setState(AppState::PAUSED);
+    AppProfiler::record(appId, AppProfiler::PHASE_ON_PAUSE, micros() - phaseStart);
 
     // Save state before destroying
-    Serial.printf("[AppManager] Saving app state...\n");
-    JsonDocument state;
-    display.currentApp->onSaveState(state);
-    if (state.size() > 0) {
-        if (StatePersistence::saveState(appId, state)) {
-            Serial.printf("[AppManager] ✓ State saved\n");
-        } else {
-            Serial.printf("[AppManager] ⚠️  Failed to save state\n");
-        }
-    } else {
-        Serial.printf("[AppManager] No state to save\n");
-    }
+    _saveAppState(display.currentApp, appId);
 
     // Call onDestroy
     Serial.printf("[AppManager] Calling onDestroy()...\n");
+    phaseStart = micros();
     display.currentApp->onDestroy();
     display.currentApp->_setState(AppState::DESTROYED);
 
     // Delete app instance
     delete display.currentApp;
     display.currentApp = nullptr;
+    AppProfiler::record(appId, AppProfiler::PHASE_ON_DESTROY, micros() - phaseStart);
+
+    // Drop the app's own screen (keep-alive apps)
+    if (display.appScreen) {
+        lv_scr_load(display.baseScreen);
+        lv_obj_del(display.appScreen);
+        display.appScreen = nullptr;
+    }
+
+    LVGLManager::unlock();
 
     // Cleanup resources (tasks, memory tracking) - AFTER deletion
     _cleanupApp(displayId, appId);
 
     // Publish APP_UNLOADED event
-    EventSystem::publish(EventType::APP_UNLOADED, "AppManager", (void*)appId);
+    EventSystem::publish(EventType::APP_UNLOADED, "AppManager", EventPayload::fromText(appId));
+
+    AppProfiler::record(appId, AppProfiler::PHASE_UNLOAD, micros() - unloadStart);
 
     Serial.printf("[AppManager] ✓ Display %d: App '%s' unloaded\n\n", displayId, appId);
 
@@ -279,18 +376,95 @@ bool AppManager::unloadApp(uint8_t displayId) {
 void AppManager::update() {
     if (!_initialized) return;
 
-    // Acquire LVGL mutex before updating apps (they may modify LVGL)
+    DOKI_TRACE_SCOPE("app", "AppManager::update");
+
+    uint32_t now = millis();
+
+    // Short hold: drain requests and pick the apps that are due
     LVGLManager::lock();
 
-    // Update all running apps across all displays
     for (auto& display : _displays) {
-        if (display.currentApp && display.currentApp->isRunning()) {
-            display.currentApp->onUpdate();
+        DokiApp* app = display.currentApp;
+        if (display.switchTask || !app || !app->isRunning()) continue;
+
+        // requestUpdate() calls join the heap as one-off deadlines
+        if (app->_updateRequested) {
+            app->_updateRequested = false;
+            _schedule(display.displayId, app->_updateRequestedAt, false);
+        }
+
+        // Apps without a cadence run on every pass
+        if (app->getUpdateInterval() == DokiApp::UPDATE_EVERY_LOOP) {
+            display.updateDue = true;
         }
     }
 
-    // Release mutex
+    // Then every app whose deadline has passed
+    while (!_deadlines.empty() && (int32_t)(now - _deadlines.front().due) >= 0) {
+        std::pop_heap(_deadlines.begin(), _deadlines.end(), _dueLater);
+        UpdateDeadline entry = _deadlines.back();
+        _deadlines.pop_back();
+
+        // Scheduled for an app that has since been replaced
+        DisplayState& display = _displays[entry.displayId];
+        DokiApp* app = display.currentApp;
+        if (!app || entry.generation != display.generation) continue;
+
+        uint32_t interval = app->getUpdateInterval();
+        if (entry.periodic && interval != DokiApp::UPDATE_EVERY_LOOP && interval != DokiApp::UPDATE_NEVER) {
+            _schedule(entry.displayId, _nextDeadline(app, entry.due, now), true);
+        }
+
+        display.updateDue = true;
+    }
+
     LVGLManager::unlock();
+
+    // One hold per app, so rendering and the other display get the lock
+    // between callbacks instead of waiting for the whole pass
+    for (auto& display : _displays) {
+        if (!display.updateDue) continue;
+
+        LVGLManager::lock(display.displayId);
+
+        // A load in between clears the flag (see _beginSwitch() and
+        // _beginUpdates()); one in progress leaves the display alone
+        DokiApp* app = display.currentApp;
+        if (display.updateDue && !display.switchTask && app && app->isRunning()) {
+            DOKI_TRACE_SCOPE("app", "onUpdate");
+            display.callbackTask = xTaskGetCurrentTaskHandle();
+            app->onUpdate();
+            display.callbackTask = nullptr;
+        }
+        display.updateDue = false;
+
+        LVGLManager::unlock();
+    }
+}
+
+uint32_t AppManager::getNextUpdateDelay() {
+    if (!_initialized) return UINT32_MAX;
+
+    uint32_t delay = UINT32_MAX;
+
+    LVGLManager::lock();
+
+    for (const auto& display : _displays) {
+        DokiApp* app = display.currentApp;
+        if (app && app->isRunning() &&
+            (app->_updateRequested || app->getUpdateInterval() == DokiApp::UPDATE_EVERY_LOOP)) {
+            delay = 0;
+        }
+    }
+
+    if (delay > 0 && !_deadlines.empty()) {
+        int32_t left = (int32_t)(_deadlines.front().due - millis());
+        delay = left > 0 ? (uint32_t)left : 0;
+    }
+
+    LVGLManager::unlock();
+
+    return delay;
 }
 
 DokiApp* AppManager::getApp(uint8_t displayId) {
@@ -348,6 +522,14 @@ void AppManager::printStatus() {
         }
     }
 
+    if (!_resident.empty()) {
+        Serial.println("╟─────────────────────────────────────╢");
+        Serial.printf("║ Resident (paused): %d/%-15d ║\n", (int)_resident.size(), APP_KEEP_ALIVE_MAX);
+        for (const auto& resident : _resident) {
+            Serial.printf("║   [%d] %-29s ║\n", resident.displayId, resident.appId.c_str());
+        }
+    }
+
     Serial.println("╠═════════════════════════════════════╣");
     Serial.println("║ Registered Apps                     ║");
     Serial.println("╟─────────────────────────────────────╢");
@@ -384,9 +566,20 @@ uint8_t AppManager::getDisplayIdForApp(DokiApp* app) {
         }
     }
 
+    // Paused apps still belong to their display
+    for (const auto& resident : _resident) {
+        if (resident.app == app) {
+            return resident.displayId;
+        }
+    }
+
     return 255; // Not found
 }
 
+uint8_t AppManager::getResidentCount() {
+    return _resident.size();
+}
+
 void AppManager::clearRegistry() {
     Serial.printf("[AppManager] Clearing registry (%d apps)\n", _registry.size());
 
@@ -397,6 +590,11 @@ void AppManager::clearRegistry() {
         }
     }
 
+    // Destroy paused apps too
+    while (!_resident.empty()) {
+        _evict(0);
+    }
+
     _registry.clear();
 }
 
@@ -438,4 +636,232 @@ void AppManager::_cleanupApp(uint8_t displayId, const char* appId) {
     Serial.println("[AppManager] Cleanup complete");
 }
 
-} // namespace Doki
\ No newline at end of file
+void AppManager::_saveAppState(DokiApp* app, const char* appId) {
+    Serial.printf("[AppManager] Saving app state...\n");
+    uint32_t saveStart = micros();
+    JsonDocument state;
+    app->onSaveState(state);
+    bool saved = state.size() > 0 && StatePersistence::saveState(appId, state);
+    AppProfiler::record(appId, AppProfiler::PHASE_SAVE_STATE, micros() - saveStart);
+
+    if (state.size() == 0) {
+        Serial.printf("[AppManager] No state to save\n");
+    } else if (saved) {
+        Serial.printf("[AppManager] ✓ State saved\n");
+    } else {
+        Serial.printf("[AppManager] ⚠️  Failed to save state\n");
+    }
+}
+
+// ========================================
+// App Residency (keep-alive)
+// ========================================
+
+void AppManager::_park(uint8_t displayId) {
+    DisplayState& display = _displays[displayId];
+
+    ResidentApp entry;
+    entry.displayId = displayId;
+    entry.appId = display.currentAppId;
+    entry.app = display.currentApp;
+    entry.screen = display.appScreen;
+
+    // Publish APP_PAUSED event
+    EventSystem::publish(EventType::APP_PAUSED, "AppManager", EventPayload::fromText(entry.appId.c_str()));
+
+    LVGLManager::lock(displayId);
+
+    Serial.printf("[AppManager] Calling onPause()...\n");
+    uint32_t phaseStart = micros();
+    entry.app->onPause();
+    entry.app->_setState(AppState::PAUSED);
+    AppProfiler::record(entry.appId.c_str(), AppProfiler::PHASE_ON_PAUSE, micros() - phaseStart);
+
+    // The screen stays shown until the next app loads its own
+    entry.lastUsed = millis();
+    _resident.push_back(entry);
+
+    display.currentApp = nullptr;
+    display.currentAppId = "";
+    display.appScreen = nullptr;
+
+    LVGLManager::unlock();
+
+    Serial.printf("[AppManager] ✓ '%s' kept resident (%d/%d)\n",
+                  entry.appId.c_str(), (int)_resident.size(), APP_KEEP_ALIVE_MAX);
+
+    _trimResident();
+}
+
+void AppManager::_resume(uint8_t displayId, const ResidentApp& entry) {
+    DisplayState& display = _displays[displayId];
+
+    LVGLManager::lock(displayId);
+
+    display.currentApp = entry.app;
+    display.currentAppId = entry.appId;
+    display.appScreen = entry.screen;
+
+    lv_disp_set_default(display.lvglDisplay);
+    lv_scr_load(entry.screen);
+
+    Serial.printf("[AppManager] Calling onStart()...\n");
+    uint32_t phaseStart = micros();
+    entry.app->onStart();
+    entry.app->_setState(AppState::STARTED);
+    entry.app->_markStarted();
+    AppProfiler::record(entry.appId.c_str(), AppProfiler::PHASE_ON_START, micros() - phaseStart);
+    _beginUpdates(displayId);
+    LVGLManager::unlock();
+
+    // Publish APP_STARTED event
+    EventSystem::publish(EventType::APP_STARTED, "AppManager", EventPayload::fromText(display.currentAppId.c_str()));
+}
+
+void AppManager::_evict(size_t index) {
+    ResidentApp entry = _resident[index];
+    _resident.erase(_resident.begin() + index);
+
+    DisplayState& display = _displays[entry.displayId];
+    uint32_t evictStart = micros();
+    Serial.printf("[AppManager] Evicting resident app '%s' from display %d (paused %lu ms)\n",
+                  entry.appId.c_str(), entry.displayId, (unsigned long)(millis() - entry.lastUsed));
+
+    // Held throughout, so the app's screen is never rendered while it is
+    // briefly active below
+    LVGLManager::lock(entry.displayId);
+
+    // Apps clean up through lv_scr_act(), so make their screen the active one
+    lv_disp_t* previousDefault = lv_disp_get_default();
+    lv_obj_t* shown = lv_disp_get_scr_act(display.lvglDisplay);
+    lv_disp_set_default(display.lvglDisplay);
+    lv_scr_load(entry.screen);
+
+    _saveAppState(entry.app, entry.appId.c_str());
+
+    Serial.printf("[AppManager] Calling onDestroy()...\n");
+    uint32_t phaseStart = micros();
+    entry.app->onDestroy();
+    entry.app->_setState(AppState::DESTROYED);
+    delete entry.app;
+    AppProfiler::record(entry.appId.c_str(), AppProfiler::PHASE_ON_DESTROY, micros() - phaseStart);
+
+    lv_scr_load(shown != entry.screen ? shown : display.baseScreen);
+    lv_obj_del(entry.screen);
+    if (previousDefault) {
+        lv_disp_set_default(previousDefault);
+    }
+
+    LVGLManager::unlock();
+
+    _cleanupApp(entry.displayId, entry.appId.c_str());
+
+    // Publish APP_UNLOADED event
+    EventSystem::publish(EventType::APP_UNLOADED, "AppManager", EventPayload::fromText(entry.appId.c_str()));
+
+    AppProfiler::record(entry.appId.c_str(), AppProfiler::PHASE_UNLOAD, micros() - evictStart);
+}
+
+void AppManager::_trimResident() {
+    // Oldest first: _resident is kept in the order apps were paused
+    while (!_resident.empty() &&
+           (_resident.size() > APP_KEEP_ALIVE_MAX || ESP.getFreeHeap() < APP_KEEP_ALIVE_MIN_FREE_HEAP)) {
+        _evict(0);
+    }
+}
+
+int AppManager::_findResident(uint8_t displayId, const char* appId) {
+    for (size_t i = 0; i < _resident.size(); i++) {
+        if (_resident[i].displayId == displayId && _resident[i].appId == appId) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// ========================================
+// Update Cadence
+// ========================================
+
+void AppManager::_beginSwitch(uint8_t displayId) {
+    // onUpdate() may drop the LVGL lock for blocking work
+    // (LVGLManager::Unlocked), so the lock alone does not keep the app
+    // alive. Check and claim under the lock: update() sets callbackTask
+    // under it too, and skips the display once switchTask is set
+    DisplayState& display = _displays[displayId];
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+
+    for (;;) {
+        LVGLManager::lock(displayId);
+        bool inCallback = display.callbackTask && display.callbackTask != self;
+        bool switching = display.switchTask && display.switchTask != self;
+        if (!inCallback && !switching) {
+            display.switchTask = self;
+            display.switchDepth++;
+            display.updateDue = false;
+            LVGLManager::unlock();
+            return;
+        }
+        LVGLManager::unlock();
+        vTaskDelay(1);
+    }
+}
+
+void AppManager::_endSwitch(uint8_t displayId) {
+    DisplayState& display = _displays[displayId];
+
+    LVGLManager::lock(displayId);
+    if (--display.switchDepth == 0) {
+        display.switchTask = nullptr;
+    }
+    LVGLManager::unlock();
+}
+
+void AppManager::_beginUpdates(uint8_t displayId) {
+    DisplayState& display = _displays[displayId];
+
+    // Deadlines of the previous app on this display are now stale
+    display.generation++;
+    display.updateDue = false;
+
+    uint32_t interval = display.currentApp->getUpdateInterval();
+    if (interval == DokiApp::UPDATE_EVERY_LOOP || interval == DokiApp::UPDATE_NEVER) {
+        return;
+    }
+
+    // First call on the next pass, then on the declared cadence
+    _schedule(displayId, millis(), true);
+}
+
+void AppManager::_schedule(uint8_t displayId, uint32_t due, bool periodic) {
+    UpdateDeadline entry;
+    entry.due = due;
+    entry.generation = _displays[displayId].generation;
+    entry.displayId = displayId;
+    entry.periodic = periodic;
+
+    _deadlines.push_back(entry);
+    std::push_heap(_deadlines.begin(), _deadlines.end(), _dueLater);
+}
+
+uint32_t AppManager::_nextDeadline(DokiApp* app, uint32_t previous, uint32_t now) {
+    uint32_t interval = app->getUpdateInterval();
+
+    if (app->alignUpdates()) {
+        // Next multiple of the interval on the system clock
+        struct timeval tv;
+        gettimeofday(&tv, nullptr);
+        uint64_t wallMs = (uint64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+        return now + (interval - (uint32_t)(wallMs % interval)) + UPDATE_ALIGN_SLACK_MS;
+    }
+
+    // Late by a whole interval or more: skip the missed calls instead of
+    // running them back to back
+    uint32_t next = previous + interval;
+    if ((int32_t)(next - now) <= 0) {
+        next = now + interval;
+    }
+    return next;
+}
+
+} // namespace Doki
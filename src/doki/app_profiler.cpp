@@ -0,0 +1,198 @@
+/**
+ * @file app_profiler.cpp
+ * @brief Implementation of the app load latency profiler
+ */
+
+#include "doki/app_profiler.h"
+#include "doki/logger.h"
+
+namespace Doki {
+
+static const char* const PHASE_NAMES[AppProfiler::PHASE_COUNT] = {
+    "factory", "clean", "onCreate", "loadState", "onRestoreState", "onStart",
+    "load", "resume", "firstFrame", "onPause", "saveState", "onDestroy", "unload"
+};
+
+// Bucket 0 holds everything below this, each further bucket doubles
+static constexpr uint32_t FIRST_BUCKET_US = 250;
+
+// ========================================
+// Static Member Initialization
+// ========================================
+
+AppProfiler::AppStat* AppProfiler::_apps = nullptr;
+uint16_t AppProfiler::_appCount = 0;
+AppProfiler::PendingFrame AppProfiler::_pending[DISPLAY_COUNT];
+SemaphoreHandle_t AppProfiler::_mutex = nullptr;
+
+// ========================================
+// Public Methods
+// ========================================
+
+bool AppProfiler::init() {
+    if (_apps) {
+        return true;
+    }
+
+    _mutex = xSemaphoreCreateMutex();
+    _apps = (AppStat*)heap_caps_malloc(sizeof(AppStat) * APP_PROFILER_MAX_APPS, MALLOC_CAP_SPIRAM);
+    if (!_mutex || !_apps) {
+        DOKI_LOGE(APP, "✗ Failed to allocate app profiler");
+        free(_apps);
+        _apps = nullptr;
+        return false;
+    }
+
+    reset();
+    DOKI_LOGI(APP, "✓ App load profiler ready (GET /api/perf)");
+    return true;
+}
+
+void AppProfiler::record(const char* appId, Phase phase, uint32_t us) {
+    if (!_apps || !appId || phase >= PHASE_COUNT) return;
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+
+    AppStat* app = _findOrAdd(appId);
+    if (app) {
+        PhaseStat& stat = app->phases[phase];
+        uint8_t bucket = _bucketFor(us);
+        if (stat.buckets[bucket] < UINT16_MAX) stat.buckets[bucket]++;
+        stat.count++;
+        stat.totalUs += us;
+        if (us > stat.maxUs) stat.maxUs = us;
+    }
+
+    xSemaphoreGive(_mutex);
+}
+
+void AppProfiler::expectFrame(uint8_t displayId, const char* appId, uint32_t startUs) {
+    if (!_apps || displayId >= DISPLAY_COUNT || !appId) return;
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    PendingFrame& pending = _pending[displayId];
+    snprintf(pending.app, sizeof(pending.app), "%s", appId);
+    pending.startUs = startUs;
+    pending.active = true;
+    xSemaphoreGive(_mutex);
+}
+
+void AppProfiler::frameDone(uint8_t displayId) {
+    // Called on every refresh: skip the lock unless a load is waiting
+    if (!_apps || displayId >= DISPLAY_COUNT || !_pending[displayId].active) return;
+
+    uint32_t now = micros();
+    char app[MAX_APP_NAME_LENGTH];
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    PendingFrame& pending = _pending[displayId];
+    bool active = pending.active;
+    uint32_t startUs = pending.startUs;
+    memcpy(app, pending.app, sizeof(app));
+    pending.active = false;
+    xSemaphoreGive(_mutex);
+
+    if (active) {
+        record(app, PHASE_FIRST_FRAME, now - startUs);
+    }
+}
+
+void AppProfiler::reset() {
+    if (!_apps) return;
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    memset(_apps, 0, sizeof(AppStat) * APP_PROFILER_MAX_APPS);
+    _appCount = 0;
+    xSemaphoreGive(_mutex);
+}
+
+void AppProfiler::toJson(JsonObject out) {
+    JsonArray limits = out["bucketsUs"].to<JsonArray>();
+    for (uint8_t b = 0; b + 1 < APP_PROFILER_BUCKETS; b++) {
+        limits.add(_bucketLimit(b));
+    }
+
+    JsonObject apps = out["apps"].to<JsonObject>();
+    if (!_apps) return;
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+
+    for (uint16_t i = 0; i < _appCount; i++) {
+        const AppStat& app = _apps[i];
+        JsonObject phases = apps[app.app].to<JsonObject>();
+
+        for (uint8_t p = 0; p < PHASE_COUNT; p++) {
+            const PhaseStat& stat = app.phases[p];
+            if (stat.count == 0) continue;
+
+            JsonObject phase = phases[PHASE_NAMES[p]].to<JsonObject>();
+            phase["count"] = stat.count;
+            phase["avgUs"] = (uint32_t)(stat.totalUs / stat.count);
+            phase["p50Us"] = _percentile(stat, 50);
+            phase["p90Us"] = _percentile(stat, 90);
+            phase["maxUs"] = stat.maxUs;
+
+            JsonArray histogram = phase["histogram"].to<JsonArray>();
+            for (uint8_t b = 0; b < APP_PROFILER_BUCKETS; b++) {
+                histogram.add(stat.buckets[b]);
+            }
+        }
+    }
+
+    xSemaphoreGive(_mutex);
+}
+
+// ========================================
+// Private Methods
+// ========================================
+
+AppProfiler::AppStat* AppProfiler::_findOrAdd(const char* appId) {
+    for (uint16_t i = 0; i < _appCount; i++) {
+        if (strncmp(_apps[i].app, appId, sizeof(_apps[i].app)) == 0) {
+            return &_apps[i];
+        }
+    }
+
+    if (_appCount >= APP_PROFILER_MAX_APPS) {
+        return nullptr;
+    }
+
+    AppStat* app = &_apps[_appCount++];
+    snprintf(app->app, sizeof(app->app), "%s", appId);
+    return app;
+}
+
+uint8_t AppProfiler::_bucketFor(uint32_t us) {
+    uint8_t bucket = 0;
+    while (bucket + 1 < APP_PROFILER_BUCKETS && us >= _bucketLimit(bucket)) {
+        bucket++;
+    }
+    return bucket;
+}
+
+uint32_t AppProfiler::_bucketLimit(uint8_t bucket) {
+    return FIRST_BUCKET_US << bucket;
+}
+
+uint32_t AppProfiler::_percentile(const PhaseStat& stat, uint8_t percent) {
+    // Upper limit of the bucket holding the nearest-rank sample; the
+    // last bucket is open, so report the maximum there
+    uint32_t total = 0;
+    for (uint8_t b = 0; b < APP_PROFILER_BUCKETS; b++) {
+        total += stat.buckets[b];
+    }
+    if (total == 0) return 0;
+
+    uint32_t rank = (total * percent + 99) / 100;
+    uint32_t seen = 0;
+    for (uint8_t b = 0; b + 1 < APP_PROFILER_BUCKETS; b++) {
+        seen += stat.buckets[b];
+        if (seen >= rank) {
+            uint32_t limit = _bucketLimit(b);
+            return limit < stat.maxUs ? limit : stat.maxUs;
+        }
+    }
+    return stat.maxUs;
+}
+
+} // namespace Doki
@@ -0,0 +1,134 @@
+/**
+ * @file event_benchmarks.cpp
+ * @brief Implementation of event bus benchmarks
+ */
+
+#include "doki/event_benchmarks.h"
+#include "doki/event_system.h"
+#include "doki/logger.h"
+
+#ifdef DOKI_EVENT_BENCHMARKS
+
+namespace Doki {
+
+static const uint32_t DIRECT_ITERATIONS = 10000;
+static const uint32_t QUEUED_EVENTS = 5000;
+static const uint32_t QUEUED_BURST = EVENT_QUEUE_SIZE / 2;   // Per tick, leaves the owner room to keep up
+static const uint32_t QUEUED_TIMEOUT_MS = 10000;
+static const uint32_t PRODUCER_STACK = 3072;
+static const EventType BENCH_EVENT = EventType::CUSTOM_EVENT_3;
+
+struct QueuedRun {
+    volatile uint32_t received;
+    volatile uint32_t producerUs;    // Time spent inside publish() on the producer
+    volatile bool done;
+    uint64_t latencyTotalUs;
+    uint32_t latencyMaxUs;
+};
+
+static QueuedRun _run;
+
+// ========================================
+// Helpers
+// ========================================
+
+static void _benchDirect(uint8_t subscribers) {
+    static volatile uint32_t sink = 0;
+    int ids[4] = {};
+
+    for (uint8_t i = 0; i < subscribers; i++) {
+        ids[i] = EventSystem::subscribe(BENCH_EVENT, [](const Event& e) {
+            sink = sink + e.payload.asInt();
+        });
+    }
+
+    uint32_t start = micros();
+    for (uint32_t i = 0; i < DIRECT_ITERATIONS; i++) {
+        EventSystem::publish(BENCH_EVENT, "bench", EventPayload::fromInt((int32_t)i));
+    }
+    uint32_t elapsed = micros() - start;
+
+    for (uint8_t i = 0; i < subscribers; i++) {
+        EventSystem::unsubscribe(ids[i]);
+    }
+
+    DOKI_LOGI(EVENT, "[bench] direct, %u subscriber(s): %lu ns/publish, %lu publishes/s",
+              subscribers,
+              (unsigned long)((uint64_t)elapsed * 1000 / DIRECT_ITERATIONS),
+              (unsigned long)(elapsed ? (uint64_t)DIRECT_ITERATIONS * 1000000 / elapsed : 0));
+}
+
+static void _producerTask(void* param) {
+    uint32_t sent = 0;
+    uint32_t busyUs = 0;
+
+    while (sent < QUEUED_EVENTS) {
+        for (uint32_t b = 0; b < QUEUED_BURST && sent < QUEUED_EVENTS; b++, sent++) {
+            uint32_t now = micros();
+            EventSystem::publish(BENCH_EVENT, "bench", EventPayload::fromInt((int32_t)now));
+            busyUs += micros() - now;
+        }
+        vTaskDelay(1);
+    }
+
+    _run.producerUs = busyUs;
+    _run.done = true;
+    vTaskDelete(nullptr);
+}
+
+static void _benchQueued() {
+    memset(&_run, 0, sizeof(_run));
+    uint32_t droppedBefore = EventSystem::getDroppedCount();
+
+    int id = EventSystem::subscribe(BENCH_EVENT, [](const Event& e) {
+        uint32_t latency = micros() - (uint32_t)e.payload.asInt();
+        _run.latencyTotalUs += latency;
+        if (latency > _run.latencyMaxUs) _run.latencyMaxUs = latency;
+        _run.received = _run.received + 1;
+    });
+
+    // Producer on the other core, so publishing and dispatch overlap
+    uint32_t start = micros();
+    if (xTaskCreatePinnedToCore(_producerTask, "event_bench", PRODUCER_STACK, nullptr, 1, nullptr,
+                                xPortGetCoreID() == 0 ? 1 : 0) != pdPASS) {
+        DOKI_LOGE(EVENT, "[bench] Failed to start producer task");
+        EventSystem::unsubscribe(id);
+        return;
+    }
+
+    uint32_t deadline = millis() + QUEUED_TIMEOUT_MS;
+    while ((int32_t)(millis() - deadline) < 0) {
+        bool finished = _run.done;
+        if (EventSystem::dispatch() == 0 && finished) break;
+    }
+    uint32_t elapsed = micros() - start;
+
+    EventSystem::unsubscribe(id);
+
+    uint32_t received = _run.received;
+    DOKI_LOGI(EVENT, "[bench] queued: %lu of %lu events in %lu ms (%lu events/s), %lu dropped",
+              (unsigned long)received, (unsigned long)QUEUED_EVENTS, (unsigned long)(elapsed / 1000),
+              (unsigned long)(elapsed ? (uint64_t)received * 1000000 / elapsed : 0),
+              (unsigned long)(EventSystem::getDroppedCount() - droppedBefore));
+    DOKI_LOGI(EVENT, "[bench] queued: publish %lu ns, publish-to-callback avg %lu us, max %lu us",
+              (unsigned long)((uint64_t)_run.producerUs * 1000 / QUEUED_EVENTS),
+              (unsigned long)(received ? _run.latencyTotalUs / received : 0),
+              (unsigned long)_run.latencyMaxUs);
+}
+
+// ========================================
+// Public Methods
+// ========================================
+
+void EventBenchmarks::run() {
+    DOKI_LOGI(EVENT, "[bench] Event bus, %lu direct publishes per case", (unsigned long)DIRECT_ITERATIONS);
+
+    _benchDirect(0);
+    _benchDirect(1);
+    _benchDirect(4);
+    _benchQueued();
+}
+
+} // namespace Doki
+
+#endif // DOKI_EVENT_BENCHMARKS
@@ -4,6 +4,8 @@
  */
 
 #include "doki/event_system.h"
+#include "doki/logger.h"
+#include "doki/tracer.h"
 
 namespace Doki {
 
@@ -11,67 +13,130 @@ namespace Doki {
 // Static Member Initialization
 // ========================================
 
-std::vector<EventSystem::Subscription> EventSystem::_subscriptions;
+static_assert((EVENT_QUEUE_SIZE & (EVENT_QUEUE_SIZE - 1)) == 0, "EVENT_QUEUE_SIZE must be a power of 2");
+static constexpr uint32_t QUEUE_MASK = EVENT_QUEUE_SIZE - 1;
+
+std::vector<EventSystem::Subscription> EventSystem::_subscribers[EVENT_TYPE_COUNT];
+std::vector<EventSystem::Subscription> EventSystem::_added;
 int EventSystem::_nextSubscriptionId = 1;
+uint8_t EventSystem::_dispatchDepth = 0;
+bool EventSystem::_needsCompact = false;
+TaskHandle_t EventSystem::_owner = nullptr;
+
+EventSystem::Slot EventSystem::_queue[EVENT_QUEUE_SIZE];
+std::atomic<uint32_t> EventSystem::_enqueuePos(0);
+uint32_t EventSystem::_dequeuePos = 0;
+std::atomic<uint32_t> EventSystem::_dropped(0);
 
 // ========================================
 // Public Methods
 // ========================================
 
+void EventSystem::init() {
+    // Slot i is free for the producer that claims position i
+    for (uint32_t i = 0; i < EVENT_QUEUE_SIZE; i++) {
+        _queue[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    _enqueuePos.store(0, std::memory_order_relaxed);
+    _dequeuePos = 0;
+
+    _owner = xTaskGetCurrentTaskHandle();
+
+    DOKI_LOGI(EVENT, "✓ Event system ready (queue: %u events)", (unsigned)EVENT_QUEUE_SIZE);
+}
+
 int EventSystem::subscribe(EventType type, EventCallback callback) {
+    if ((size_t)type >= EVENT_TYPE_COUNT) {
+        DOKI_LOGW(EVENT, "Warning: Invalid event type %d", (int)type);
+        return 0;
+    }
+
     // Generate unique subscription ID
     int id = _nextSubscriptionId++;
     
-    // Add subscription to list
-    _subscriptions.emplace_back(id, type, callback);
+    // Add subscription to list (not while the list is being walked)
+    if (_dispatchDepth > 0) {
+        _added.emplace_back(id, type, callback);
+    } else {
+        _subscribers[(size_t)type].emplace_back(id, type, callback);
+    }
     
-    Serial.printf("[EventSystem] Subscribed to %s (ID: %d, Total subscribers: %d)\n",
-                  getEventName(type), id, getSubscriberCount(type));
+    DOKI_LOGD(EVENT, "Subscribed to %s (ID: %d, Total subscribers: %d)",
+              getEventName(type), id, getSubscriberCount(type));
     
     return id;
 }
 
 void EventSystem::unsubscribe(int subscriptionId) {
-    // Find and deactivate the subscription
-    for (auto& sub : _subscriptions) {
+    // Find and deactivate the subscription; removed once no dispatch runs
+    for (auto& list : _subscribers) {
+        for (auto& sub : list) {
+            if (sub.id == subscriptionId && sub.active) {
+                sub.active = false;
+                _needsCompact = true;
+                DOKI_LOGD(EVENT, "Unsubscribed ID %d from %s",
+                          subscriptionId, getEventName(sub.type));
+                _compact();
+                return;
+            }
+        }
+    }
+
+    for (auto& sub : _added) {
         if (sub.id == subscriptionId && sub.active) {
             sub.active = false;
-            Serial.printf("[EventSystem] Unsubscribed ID %d from %s\n",
-                          subscriptionId, getEventName(sub.type));
             return;
         }
     }
     
-    Serial.printf("[EventSystem] Warning: Subscription ID %d not found\n", subscriptionId);
+    DOKI_LOGW(EVENT, "Warning: Subscription ID %d not found", subscriptionId);
 }
 
-void EventSystem::publish(EventType type, const char* source, void* data) {
-    // Create event
-    Event event(type, source, data);
-    
-    // Get all subscribers for this event type
-    std::vector<Subscription*> subscribers = _getSubscribers(type);
-    
-    Serial.printf("[EventSystem] Publishing %s from '%s' (%d subscribers)\n",
-                  getEventName(type), source, subscribers.size());
-    
-    // Call all subscriber callbacks
-    for (auto* sub : subscribers) {
-        if (sub->active) {
-            try {
-                sub->callback(event);
-            } catch (const std::exception& e) {
-                Serial.printf("[EventSystem] Error in subscriber callback: %s\n", e.what());
-            } catch (...) {
-                Serial.println("[EventSystem] Unknown error in subscriber callback");
-            }
+bool EventSystem::publish(EventType type, const char* source, const EventPayload& payload) {
+    if ((size_t)type >= EVENT_TYPE_COUNT) {
+        return false;
+    }
+
+    DOKI_TRACE_SCOPE("event", getEventName(type));
+    Event event(type, source, payload);
+
+    // Other tasks and ISRs hand the event to the owner
+    if (_owner && (xPortInIsrContext() || xTaskGetCurrentTaskHandle() != _owner)) {
+        if (!_enqueue(event)) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
         }
+        return true;
+    }
+
+    _deliver(event);
+    return true;
+}
+
+uint32_t EventSystem::dispatch() {
+    // Only what is queued now, so a callback that publishes from another
+    // task cannot keep this loop going
+    uint32_t dispatched = 0;
+    Event event;
+    while (dispatched < EVENT_QUEUE_SIZE && _dequeue(event)) {
+        _deliver(event);
+        dispatched++;
     }
+    return dispatched;
 }
 
 int EventSystem::getSubscriberCount(EventType type) {
+    if ((size_t)type >= EVENT_TYPE_COUNT) {
+        return 0;
+    }
+
     int count = 0;
-    for (const auto& sub : _subscriptions) {
+    for (const auto& sub : _subscribers[(size_t)type]) {
+        if (sub.active) {
+            count++;
+        }
+    }
+    for (const auto& sub : _added) {
         if (sub.type == type && sub.active) {
             count++;
         }
@@ -80,10 +145,15 @@ int EventSystem::getSubscriberCount(EventType type) {
 }
 
 void EventSystem::clearAll() {
-    Serial.printf("[EventSystem] Clearing all subscriptions (%d total)\n", 
-                  _subscriptions.size());
-    _subscriptions.clear();
+    size_t total = _added.size();
+    for (auto& list : _subscribers) {
+        total += list.size();
+        list.clear();
+    }
+    _added.clear();
     _nextSubscriptionId = 1;
+
+    DOKI_LOGI(EVENT, "Cleared all subscriptions (%u total)", (unsigned)total);
 }
 
 const char* EventSystem::getEventName(EventType type) {
@@ -126,16 +196,95 @@ const char* EventSystem::getEventName(EventType type) {
 // Private Helper Methods
 // ========================================
 
-std::vector<EventSystem::Subscription*> EventSystem::_getSubscribers(EventType type) {
-    std::vector<Subscription*> result;
-    
-    for (auto& sub : _subscriptions) {
-        if (sub.type == type && sub.active) {
-            result.push_back(&sub);
+bool EventSystem::_enqueue(const Event& event) {
+    // Bounded MPSC queue: producers claim a position with one CAS, then
+    // publish the slot through its sequence number. No locks, so ISRs
+    // and any task may publish.
+    uint32_t pos = _enqueuePos.load(std::memory_order_relaxed);
+    Slot* slot;
+
+    while (true) {
+        slot = &_queue[pos & QUEUE_MASK];
+        uint32_t sequence = slot->sequence.load(std::memory_order_acquire);
+        int32_t diff = (int32_t)(sequence - pos);
+
+        if (diff == 0) {
+            if (_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;  // Full
+        } else {
+            pos = _enqueuePos.load(std::memory_order_relaxed);
         }
     }
-    
-    return result;
+
+    slot->event = event;
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool EventSystem::_dequeue(Event& event) {
+    Slot& slot = _queue[_dequeuePos & QUEUE_MASK];
+    uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+
+    // Empty, or the producer of this slot has not finished writing it
+    if ((int32_t)(sequence - (_dequeuePos + 1)) < 0) {
+        return false;
+    }
+
+    event = slot.event;
+    slot.sequence.store(_dequeuePos + EVENT_QUEUE_SIZE, std::memory_order_release);
+    _dequeuePos++;
+    return true;
+}
+
+void EventSystem::_deliver(const Event& event) {
+    DOKI_TRACE_SCOPE("event", "deliver");
+    std::vector<Subscription>& list = _subscribers[(size_t)event.type];
+
+    // By index: the list does not change size while a dispatch runs
+    _dispatchDepth++;
+    for (size_t i = 0; i < list.size(); i++) {
+        Subscription& sub = list[i];
+        if (!sub.active) continue;
+
+        try {
+            sub.callback(event);
+        } catch (const std::exception& e) {
+            DOKI_LOGE(EVENT, "Error in subscriber callback: %s", e.what());
+        } catch (...) {
+            DOKI_LOGE(EVENT, "Unknown error in subscriber callback");
+        }
+    }
+    _dispatchDepth--;
+
+    if (_dispatchDepth == 0 && (!_added.empty() || _needsCompact)) {
+        for (auto& sub : _added) {
+            if (sub.active) {
+                _subscribers[(size_t)sub.type].push_back(std::move(sub));
+            }
+        }
+        _added.clear();
+        _compact();
+    }
+}
+
+void EventSystem::_compact() {
+    if (_dispatchDepth > 0 || !_needsCompact) {
+        return;
+    }
+
+    for (auto& list : _subscribers) {
+        for (size_t i = 0; i < list.size();) {
+            if (list[i].active) {
+                i++;
+            } else {
+                list.erase(list.begin() + i);
+            }
+        }
+    }
+    _needsCompact = false;
 }
 
 } // namespace Doki
\ No newline at end of file
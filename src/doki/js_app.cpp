@@ -4,25 +4,32 @@
  */
 
 #include "doki/js_app.h"
+#include "doki/js_context_pool.h"
+#include "doki/js_profiler.h"
+#include "doki/lvgl_manager.h"
+#include "doki/logger.h"
+#include "timing_constants.h"
 #include <lvgl.h>
 
 namespace Doki {
 
-JSApp::JSApp(const char* id, const char* name, const char* scriptPath)
+JSApp::JSApp(const char* id, const char* name, const char* scriptPath, bool trusted)
     : DokiApp(id, name),
       _scriptPath(scriptPath),
       _jsContext(nullptr),
+      _trusted(trusted),
       _scriptLoaded(false),
-      _lastUpdate(0)
+      _lastUpdate(0),
+      _updateInterval(UPDATE_INTERVAL),
+      _budgetWindowSeq(0),
+      _lastDispatch(0),
+      _lastFrame(0)
 {
-    Serial.printf("[JSApp:%s] Created with script: %s\n", id, scriptPath);
+    DOKI_LOGD(APP, "JSApp %s created with script: %s", id, scriptPath);
 }
 
 JSApp::~JSApp() {
-    if (_jsContext) {
-        JSEngine::destroyContext(_jsContext);
-        _jsContext = nullptr;
-    }
+    _releaseContext();
 }
 
 void JSApp::onCreate() {
@@ -35,8 +42,17 @@ void JSApp::onCreate() {
         return;
     }
 
-    // Create JS context
-    _jsContext = JSEngine::createContext();
+#ifdef DOKI_JS_SHARED_HEAP
+    // Trusted apps share one heap; the rest (and overflow) get their own
+    if (_trusted) {
+        _jsContext = JSEngine::createSharedContext();
+    }
+#endif
+
+    // Take a pre-built JS context (created on demand if the pool is empty)
+    if (!_jsContext) {
+        _jsContext = JSContextPool::acquire();
+    }
     if (!_jsContext) {
         _showError("Failed to create\nJS context");
         log("ERROR: Failed to create JS context");
@@ -45,6 +61,11 @@ void JSApp::onCreate() {
 
     // Set the display ID for this context
     JSEngine::setDisplayId(_jsContext, getDisplayId());
+    JSEngine::setAppId(_jsContext, getId());
+
+#ifdef DOKI_JS_PROFILER
+    JSProfiler::beginApp(getDisplayId(), getId());
+#endif
 
     // Set the display screen pointer for this context (CRITICAL for multi-display)
     JSEngine::setDisplayScreen(_jsContext, getScreen());
@@ -60,7 +81,11 @@ void JSApp::onCreate() {
     _scriptLoaded = true;
 
     // Call JavaScript onCreate()
-    if (!JSEngine::callFunction(_jsContext, "onCreate")) {
+    if (!JSEngine::callLifecycle(_jsContext, JSLifecycle::ON_CREATE)) {
+        if (JSEngine::hasTimedOut(_jsContext)) {
+            _terminate("onCreate() timed out\n(infinite loop?)");
+            return;
+        }
         String error = "onCreate() error:\n" + String(JSEngine::getLastError());
         _showError(error.c_str());
         return;
@@ -73,7 +98,7 @@ void JSApp::onStart() {
     log("JavaScript app started");
 
     if (_scriptLoaded && _jsContext) {
-        JSEngine::callFunction(_jsContext, "onStart");
+        JSEngine::callLifecycle(_jsContext, JSLifecycle::ON_START);
     }
 }
 
@@ -82,22 +107,61 @@ void JSApp::onUpdate() {
         return;
     }
 
-    // Throttle updates to avoid overloading
     uint32_t now = millis();
-    if (now - _lastUpdate < UPDATE_INTERVAL) {
+
+    // While throttled, timers and frames are held to the throttled rate too
+    if (_updateInterval > UPDATE_INTERVAL && now - _lastDispatch < _updateInterval) {
+        return;
+    }
+
+    bool ran = false;
+
+    // Poll onUpdate() only if the script defines it - apps driven
+    // purely by timers are never polled
+    if (now - _lastUpdate >= _updateInterval && JSEngine::hasLifecycle(_jsContext, JSLifecycle::ON_UPDATE)) {
+        _lastUpdate = now;
+        JSEngine::callLifecycle(_jsContext, JSLifecycle::ON_UPDATE);
+        ran = true;
+    }
+
+    // Timers only enter Duktape when one is due
+    if (!JSEngine::hasTimedOut(_jsContext) && JSEngine::runTimers(_jsContext, now) > 0) {
+        ran = true;
+    }
+
+    // Network messages received since the last tick, delivered as one batch
+    if (!JSEngine::hasTimedOut(_jsContext) && JSEngine::dispatchMessages(_jsContext) > 0) {
+        ran = true;
+    }
+
+    // requestAnimationFrame callbacks run at the display refresh rate
+    if (!JSEngine::hasTimedOut(_jsContext) && JSEngine::hasAnimationFrame(_jsContext) &&
+        now - _lastFrame >= _getFramePeriod()) {
+        _lastFrame = now;
+        JSEngine::runAnimationFrame(_jsContext, now);
+        ran = true;
+    }
+
+    if (!ran) {
+        // Nothing due this tick - collect garbage now rather than mid-frame
+        _collectIdleGarbage(now);
         return;
     }
-    _lastUpdate = now;
+    _lastDispatch = now;
 
-    // Call JavaScript onUpdate()
-    JSEngine::callFunction(_jsContext, "onUpdate");
+    if (JSEngine::hasTimedOut(_jsContext)) {
+        _terminate("Script timed out\n(infinite loop?)");
+        return;
+    }
+
+    _enforceBudget();
 }
 
 void JSApp::onPause() {
     log("JavaScript app paused");
 
     if (_scriptLoaded && _jsContext) {
-        JSEngine::callFunction(_jsContext, "onPause");
+        JSEngine::callLifecycle(_jsContext, JSLifecycle::ON_PAUSE);
     }
 }
 
@@ -105,14 +169,11 @@ void JSApp::onDestroy() {
     log("JavaScript app destroyed");
 
     if (_scriptLoaded && _jsContext) {
-        JSEngine::callFunction(_jsContext, "onDestroy");
+        JSEngine::callLifecycle(_jsContext, JSLifecycle::ON_DESTROY);
     }
 
-    // Cleanup JS context
-    if (_jsContext) {
-        JSEngine::destroyContext(_jsContext);
-        _jsContext = nullptr;
-    }
+    // Cleanup JS context (heap teardown happens in the background)
+    _releaseContext();
 
     _scriptLoaded = false;
 }
@@ -123,10 +184,20 @@ void JSApp::onSaveState(JsonDocument& state) {
     }
 
     // Call JavaScript onSaveState() if it exists
-    // The JS function should return an object with state data
-    JSEngine::callFunction(_jsContext, "onSaveState");
+    // The JS function should return an object with state data; its
+    // members are saved next to the script path and handed back to
+    // onRestoreState() on the next launch
+    JsonDocument saved;
+    JSEngine::callLifecycle(_jsContext, JSLifecycle::ON_SAVE_STATE, nullptr, &saved);
+
+    if (saved.is<JsonObject>()) {
+        for (JsonPair member : saved.as<JsonObject>()) {
+            state[member.key().c_str()] = member.value();
+        }
+    } else if (!saved.isNull()) {
+        DOKI_LOGW(APP, "%s: onSaveState() must return an object, ignored", getId());
+    }
 
-    // For now, just save the script path
     state["scriptPath"] = _scriptPath;
 }
 
@@ -136,7 +207,146 @@ void JSApp::onRestoreState(const JsonDocument& state) {
     }
 
     // Call JavaScript onRestoreState() with state data
-    JSEngine::callFunctionWithArgs(_jsContext, "onRestoreState", state);
+    JSEngine::callLifecycle(_jsContext, JSLifecycle::ON_RESTORE_STATE, &state);
+}
+
+void JSApp::getRuntimeStats(JsonObject stats) {
+    JSExecStats exec;
+    if (!_jsContext || !JSEngine::getExecStats(_jsContext, exec)) {
+        return;
+    }
+
+    stats["jsCpuMs"] = (uint32_t)(exec.totalUs / 1000);
+    stats["jsLoadPercent"] = exec.lastWindowUs / (JS_BUDGET_WINDOW_MS * 10);
+    stats["jsLastCallUs"] = exec.lastCallUs;
+    stats["jsMaxCallUs"] = exec.maxCallUs;
+    stats["jsTimeouts"] = exec.timeouts;
+    stats["updateIntervalMs"] = _updateInterval;
+#ifdef DOKI_JS_SHARED_HEAP
+    stats["sharedHeap"] = JSEngine::isSharedContext(_jsContext);
+#endif
+
+    JSGcStats gc;
+    if (JSEngine::getGcStats(_jsContext, gc)) {
+        stats["gcIdleRuns"] = gc.idleRuns;
+        stats["gcLastPauseUs"] = gc.lastPauseUs;
+        stats["gcMaxPauseUs"] = gc.maxPauseUs;
+        stats["gcEmergency"] = gc.emergency;
+    }
+
+    JSMessageStats messages;
+    if (JSEngine::getMessageStats(_jsContext, messages)) {
+        stats["mqttMessages"] = messages.mqttReceived;
+        stats["mqttDropped"] = messages.mqttDropped;
+        stats["wsMessages"] = messages.wsReceived;
+        stats["wsDropped"] = messages.wsDropped;
+    }
+}
+
+bool JSApp::_enforceBudget() {
+    JSExecStats exec;
+    if (!JSEngine::getExecStats(_jsContext, exec) || exec.windowSeq == _budgetWindowSeq) {
+        return true;
+    }
+    _budgetWindowSeq = exec.windowSeq;
+
+    if (exec.overBudgetWindows == 0) {
+        // Back under budget - recover gradually
+        if (_updateInterval > UPDATE_INTERVAL) {
+            _updateInterval /= 2;
+            if (_updateInterval < UPDATE_INTERVAL) _updateInterval = UPDATE_INTERVAL;
+            DOKI_LOGI(APP, "%s: within JS budget, update interval %u ms",
+                      getId(), (unsigned)_updateInterval);
+        }
+        return true;
+    }
+
+    if (_updateInterval < JS_THROTTLE_MAX_INTERVAL_MS) {
+        _updateInterval *= 2;
+        if (_updateInterval > JS_THROTTLE_MAX_INTERVAL_MS) _updateInterval = JS_THROTTLE_MAX_INTERVAL_MS;
+        DOKI_LOGW(APP, "%s: over JS budget (%u ms in %u ms), throttled to %u ms",
+                  getId(), (unsigned)(exec.lastWindowUs / 1000),
+                  (unsigned)JS_BUDGET_WINDOW_MS, (unsigned)_updateInterval);
+        return true;
+    }
+
+    if (exec.overBudgetWindows >= JS_BUDGET_MAX_STRIKES) {
+        _terminate("Script stopped\n(CPU budget exceeded)");
+        return false;
+    }
+
+    return true;
+}
+
+void JSApp::_collectIdleGarbage(uint32_t now) {
+    JSGcStats gc;
+    if (!JSEngine::getGcStats(_jsContext, gc) || gc.allocsSinceGc < JS_GC_IDLE_MIN_ALLOCS) {
+        return;
+    }
+
+    // Slack until the next callback is due: frame, onUpdate() or timer
+    uint32_t slack = JSEngine::getNextTimerDelay(_jsContext, now);
+
+    if (JSEngine::hasAnimationFrame(_jsContext)) {
+        uint32_t elapsed = now - _lastFrame;
+        uint32_t period = _getFramePeriod();
+        uint32_t untilFrame = elapsed < period ? period - elapsed : 0;
+        if (untilFrame < slack) slack = untilFrame;
+    }
+
+    if (JSEngine::hasLifecycle(_jsContext, JSLifecycle::ON_UPDATE)) {
+        uint32_t elapsed = now - _lastUpdate;
+        uint32_t untilUpdate = elapsed < _updateInterval ? _updateInterval - elapsed : 0;
+        if (untilUpdate < slack) slack = untilUpdate;
+    }
+
+    // The previous pause predicts this one; skip if it would overrun the slack
+    if (slack < JS_GC_IDLE_MIN_SLACK_MS || gc.lastPauseUs / 1000 >= slack) {
+        return;
+    }
+
+    JSEngine::collectGarbage(_jsContext);
+}
+
+void JSApp::_releaseContext() {
+    if (!_jsContext) {
+        return;
+    }
+
+    // GET /api/status reads runtime stats through _jsContext under this
+    // lock (recursive: onDestroy() and onUpdate() already hold it)
+    LVGLManager::lock(getDisplayId());
+
+#ifdef DOKI_JS_SHARED_HEAP
+    if (JSEngine::isSharedContext(_jsContext)) {
+        JSEngine::destroySharedContext(_jsContext);
+        _jsContext = nullptr;
+        LVGLManager::unlock();
+        return;
+    }
+#endif
+
+    JSContextPool::release(_jsContext);
+    _jsContext = nullptr;
+
+    LVGLManager::unlock();
+}
+
+uint32_t JSApp::_getFramePeriod() {
+    // Follow the display's LVGL refresh timer so frames match what is drawn
+    lv_disp_t* disp = getDisplay();
+    lv_timer_t* refr = disp ? _lv_disp_get_refr_timer(disp) : nullptr;
+    return refr ? refr->period : LV_DISP_DEF_REFR_PERIOD;
+}
+
+void JSApp::_terminate(const char* reason) {
+    DOKI_LOGE(APP, "%s: terminating script - %s", getId(), reason);
+
+    _releaseContext();
+    _scriptLoaded = false;
+
+    lv_obj_clean(getScreen());
+    _showError(reason);
 }
 
 void JSApp::_showError(const char* message) {
@@ -0,0 +1,239 @@
+/**
+ * @file js_benchmarks.cpp
+ * @brief Implementation of native JS engine micro-benchmarks
+ */
+
+#include "doki/js_benchmarks.h"
+#include "doki/js_engine.h"
+#include "doki/logger.h"
+
+#if defined(DOKI_JS_BENCHMARKS) && defined(ENABLE_JAVASCRIPT_SUPPORT)
+
+#include <ArduinoJson.h>
+#include <esp_heap_caps.h>
+
+namespace Doki {
+
+static const uint32_t JSON_BENCH_ITERATIONS = 200;
+static const uint8_t FOOTPRINT_CONTEXTS = 3;
+
+#if defined(DOKI_DUK_LOWMEM)
+static const char* DUK_PROFILE = "lowmem";
+#else
+static const char* DUK_PROFILE = "stock";
+#endif
+
+// Integer-only work: where fastint avoids soft-float doubles
+static const char* ARITHMETIC_SCRIPT =
+    "var s = 0;"
+    "for (var i = 0; i < 200000; i++) { s = (s + i * 3) & 0xffff; }";
+
+// ========================================
+// Sample Documents
+// ========================================
+
+static void _buildCounterState(JsonDocument& doc) {
+    doc["count"] = 42;
+    doc["scriptPath"] = "/apps/counter.js";
+}
+
+static void _buildWeatherState(JsonDocument& doc) {
+    doc["location"] = "Bengaluru";
+    doc["units"] = "metric";
+    doc["lastUpdate"] = 1718000000;
+
+    JsonObject current = doc["current"].to<JsonObject>();
+    current["temp"] = 27.4;
+    current["feelsLike"] = 29.1;
+    current["humidity"] = 68;
+    current["condition"] = "Partly cloudy";
+    current["wind"]["speed"] = 11.2;
+    current["wind"]["dir"] = "WSW";
+
+    JsonArray hourly = doc["hourly"].to<JsonArray>();
+    for (int h = 0; h < 24; h++) {
+        JsonObject hour = hourly.add<JsonObject>();
+        hour["t"] = 1718000000 + h * 3600;
+        hour["temp"] = 22.5 + (h % 12) * 0.75;
+        hour["icon"] = (h % 3) ? "cloud" : "sun";
+        hour["pop"] = (h * 7) % 100;
+    }
+
+    JsonArray alerts = doc["alerts"].to<JsonArray>();
+    alerts.add("Heavy rain expected after 18:00");
+}
+
+static void _buildPlaylistState(JsonDocument& doc) {
+    doc["current"] = 5;
+    doc["shuffle"] = false;
+    doc["volume"] = 0.8;
+
+    JsonArray items = doc["items"].to<JsonArray>();
+    for (int i = 0; i < 32; i++) {
+        JsonObject item = items.add<JsonObject>();
+        item["id"] = 1000 + i;
+        item["title"] = String("Animation ") + i;
+        item["path"] = String("/animations/clip_") + i + ".spr";
+        item["enabled"] = (i % 5) != 0;
+        JsonArray tags = item["tags"].to<JsonArray>();
+        tags.add("loop");
+        tags.add(i % 2 ? "night" : "day");
+    }
+}
+
+// ========================================
+// Measurements
+// ========================================
+
+static void _benchDocument(duk_context* ctx, const char* name, const JsonDocument& doc) {
+    uint32_t start;
+    uint32_t textToJs, directToJs, textToJson, directToJson;
+    size_t bytes = measureJson(doc);
+
+    // JSON -> JS: text round-trip (previous implementation)
+    start = micros();
+    for (uint32_t i = 0; i < JSON_BENCH_ITERATIONS; i++) {
+        String text;
+        serializeJson(doc, text);
+        duk_push_string(ctx, text.c_str());
+        duk_json_decode(ctx, -1);
+        duk_pop(ctx);
+    }
+    textToJs = micros() - start;
+
+    // JSON -> JS: direct
+    start = micros();
+    for (uint32_t i = 0; i < JSON_BENCH_ITERATIONS; i++) {
+        JSEngine::pushJson(ctx, doc.as<JsonVariantConst>());
+        duk_pop(ctx);
+    }
+    directToJs = micros() - start;
+
+    // Keep one JS copy of the document for the reverse direction
+    JSEngine::pushJson(ctx, doc.as<JsonVariantConst>());
+
+    // JS -> JSON: text round-trip
+    start = micros();
+    for (uint32_t i = 0; i < JSON_BENCH_ITERATIONS; i++) {
+        duk_dup_top(ctx);
+        const char* text = duk_json_encode(ctx, -1);
+        JsonDocument out;
+        deserializeJson(out, text);
+        duk_pop(ctx);
+    }
+    textToJson = micros() - start;
+
+    // JS -> JSON: direct
+    start = micros();
+    for (uint32_t i = 0; i < JSON_BENCH_ITERATIONS; i++) {
+        JsonDocument out;
+        JSEngine::readJson(ctx, -1, out.to<JsonVariant>());
+    }
+    directToJson = micros() - start;
+
+    duk_pop(ctx);
+
+    DOKI_LOGI(JS_ENGINE, "[bench] %-8s %5u B  json->js %4u/%4u us  js->json %4u/%4u us  (text/direct)",
+              name, (unsigned)bytes,
+              (unsigned)(textToJs / JSON_BENCH_ITERATIONS), (unsigned)(directToJs / JSON_BENCH_ITERATIONS),
+              (unsigned)(textToJson / JSON_BENCH_ITERATIONS), (unsigned)(directToJson / JSON_BENCH_ITERATIONS));
+}
+
+// ========================================
+// Public Methods
+// ========================================
+
+void JSBenchmarks::runJsonConversion() {
+    duk_context* ctx = (duk_context*)JSEngine::createContext();
+    if (!ctx) {
+        DOKI_LOGE(JS_ENGINE, "[bench] Failed to create context");
+        return;
+    }
+
+    DOKI_LOGI(JS_ENGINE, "[bench] JSON conversion, %u iterations per case", (unsigned)JSON_BENCH_ITERATIONS);
+
+    JsonDocument counter, weather, playlist;
+    _buildCounterState(counter);
+    _buildWeatherState(weather);
+    _buildPlaylistState(playlist);
+
+    _benchDocument(ctx, "counter", counter);
+    _benchDocument(ctx, "weather", weather);
+    _benchDocument(ctx, "playlist", playlist);
+
+    JSEngine::destroyContext(ctx);
+}
+
+void JSBenchmarks::runContextFootprint() {
+    void* contexts[FOOTPRINT_CONTEXTS] = {};
+    uint32_t totalBytes = 0;
+    uint32_t totalUs = 0;
+    uint8_t created = 0;
+
+    for (uint8_t i = 0; i < FOOTPRINT_CONTEXTS; i++) {
+        size_t before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+        uint32_t start = micros();
+        contexts[i] = JSEngine::createContext();
+        uint32_t elapsed = micros() - start;
+        size_t after = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+
+        if (!contexts[i]) break;
+        created++;
+        totalBytes += before - after;
+        totalUs += elapsed;
+    }
+
+    if (created == 0) {
+        DOKI_LOGE(JS_ENGINE, "[bench] Failed to create context");
+        return;
+    }
+
+    uint32_t arithmeticUs = 0;
+    duk_context* ctx = (duk_context*)contexts[0];
+    uint32_t start = micros();
+    if (duk_peval_string(ctx, ARITHMETIC_SCRIPT) == 0) {
+        arithmeticUs = micros() - start;
+    }
+    duk_pop(ctx);
+
+    DOKI_LOGI(JS_ENGINE, "[bench] Duktape profile %s: %u B per context, createContext %u us, int loop %u us",
+              DUK_PROFILE, (unsigned)(totalBytes / created), (unsigned)(totalUs / created),
+              (unsigned)arithmeticUs);
+
+    for (uint8_t i = 0; i < created; i++) {
+        JSEngine::destroyContext(contexts[i]);
+    }
+
+#ifdef DOKI_JS_SHARED_HEAP
+    // Same measurement for apps in the shared heap; the first one also
+    // creates the heap, which then stays for the apps started later
+    void* shared[FOOTPRINT_CONTEXTS] = {};
+    size_t firstBytes = 0;
+    uint32_t extraBytes = 0;
+    uint8_t sharedCount = 0;
+
+    for (uint8_t i = 0; i < FOOTPRINT_CONTEXTS; i++) {
+        size_t before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+        shared[i] = JSEngine::createSharedContext();
+        size_t after = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+
+        if (!shared[i]) break;
+        sharedCount++;
+        if (i == 0) firstBytes = before - after;
+        else extraBytes += before - after;
+    }
+
+    if (sharedCount > 1) {
+        DOKI_LOGI(JS_ENGINE, "[bench] Shared heap: first app %u B, each additional app %u B",
+                  (unsigned)firstBytes, (unsigned)(extraBytes / (sharedCount - 1)));
+    }
+
+    for (uint8_t i = 0; i < sharedCount; i++) {
+        JSEngine::destroySharedContext(shared[i]);
+    }
+#endif
+}
+
+} // namespace Doki
+
+#endif // DOKI_JS_BENCHMARKS && ENABLE_JAVASCRIPT_SUPPORT
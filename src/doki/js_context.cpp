@@ -0,0 +1,274 @@
+/**
+ * @file js_context.cpp
+ * @brief Implementation of per-context native state for JS contexts
+ */
+
+#include "doki/js_context.h"
+#include "doki/logger.h"
+#include <esp_heap_caps.h>
+
+namespace Doki {
+
+// Slot index lives in the low 16 bits of a handle
+static constexpr size_t MAX_HANDLES = 0xFFFF;
+
+JSHandleTable::JSHandleTable()
+    : _live(0)
+{
+}
+
+JSHandleTable::~JSHandleTable() {
+    // Objects may outlive the context (the screen is cleaned by the next
+    // app), so their delete hooks must not point at a freed table
+    for (size_t i = 0; i < _slots.size(); i++) {
+        if (_slots[i].obj) {
+            _release((uint16_t)i, true);
+        }
+    }
+}
+
+uint32_t JSHandleTable::add(lv_obj_t* obj) {
+    if (!obj) return INVALID_HANDLE;
+
+    uint16_t index;
+    if (!_freeList.empty()) {
+        index = _freeList.back();
+        _freeList.pop_back();
+    } else {
+        if (_slots.size() >= MAX_HANDLES) {
+            DOKI_LOGE(JS_ENGINE, "Handle table full");
+            return INVALID_HANDLE;
+        }
+        index = (uint16_t)_slots.size();
+        _slots.push_back({nullptr, 1});
+    }
+
+    Slot& slot = _slots[index];
+    slot.obj = obj;
+    _live++;
+
+    lv_obj_add_event_cb(obj, _onObjectDeleted, LV_EVENT_DELETE, this);
+
+    return ((uint32_t)slot.generation << 16) | index;
+}
+
+void JSHandleTable::clear() {
+    for (size_t i = 0; i < _slots.size(); i++) {
+        if (_slots[i].obj) {
+            _release((uint16_t)i, true);
+        }
+    }
+}
+
+void JSHandleTable::_release(uint16_t index, bool detachHook) {
+    Slot& slot = _slots[index];
+
+    if (detachHook) {
+        lv_obj_remove_event_cb_with_user_data(slot.obj, _onObjectDeleted, this);
+    }
+
+    slot.obj = nullptr;
+    slot.generation++;
+    if (slot.generation == 0) {
+        slot.generation = 1;  // Generation 0 is reserved for INVALID_HANDLE
+    }
+
+    _freeList.push_back(index);
+    _live--;
+}
+
+void JSHandleTable::_onObjectDeleted(lv_event_t* e) {
+    JSHandleTable* table = (JSHandleTable*)lv_event_get_user_data(e);
+    lv_obj_t* obj = lv_event_get_target(e);
+
+    // Deletions are rare compared to lookups, so a linear scan is fine here
+    for (size_t i = 0; i < table->_slots.size(); i++) {
+        if (table->_slots[i].obj == obj) {
+            table->_release((uint16_t)i, false);
+            return;
+        }
+    }
+}
+
+// ========================================
+// JSTimerWheel
+// ========================================
+
+JSTimerWheel::JSTimerWheel()
+    : _lastTick(millis() / TICK_MS),
+      _nextId(1),
+      _count(0)
+{
+}
+
+uint32_t JSTimerWheel::add(uint32_t delayMs, uint32_t intervalMs, uint32_t now) {
+    uint32_t id = _nextId++;
+    if (_nextId == 0) _nextId = 1;
+
+    _insert({id, now + delayMs, intervalMs});
+    return id;
+}
+
+bool JSTimerWheel::cancel(uint32_t id) {
+    for (uint32_t s = 0; s < SLOTS; s++) {
+        std::vector<Timer>& slot = _slots[s];
+        for (size_t i = 0; i < slot.size(); i++) {
+            if (slot[i].id == id) {
+                slot[i] = slot.back();
+                slot.pop_back();
+                _count--;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void JSTimerWheel::advance(uint32_t now, std::vector<Fired>& fired) {
+    uint32_t nowTick = now / TICK_MS;
+    if (_count == 0) {
+        _lastTick = nowTick;
+        return;
+    }
+
+    // Visit each elapsed tick's bucket once (all buckets after a long gap)
+    uint32_t ticks = nowTick - _lastTick + 1;
+    if (ticks > SLOTS) ticks = SLOTS;
+
+    std::vector<Timer> rearm;
+
+    for (uint32_t t = 0; t < ticks; t++) {
+        std::vector<Timer>& slot = _slots[(nowTick - t) % SLOTS];
+
+        for (size_t i = 0; i < slot.size(); ) {
+            Timer& timer = slot[i];
+
+            // Same bucket, later lap of the wheel
+            if ((int32_t)(now - timer.due) < 0) {
+                i++;
+                continue;
+            }
+
+            fired.push_back({timer.id, timer.interval > 0});
+
+            if (timer.interval > 0) {
+                Timer next = timer;
+                next.due += timer.interval;
+                if ((int32_t)(now - next.due) >= 0) {
+                    next.due = now + timer.interval;  // Fell behind - skip missed runs
+                }
+                rearm.push_back(next);
+            }
+
+            timer = slot.back();
+            slot.pop_back();
+            _count--;
+        }
+    }
+
+    _lastTick = nowTick;
+
+    for (const Timer& timer : rearm) {
+        _insert(timer);
+    }
+}
+
+uint32_t JSTimerWheel::nextDelay(uint32_t now) const {
+    uint32_t best = UINT32_MAX;
+
+    for (uint32_t s = 0; s < SLOTS && _count > 0; s++) {
+        for (const Timer& timer : _slots[s]) {
+            int32_t delta = (int32_t)(timer.due - now);
+            uint32_t delay = delta > 0 ? (uint32_t)delta : 0;
+            if (delay < best) best = delay;
+        }
+    }
+
+    return best;
+}
+
+void JSTimerWheel::_insert(const Timer& timer) {
+    _slots[(timer.due / TICK_MS) % SLOTS].push_back(timer);
+    _count++;
+}
+
+// ========================================
+// JSMessageQueue
+// ========================================
+
+JSMessageQueue::JSMessageQueue()
+    : _slots(nullptr), _head(0), _tail(0), _received(0), _dropped(0) {}
+
+JSMessageQueue::~JSMessageQueue() {
+    free(_slots);
+}
+
+bool JSMessageQueue::open() {
+    if (_slots) {
+        return true;
+    }
+
+    // Only ever memcpy'd, so PSRAM is fine
+    size_t bytes = sizeof(Message) * JS_MESSAGE_QUEUE_SLOTS;
+    _slots = (Message*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+    if (!_slots) {
+        _slots = (Message*)malloc(bytes);
+    }
+
+    return _slots != nullptr;
+}
+
+bool JSMessageQueue::push(const char* topic, const uint8_t* payload, size_t length) {
+    uint32_t head = _head.load(std::memory_order_relaxed);
+
+    if (!_slots || head - _tail.load(std::memory_order_acquire) >= JS_MESSAGE_QUEUE_SLOTS) {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    Message& msg = _slots[head % JS_MESSAGE_QUEUE_SLOTS];
+
+    size_t topicLength = topic ? strnlen(topic, sizeof(msg.topic) - 1) : 0;
+    memcpy(msg.topic, topic ? topic : "", topicLength);
+    msg.topic[topicLength] = '\0';
+    msg.topicLength = topicLength;
+
+    msg.truncated = length > sizeof(msg.payload) - 1;
+    if (msg.truncated) length = sizeof(msg.payload) - 1;
+    memcpy(msg.payload, payload, length);
+    msg.payload[length] = '\0';
+    msg.length = length;
+
+    _head.store(head + 1, std::memory_order_release);
+    _received.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+const JSMessageQueue::Message* JSMessageQueue::front() const {
+    uint32_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail == _head.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    return &_slots[tail % JS_MESSAGE_QUEUE_SLOTS];
+}
+
+void JSMessageQueue::pop() {
+    _tail.store(_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+size_t JSMessageQueue::size() const {
+    return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_relaxed);
+}
+
+// ========================================
+// JSSharedApps
+// ========================================
+
+JSContextData* JSSharedApps::find(duk_context* ctx) const {
+    for (JSContextData* app : apps) {
+        if (app && app->thread == ctx) return app;
+    }
+    return running;
+}
+
+} // namespace Doki
@@ -0,0 +1,147 @@
+/**
+ * @file js_context_pool.cpp
+ * @brief Implementation of the warm JS context pool
+ */
+
+#include "doki/js_context_pool.h"
+#include "doki/js_engine.h"
+#include "doki/logger.h"
+#include "hardware_config.h"
+#include "timing_constants.h"
+
+namespace Doki {
+
+// ========================================
+// Static Member Initialization
+// ========================================
+
+QueueHandle_t JSContextPool::_ready = nullptr;
+QueueHandle_t JSContextPool::_retired = nullptr;
+TaskHandle_t JSContextPool::_task = nullptr;
+uint32_t JSContextPool::_hits = 0;
+uint32_t JSContextPool::_misses = 0;
+
+// ========================================
+// Public Methods
+// ========================================
+
+bool JSContextPool::init() {
+    if (_task) {
+        return true;
+    }
+
+    if (!JSEngine::isEnabled()) {
+        return false;
+    }
+
+    _ready = xQueueCreate(JS_CONTEXT_POOL_SIZE, sizeof(void*));
+    _retired = xQueueCreate(JS_CONTEXT_RETIRE_QUEUE_SIZE, sizeof(void*));
+    if (!_ready || !_retired) {
+        DOKI_LOGE(JS_ENGINE, "✗ Failed to create context pool queues");
+        _deleteQueues();
+        return false;
+    }
+
+    BaseType_t created = xTaskCreatePinnedToCore(
+        _poolTask,
+        "JS_ContextPool",
+        TASK_STACK_JS_POOL,
+        nullptr,
+        TASK_PRIORITY_JS_POOL,
+        &_task,
+        TASK_CORE_JS_POOL
+    );
+    if (created != pdPASS) {
+        _task = nullptr;
+        _deleteQueues();
+        DOKI_LOGE(JS_ENGINE, "✗ Failed to start context pool task, contexts are built on demand");
+        return false;
+    }
+
+#ifdef DOKI_JS_SHARED_HEAP
+    DOKI_LOGI(JS_ENGINE, "✓ Context pool started (teardown only, shared heap)");
+#else
+    DOKI_LOGI(JS_ENGINE, "✓ Context pool started (%d warm contexts)", JS_CONTEXT_POOL_SIZE);
+#endif
+    return true;
+}
+
+void* JSContextPool::acquire() {
+    void* ctx = nullptr;
+
+    if (_ready && xQueueReceive(_ready, &ctx, 0) == pdTRUE) {
+        _hits++;
+        xTaskNotifyGive(_task);  // Refill (_ready exists only with the task)
+        DOKI_LOGD(JS_ENGINE, "Context pool hit (%u ready)", (unsigned)getReadyCount());
+        return ctx;
+    }
+
+    _misses++;
+    DOKI_LOGD(JS_ENGINE, "Context pool empty, creating context synchronously");
+    return JSEngine::createContext();
+}
+
+void JSContextPool::release(void* ctx) {
+    if (!ctx) return;
+
+    // Must happen on the owning thread, before the context changes hands
+    JSEngine::detachContext(ctx);
+
+    if (!_retired || xQueueSend(_retired, &ctx, 0) != pdTRUE) {
+        JSEngine::destroyDetachedContext(ctx);
+        return;
+    }
+
+    xTaskNotifyGive(_task);
+}
+
+uint32_t JSContextPool::getReadyCount() {
+    return _ready ? uxQueueMessagesWaiting(_ready) : 0;
+}
+
+// ========================================
+// Private Helper Methods
+// ========================================
+
+void JSContextPool::_deleteQueues() {
+    // Without queues acquire() creates and release() destroys on the caller's thread
+    if (_ready) vQueueDelete(_ready);
+    if (_retired) vQueueDelete(_retired);
+    _ready = nullptr;
+    _retired = nullptr;
+}
+
+void JSContextPool::_poolTask(void* param) {
+    // Let boot finish before competing for the heap
+    vTaskDelay(pdMS_TO_TICKS(DELAY_JS_POOL_START_MS));
+
+    while (true) {
+        void* ctx = nullptr;
+
+        // Destroy retired contexts first - frees memory for new ones
+        while (xQueueReceive(_retired, &ctx, 0) == pdTRUE) {
+            JSEngine::destroyDetachedContext(ctx);
+        }
+
+#ifndef DOKI_JS_SHARED_HEAP
+        // Top up the pool (with a shared heap, private heaps are the exception)
+        while (uxQueueSpacesAvailable(_ready) > 0) {
+            if (ESP.getFreeHeap() < JS_CONTEXT_POOL_MIN_FREE_HEAP) {
+                DOKI_LOGW(JS_ENGINE, "Context pool paused: low heap (%u bytes)",
+                          (unsigned)ESP.getFreeHeap());
+                break;
+            }
+
+            ctx = JSEngine::createContext();
+            if (!ctx) break;
+
+            xQueueSend(_ready, &ctx, 0);
+        }
+#endif
+
+        // Sleep until a context is claimed or retired
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(UPDATE_INTERVAL_JS_POOL_MS));
+    }
+}
+
+} // namespace Doki
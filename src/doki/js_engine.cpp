@@ -4,6 +4,14 @@
  */
 
 #include "doki/js_engine.h"
+#include "doki/js_context.h"
+#include "doki/js_http_worker.h"
+#include "doki/js_module_cache.h"
+#include "doki/js_profiler.h"
+#include "doki/js_ui_template.h"
+#include "doki/tracer.h"
+#include "doki/lvgl_manager.h"
+#include "doki/logger.h"
 #include "doki/filesystem_manager.h"
 #include "doki/state_persistence.h"
 #include "doki/app_manager.h"
@@ -12,6 +20,7 @@
 #include "hardware_config.h"
 #include "timing_constants.h"
 #include <lvgl.h>
+#include <esp_heap_caps.h>
 #include <HTTPClient.h>
 #include <PubSubClient.h>
 
@@ -26,44 +35,59 @@ namespace Doki {
 // Static member initialization
 bool JSEngine::_initialized = false;
 String JSEngine::_lastError = "";
+SemaphoreHandle_t JSEngine::_errorMutex = nullptr;
+#if defined(DOKI_JS_SHARED_HEAP) && defined(ENABLE_JAVASCRIPT_SUPPORT)
+duk_context* JSEngine::_sharedHeap = nullptr;
+JSContextData* JSEngine::_sharedData = nullptr;
+#endif
 
 bool JSEngine::init() {
     if (_initialized) {
-        Serial.println("[JSEngine] Already initialized");
+        DOKI_LOGI(JS_ENGINE, "Already initialized");
         return true;
     }
 
+    // The pool task creates contexts on core 0 while apps run on core 1
+    _errorMutex = xSemaphoreCreateMutex();
+
 #ifdef ENABLE_JAVASCRIPT_SUPPORT
-    Serial.println("[JSEngine] Initializing Duktape...");
+    DOKI_LOGI(JS_ENGINE, "Initializing Duktape...");
+#ifdef DOKI_JS_PROFILER
+    JSProfiler::init();
+#endif
     _initialized = true;
-    Serial.println("[JSEngine] ✓ Duktape initialized");
-    Serial.println("[JSEngine] Note: NTP will be initialized after WiFi connection");
+    DOKI_LOGI(JS_ENGINE, "✓ Duktape initialized");
+    DOKI_LOGI(JS_ENGINE, "Note: NTP will be initialized after WiFi connection");
     return true;
 #else
-    Serial.println("[JSEngine] JavaScript support not enabled");
-    Serial.println("[JSEngine] To enable: Download Duktape from https://duktape.org/");
-    Serial.println("[JSEngine] Add duktape.c/h to lib/duktape/ and uncomment ENABLE_JAVASCRIPT_SUPPORT");
-    _lastError = "JavaScript support not compiled in";
+    DOKI_LOGI(JS_ENGINE, "JavaScript support not enabled");
+    DOKI_LOGI(JS_ENGINE, "To enable: Download Duktape from https://duktape.org/");
+    DOKI_LOGI(JS_ENGINE, "Add duktape.c/h to lib/duktape/ and uncomment ENABLE_JAVASCRIPT_SUPPORT");
+    _setLastError("JavaScript support not compiled in");
     return false;
 #endif
 }
 
 void* JSEngine::createContext() {
 #ifdef ENABLE_JAVASCRIPT_SUPPORT
-    duk_context* ctx = duk_create_heap_default();
+    // Native per-context state lives in the heap userdata
+    JSContextData* data = new JSContextData();
+
+    duk_context* ctx = duk_create_heap(_alloc, _realloc, _free, data, nullptr);
     if (!ctx) {
-        _lastError = "Failed to create Duktape heap";
-        Serial.println("[JSEngine] Error: Failed to create context");
+        delete data;
+        _setLastError("Failed to create Duktape heap");
+        DOKI_LOGE(JS_ENGINE, "Error: Failed to create context");
         return nullptr;
     }
 
     // Register Doki OS APIs
     registerDokiAPIs(ctx);
 
-    Serial.println("[JSEngine] ✓ Created JS context");
+    DOKI_LOGI(JS_ENGINE, "✓ Created JS context");
     return ctx;
 #else
-    _lastError = "JavaScript support not enabled";
+    _setLastError("JavaScript support not enabled");
     return nullptr;
 #endif
 }
@@ -71,16 +95,148 @@ void* JSEngine::createContext() {
 void JSEngine::destroyContext(void* ctx) {
 #ifdef ENABLE_JAVASCRIPT_SUPPORT
     if (ctx) {
+        detachContext(ctx);
+        destroyDetachedContext(ctx);
+    }
+#endif
+}
+
+void JSEngine::destroyDetachedContext(void* ctx) {
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+    if (ctx) {
+        JSContextData* data = getContextData((duk_context*)ctx);
+
         duk_destroy_heap((duk_context*)ctx);
-        Serial.println("[JSEngine] Context destroyed");
+        delete data;
+
+        DOKI_LOGI(JS_ENGINE, "Context destroyed");
+    }
+#endif
+}
+
+void JSEngine::detachContext(void* ctx) {
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+    if (ctx) {
+        JSContextData* data = getContextData((duk_context*)ctx);
+
+        // Detaching LVGL delete hooks touches objects, so hold the lock
+        LVGLManager::lock();
+
+        // Canvases must not outlive their pixel buffers, which go with the heap
+        for (const JSCanvas& canvas : data->canvases) {
+            if (lv_obj_t* obj = data->handles.resolve(canvas.handle)) {
+                lv_obj_del(obj);
+            }
+        }
+        data->handles.clear();
+
+        LVGLManager::unlock();
+
+        _detachNetwork((duk_context*)ctx);
+        JSHttpWorker::cancelAll(ctx);
+        data->httpPending = 0;
     }
 #endif
 }
 
+#if defined(DOKI_JS_SHARED_HEAP) && defined(ENABLE_JAVASCRIPT_SUPPORT)
+// ========================================
+// Shared Heap
+// ========================================
+
+void* JSEngine::createSharedContext() {
+    size_t freeBefore = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+
+    if (!_sharedHeap) {
+        JSContextData* heapData = new JSContextData();
+        heapData->shared = new JSSharedApps();
+
+        _sharedHeap = duk_create_heap(_alloc, _realloc, _free, heapData, nullptr);
+        if (!_sharedHeap) {
+            delete heapData;
+            _setLastError("Failed to create shared Duktape heap");
+            DOKI_LOGE(JS_ENGINE, "Error: Failed to create shared heap");
+            return nullptr;
+        }
+
+        _sharedData = heapData;
+        _sharedData->shared->heapBytes = freeBefore - heap_caps_get_free_size(MALLOC_CAP_8BIT);
+        DOKI_LOGI(JS_ENGINE, "✓ Created shared JS heap (%u B)", (unsigned)_sharedData->shared->heapBytes);
+        freeBefore = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    }
+
+    JSSharedApps* apps = _sharedData->shared;
+    int slot = -1;
+    for (int i = 0; i < JS_SHARED_HEAP_MAX_APPS; i++) {
+        if (!apps->apps[i]) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0) {
+        _setLastError("Shared heap full");
+        DOKI_LOGW(JS_ENGINE, "Shared heap full (%d apps)", JS_SHARED_HEAP_MAX_APPS);
+        return nullptr;
+    }
+
+    // The heap stash keeps the thread alive; its slot index is the app slot
+    duk_push_heap_stash(_sharedHeap);
+    duk_push_thread_new_globalenv(_sharedHeap);
+    duk_context* thread = duk_get_context(_sharedHeap, -1);
+    duk_put_prop_index(_sharedHeap, -2, (duk_uarridx_t)slot);
+    duk_pop(_sharedHeap);
+
+    JSContextData* data = new JSContextData();
+    data->thread = thread;
+    apps->apps[slot] = data;
+    apps->count++;
+
+    registerDokiAPIs(thread);
+
+    DOKI_LOGI(JS_ENGINE, "✓ Created shared JS context %d/%d (+%u B)",
+              apps->count, JS_SHARED_HEAP_MAX_APPS,
+              (unsigned)(freeBefore - heap_caps_get_free_size(MALLOC_CAP_8BIT)));
+    return thread;
+}
+
+void JSEngine::destroySharedContext(void* ctx) {
+    if (!ctx || !_sharedData) return;
+
+    JSSharedApps* apps = _sharedData->shared;
+    for (int slot = 0; slot < JS_SHARED_HEAP_MAX_APPS; slot++) {
+        JSContextData* data = apps->apps[slot];
+        if (!data || data->thread != ctx) continue;
+
+        detachContext(ctx);
+
+        // Closures and the global object form cycles, so refcounting alone
+        // would leave the app's globals for a later mark-and-sweep
+        duk_push_heap_stash(_sharedHeap);
+        duk_del_prop_index(_sharedHeap, -1, (duk_uarridx_t)slot);
+        duk_pop(_sharedHeap);
+        duk_gc(_sharedHeap, 0);
+
+        if (apps->running == data) {
+            apps->running = nullptr;
+        }
+        apps->apps[slot] = nullptr;
+        apps->count--;
+        delete data;  // Canvas pixels go only once nothing can reach them
+
+        DOKI_LOGI(JS_ENGINE, "Shared context destroyed (%d left)", apps->count);
+        return;
+    }
+}
+
+bool JSEngine::isSharedContext(void* ctx) {
+    return ctx && _sharedData && _getHeapData((duk_context*)ctx) == _sharedData;
+}
+#endif
+
 bool JSEngine::loadScript(void* ctx, const char* filepath) {
 #ifdef ENABLE_JAVASCRIPT_SUPPORT
     if (!ctx || !filepath) {
-        _lastError = "Invalid context or filepath";
+        _setLastError("Invalid context or filepath");
         return false;
     }
 
@@ -89,14 +245,15 @@ bool JSEngine::loadScript(void* ctx, const char* filepath) {
     size_t size = 0;
 
     if (!FilesystemManager::readFile(filepath, &data, size)) {
-        _lastError = String("Failed to open: ") + filepath;
-        Serial.printf("[JSEngine] Error: %s\n", _lastError.c_str());
+        String error = String("Failed to open: ") + filepath;
+        _setLastError(error);
+        DOKI_LOGE(JS_ENGINE, "Error: %s", error.c_str());
         return false;
     }
 
     if (size == 0 || !data) {
-        _lastError = "Empty JavaScript file";
-        Serial.println("[JSEngine] Error: Empty file");
+        _setLastError("Empty JavaScript file");
+        DOKI_LOGE(JS_ENGINE, "Error: Empty file");
         if (data) delete[] data;
         return false;
     }
@@ -104,7 +261,7 @@ bool JSEngine::loadScript(void* ctx, const char* filepath) {
     // Allocate buffer with space for null terminator
     char* code = new char[size + 1];
     if (!code) {
-        _lastError = "Out of memory";
+        _setLastError("Out of memory");
         delete[] data;
         return false;
     }
@@ -114,8 +271,8 @@ bool JSEngine::loadScript(void* ctx, const char* filepath) {
     code[size] = '\0';
     delete[] data;
 
-    Serial.printf("[JSEngine] Loaded %d bytes from %s\n", size, filepath);
-    Serial.printf("[JSEngine] Script content:\n%s\n", code);
+    DOKI_LOGI(JS_ENGINE, "Loaded %u bytes from %s", (unsigned)size, filepath);
+    DOKI_LOGV(JS_ENGINE, "Script content:\n%s", code);
 
     // Execute the script
     bool result = executeScript(ctx, code);
@@ -123,7 +280,7 @@ bool JSEngine::loadScript(void* ctx, const char* filepath) {
 
     return result;
 #else
-    _lastError = "JavaScript support not enabled";
+    _setLastError("JavaScript support not enabled");
     return false;
 #endif
 }
@@ -131,25 +288,40 @@ bool JSEngine::loadScript(void* ctx, const char* filepath) {
 bool JSEngine::executeScript(void* ctx, const char* code) {
 #ifdef ENABLE_JAVASCRIPT_SUPPORT
     if (!ctx || !code) {
-        _lastError = "Invalid context or code";
+        _setLastError("Invalid context or code");
         return false;
     }
 
     duk_context* duk_ctx = (duk_context*)ctx;
 
     // Evaluate the script
-    if (duk_peval_string(duk_ctx, code) != 0) {
-        _lastError = String("Script error: ") + duk_safe_to_string(duk_ctx, -1);
-        Serial.printf("[JSEngine] Error: %s\n", _lastError.c_str());
+    DOKI_TRACE_SCOPE("js", "script");
+    _beginCall(duk_ctx);
+    duk_int_t rc = duk_peval_string(duk_ctx, code);
+    _endCall(duk_ctx);
+
+#ifdef DOKI_JS_PROFILER
+    JSContextData* data = getContextData(duk_ctx);
+    JSProfiler::recordCall(data->displayId, JSProfiler::CALL_SCRIPT, data->exec.lastCallUs);
+#endif
+
+    if (rc != 0) {
+        String error = String("Script error: ") + duk_safe_to_string(duk_ctx, -1);
+        _setLastError(error);
+        DOKI_LOGE(JS_ENGINE, "Error: %s", error.c_str());
         duk_pop(duk_ctx);
         return false;
     }
 
     duk_pop(duk_ctx);  // Pop result
-    Serial.println("[JSEngine] ✓ Script executed successfully");
+
+    // The script may have (re)defined lifecycle functions
+    resolveLifecycle(ctx);
+
+    DOKI_LOGI(JS_ENGINE, "✓ Script executed successfully");
     return true;
 #else
-    _lastError = "JavaScript support not enabled";
+    _setLastError("JavaScript support not enabled");
     return false;
 #endif
 }
@@ -157,34 +329,24 @@ bool JSEngine::executeScript(void* ctx, const char* code) {
 bool JSEngine::callFunction(void* ctx, const char* funcName) {
 #ifdef ENABLE_JAVASCRIPT_SUPPORT
     if (!ctx || !funcName) {
-        _lastError = "Invalid context or function name";
+        _setLastError("Invalid context or function name");
         return false;
     }
 
     duk_context* duk_ctx = (duk_context*)ctx;
 
     // Get function from global object
-    duk_push_global_object(duk_ctx);
-    duk_get_prop_string(duk_ctx, -1, funcName);
+    duk_get_global_string(duk_ctx, funcName);
 
     if (!duk_is_function(duk_ctx, -1)) {
         // Function doesn't exist - this is OK for optional lifecycle methods
-        duk_pop_2(duk_ctx);
+        duk_pop(duk_ctx);
         return true;  // Not an error
     }
 
-    // Call function
-    if (duk_pcall(duk_ctx, 0) != 0) {
-        _lastError = String("Function error: ") + duk_safe_to_string(duk_ctx, -1);
-        Serial.printf("[JSEngine] Error in %s(): %s\n", funcName, _lastError.c_str());
-        duk_pop_2(duk_ctx);
-        return false;
-    }
-
-    duk_pop_2(duk_ctx);  // Pop result and global
-    return true;
+    return _invoke(duk_ctx, 0, funcName, nullptr);
 #else
-    _lastError = "JavaScript support not enabled";
+    _setLastError("JavaScript support not enabled");
     return false;
 #endif
 }
@@ -192,248 +354,1008 @@ bool JSEngine::callFunction(void* ctx, const char* funcName) {
 bool JSEngine::callFunctionWithArgs(void* ctx, const char* funcName, const JsonDocument& args) {
 #ifdef ENABLE_JAVASCRIPT_SUPPORT
     if (!ctx || !funcName) {
-        _lastError = "Invalid context or function name";
+        _setLastError("Invalid context or function name");
         return false;
     }
 
     duk_context* duk_ctx = (duk_context*)ctx;
 
     // Get function
-    duk_push_global_object(duk_ctx);
-    duk_get_prop_string(duk_ctx, -1, funcName);
+    duk_get_global_string(duk_ctx, funcName);
 
     if (!duk_is_function(duk_ctx, -1)) {
-        duk_pop_2(duk_ctx);
+        duk_pop(duk_ctx);
         return true;  // Not an error if function doesn't exist
     }
 
-    // Convert JSON to JavaScript object
-    String jsonStr;
-    serializeJson(args, jsonStr);
-    duk_push_string(duk_ctx, jsonStr.c_str());
-    duk_json_decode(duk_ctx, -1);
+    // Build the JavaScript argument straight from the JSON tree
+    pushJson(ctx, args.as<JsonVariantConst>());
 
-    // Call function with argument
-    if (duk_pcall(duk_ctx, 1) != 0) {
-        _lastError = String("Function error: ") + duk_safe_to_string(duk_ctx, -1);
-        Serial.printf("[JSEngine] Error in %s(): %s\n", funcName, _lastError.c_str());
-        duk_pop_2(duk_ctx);
+    return _invoke(duk_ctx, 1, funcName, nullptr);
+#else
+    _setLastError("JavaScript support not enabled");
+    return false;
+#endif
+}
+
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+bool JSEngine::_invoke(duk_context* ctx, duk_idx_t nargs, const char* name, JsonDocument* result) {
+    _beginCall(ctx);
+    duk_int_t rc = duk_pcall(ctx, nargs);
+    _endCall(ctx);
+
+    if (rc != 0) {
+        String error = String("Function error: ") + duk_safe_to_string(ctx, -1);
+        _setLastError(error);
+        DOKI_LOGE(JS_ENGINE, "Error in %s(): %s", name, error.c_str());
+        duk_pop(ctx);
         return false;
     }
 
-    duk_pop_2(duk_ctx);
+    if (result && !duk_is_undefined(ctx, -1)) {
+        if (!readJson(ctx, -1, result->to<JsonVariant>())) {
+            DOKI_LOGW(JS_ENGINE, "%s() returned a value that cannot be stored", name);
+            result->clear();
+        }
+    }
+
+    duk_pop(ctx);  // Pop result
     return true;
+}
+#endif
+
+// ========================================
+// JSON <-> JS Value Conversion
+// ========================================
+
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+static void _pushJsonValue(duk_context* ctx, JsonVariantConst value, uint8_t depth) {
+    // Two slots per level: the container and the value being built
+    if (depth > JS_JSON_MAX_DEPTH || !duk_check_stack(ctx, 2)) {
+        duk_push_undefined(ctx);
+        return;
+    }
+
+    if (value.is<JsonObjectConst>()) {
+        duk_push_object(ctx);
+        for (JsonPairConst member : value.as<JsonObjectConst>()) {
+            _pushJsonValue(ctx, member.value(), depth + 1);
+            duk_put_prop_lstring(ctx, -2, member.key().c_str(), member.key().size());
+        }
+    } else if (value.is<JsonArrayConst>()) {
+        duk_push_array(ctx);
+        duk_uarridx_t index = 0;
+        for (JsonVariantConst element : value.as<JsonArrayConst>()) {
+            _pushJsonValue(ctx, element, depth + 1);
+            duk_put_prop_index(ctx, -2, index++);
+        }
+    } else if (value.is<const char*>()) {
+        JsonString str = value.as<JsonString>();
+        duk_push_lstring(ctx, str.c_str(), str.size());
+    } else if (value.is<bool>()) {
+        duk_push_boolean(ctx, value.as<bool>());
+    } else if (value.is<double>()) {
+        duk_push_number(ctx, value.as<double>());
+    } else {
+        duk_push_null(ctx);
+    }
+}
+
+// Returns false to abort the whole conversion
+static bool _readJsonValue(duk_context* ctx, duk_idx_t index, JsonVariant out, uint8_t depth) {
+    if (depth > JS_JSON_MAX_DEPTH || !duk_check_stack(ctx, 3)) {
+        return false;
+    }
+
+    switch (duk_get_type(ctx, index)) {
+        case DUK_TYPE_BOOLEAN:
+            out.set((bool)duk_get_boolean(ctx, index));
+            return true;
+
+        case DUK_TYPE_NUMBER: {
+            double number = duk_get_number(ctx, index);
+            if (!isfinite(number)) {
+                out.set(nullptr);
+            } else if (fabs(number) <= 9007199254740992.0 && number == trunc(number)) {
+                out.set((int64_t)number);  // Keep integers (e.g. epoch ms) integral; 2^53 is exact
+            } else {
+                out.set(number);
+            }
+            return true;
+        }
+
+        case DUK_TYPE_STRING:
+            out.set(duk_get_string(ctx, index));
+            return true;
+
+        case DUK_TYPE_OBJECT:
+            break;
+
+        default:
+            out.set(nullptr);  // null, undefined, buffers, pointers
+            return true;
+    }
+
+    if (duk_is_array(ctx, index)) {
+        JsonArray array = out.to<JsonArray>();
+        duk_size_t length = duk_get_length(ctx, index);
+
+        for (duk_size_t i = 0; i < length; i++) {
+            duk_get_prop_index(ctx, index, i);
+            bool ok = _readJsonValue(ctx, duk_get_top_index(ctx), array.add<JsonVariant>(), depth + 1);
+            duk_pop(ctx);
+            if (!ok) return false;
+        }
+        return true;
+    }
+
+    JsonObject object = out.to<JsonObject>();
+    duk_enum(ctx, index, DUK_ENUM_OWN_PROPERTIES_ONLY);
+
+    while (duk_next(ctx, -1, 1)) {
+        bool ok = true;
+        if (!duk_is_function(ctx, -1) && !duk_is_undefined(ctx, -1)) {
+            ok = _readJsonValue(ctx, duk_get_top_index(ctx), object[duk_get_string(ctx, -2)], depth + 1);
+        }
+        duk_pop_2(ctx);  // key, value
+        if (!ok) {
+            duk_pop(ctx);  // enumerator
+            return false;
+        }
+    }
+
+    duk_pop(ctx);  // enumerator
+    return true;
+}
+
+struct JSReadJsonArgs {
+    duk_idx_t index;
+    JsonVariant out;
+    bool ok;
+};
+
+// Getters and proxies may throw while enumerating, so convert in a safe call
+static duk_ret_t _readJsonSafe(duk_context* ctx, void* udata) {
+    JSReadJsonArgs* args = (JSReadJsonArgs*)udata;
+    args->ok = _readJsonValue(ctx, args->index, args->out, 0);
+    return 0;
+}
+#endif
+
+void JSEngine::pushJson(void* ctx, JsonVariantConst value) {
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+    if (!ctx) return;
+    _pushJsonValue((duk_context*)ctx, value, 0);
+#endif
+}
+
+bool JSEngine::readJson(void* ctx, int index, JsonVariant out) {
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+    if (!ctx) return false;
+
+    duk_context* duk_ctx = (duk_context*)ctx;
+    JSReadJsonArgs args = { duk_normalize_index(duk_ctx, index), out, false };
+
+    if (duk_safe_call(duk_ctx, _readJsonSafe, &args, 0, 1) != DUK_EXEC_SUCCESS) {
+        DOKI_LOGD(JS_ENGINE, "JSON conversion threw: %s", duk_safe_to_string(duk_ctx, -1));
+        args.ok = false;
+    }
+    duk_pop(duk_ctx);
+
+    return args.ok;
 #else
-    _lastError = "JavaScript support not enabled";
     return false;
 #endif
 }
 
+// ========================================
+// Lifecycle Function Cache
+// ========================================
+
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+const char* const JSEngine::_lifecycleNames[(uint8_t)JSLifecycle::COUNT] = {
+    "onCreate", "onStart", "onUpdate", "onPause", "onDestroy", "onSaveState", "onRestoreState"
+};
+#endif
+
+void JSEngine::resolveLifecycle(void* ctx) {
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+    if (!ctx) return;
+
+    duk_context* duk_ctx = (duk_context*)ctx;
+    JSContextData* data = getContextData(duk_ctx);
+    const uint8_t count = (uint8_t)JSLifecycle::COUNT;
+
+    // Pass 1: capture the current functions; the stash array keeps them alive
+    duk_push_global_stash(duk_ctx);
+    duk_push_array(duk_ctx);
+    for (uint8_t i = 0; i < count; i++) {
+        duk_get_global_string(duk_ctx, _lifecycleNames[i]);
+        data->lifecycle[i] = duk_is_function(duk_ctx, -1) ? duk_get_heapptr(duk_ctx, -1) : nullptr;
+        duk_put_prop_index(duk_ctx, -2, i);
+    }
+    duk_put_prop_string(duk_ctx, -2, "__lifecycle");
+    duk_pop(duk_ctx);
+
+    // Pass 2: trap reassignment (fails for non-configurable bindings)
+    data->lifecycleGuarded = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        if (duk_safe_call(duk_ctx, _installLifecycleTrap, (void*)(uintptr_t)i, 0, 1) == DUK_EXEC_SUCCESS) {
+            data->lifecycleGuarded |= (1 << i);
+        } else {
+            DOKI_LOGD(JS_ENGINE, "%s is not configurable, using name lookup", _lifecycleNames[i]);
+        }
+        duk_pop(duk_ctx);
+    }
+#endif
+}
+
+bool JSEngine::hasLifecycle(void* ctx, JSLifecycle fn) {
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+    if (!ctx || fn >= JSLifecycle::COUNT) return false;
+
+    JSContextData* data = getContextData((duk_context*)ctx);
+    if (!(data->lifecycleGuarded & (1 << (uint8_t)fn))) {
+        return hasFunction(ctx, _lifecycleNames[(uint8_t)fn]);
+    }
+    return data->lifecycle[(uint8_t)fn] != nullptr;
+#else
+    return false;
+#endif
+}
+
+bool JSEngine::callLifecycle(void* ctx, JSLifecycle fn, const JsonDocument* args, JsonDocument* result) {
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+    if (!ctx || fn >= JSLifecycle::COUNT) {
+        _setLastError("Invalid context or function");
+        return false;
+    }
+
+    duk_context* duk_ctx = (duk_context*)ctx;
+    JSContextData* data = getContextData(duk_ctx);
+    uint8_t index = (uint8_t)fn;
+
+    if (data->lifecycleGuarded & (1 << index)) {
+        void* func = data->lifecycle[index];
+        if (!func) {
+            return true;  // Optional lifecycle method not defined
+        }
+        duk_push_heapptr(duk_ctx, func);
+    } else {
+        // Unguarded globals could have been reassigned behind our back
+        duk_get_global_string(duk_ctx, _lifecycleNames[index]);
+        if (!duk_is_function(duk_ctx, -1)) {
+            duk_pop(duk_ctx);
+            return true;
+        }
+    }
+
+    duk_idx_t nargs = 0;
+    if (args) {
+        pushJson(ctx, args->as<JsonVariantConst>());
+        nargs = 1;
+    }
+
+    DOKI_TRACE_SCOPE("js", _lifecycleNames[index]);
+    bool ok = _invoke(duk_ctx, nargs, _lifecycleNames[index], result);
+
+#ifdef DOKI_JS_PROFILER
+    JSProfiler::recordCall(data->displayId, index, data->exec.lastCallUs);
+#endif
+
+    return ok;
+#else
+    _setLastError("JavaScript support not enabled");
+    return false;
+#endif
+}
+
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+duk_ret_t JSEngine::_installLifecycleTrap(duk_context* ctx, void* udata) {
+    uint8_t index = (uint8_t)(uintptr_t)udata;
+
+    duk_push_global_object(ctx);
+    duk_push_string(ctx, _lifecycleNames[index]);
+
+    duk_push_c_function(ctx, _js_lifecycleGet, 0);
+    duk_set_magic(ctx, -1, index);
+    duk_push_c_function(ctx, _js_lifecycleSet, 1);
+    duk_set_magic(ctx, -1, index);
+
+    duk_def_prop(ctx, -4, DUK_DEFPROP_HAVE_GETTER | DUK_DEFPROP_HAVE_SETTER |
+                          DUK_DEFPROP_SET_CONFIGURABLE | DUK_DEFPROP_SET_ENUMERABLE);
+    duk_pop(ctx);  // global
+
+    duk_push_undefined(ctx);
+    return 1;
+}
+
+duk_ret_t JSEngine::_js_lifecycleGet(duk_context* ctx) {
+    duk_push_global_stash(ctx);
+    duk_get_prop_string(ctx, -1, "__lifecycle");
+    duk_get_prop_index(ctx, -1, duk_get_current_magic(ctx));
+    return 1;
+}
+
+duk_ret_t JSEngine::_js_lifecycleSet(duk_context* ctx) {
+    duk_int_t index = duk_get_current_magic(ctx);
+    JSContextData* data = getContextData(ctx);
+
+    data->lifecycle[index] = duk_is_function(ctx, 0) ? duk_get_heapptr(ctx, 0) : nullptr;
+
+    duk_push_global_stash(ctx);
+    duk_get_prop_string(ctx, -1, "__lifecycle");
+    duk_dup(ctx, 0);
+    duk_put_prop_index(ctx, -2, index);
+    return 0;
+}
+#endif
+
 void JSEngine::registerDokiAPIs(void* ctx) {
 #ifdef ENABLE_JAVASCRIPT_SUPPORT
     duk_context* duk_ctx = (duk_context*)ctx;
 
+#if defined(DOKI_DUK_LOWMEM)
+    // Built-in data still creates CBOR, whose functions only throw "unsupported"
+    duk_push_global_object(duk_ctx);
+    duk_del_prop_string(duk_ctx, -1, "CBOR");
+    duk_pop(duk_ctx);
+#endif
+
     // Basic logging
-    duk_push_c_function(duk_ctx, _js_log, 1);
-    duk_put_global_string(duk_ctx, "log");
+    _bind(duk_ctx, "log", _js_log, 1);
 
     // UI Creation
-    duk_push_c_function(duk_ctx, _js_createLabel, 3);
-    duk_put_global_string(duk_ctx, "createLabel");
+    _bind(duk_ctx, "createLabel", _js_createLabel, 3);
+    _bind(duk_ctx, "updateLabel", _js_updateLabel, 2);
+    _bind(duk_ctx, "setLabelColor", _js_setLabelColor, 2);
+    _bind(duk_ctx, "setLabelSize", _js_setLabelSize, 2);
+    _bind(duk_ctx, "createButton", _js_createButton, 3);
+    _bind(duk_ctx, "setBackgroundColor", _js_setBackgroundColor, 1);
+    _bind(duk_ctx, "clearScreen", _js_clearScreen, 0);
+
+    // Drawing
+    _bind(duk_ctx, "drawRectangle", _js_drawRectangle, 5);
+    _bind(duk_ctx, "drawCircle", _js_drawCircle, 4);
+
+    // Canvas
+    _bind(duk_ctx, "createCanvas", _js_createCanvas, 4);
+    _bind(duk_ctx, "canvasFill", _js_canvasFill, 6);
+    _bind(duk_ctx, "canvasBlit", _js_canvasBlit, 9);
+    _bind(duk_ctx, "invalidate", _js_invalidate, 5);
+
+    // Advanced Text
+    _bind(duk_ctx, "createScrollingLabel", _js_createScrollingLabel, 4);
+    _bind(duk_ctx, "setTextAlign", _js_setTextAlign, 2);
+
+    // Declarative UI
+    _bind(duk_ctx, "createUI", _js_createUI, 1);
+
+    // Screen Info
+    _bind(duk_ctx, "getWidth", _js_getWidth, 0);
+    _bind(duk_ctx, "getHeight", _js_getHeight, 0);
+    _bind(duk_ctx, "getDisplayId", _js_getDisplayId, 0);
+
+    // Text Styling
+    _bind(duk_ctx, "setTextColor", _js_setTextColor, 2);
+    _bind(duk_ctx, "setTextSize", _js_setTextSize, 2);
+
+    // State Persistence
+    _bind(duk_ctx, "saveState", _js_saveState, 2);
+    _bind(duk_ctx, "loadState", _js_loadState, 1);
+
+    // Time
+    _bind(duk_ctx, "millis", _js_millis, 0);
+    _bind(duk_ctx, "getTime", _js_getTime, 0);
+
+    // Timers
+    _bind(duk_ctx, "setTimeout", _js_setTimeout, 2);
+    _bind(duk_ctx, "setInterval", _js_setInterval, 2);
+    _bind(duk_ctx, "clearTimeout", _js_clearTimer, 1);
+    _bind(duk_ctx, "clearInterval", _js_clearTimer, 1);
+    _bind(duk_ctx, "requestAnimationFrame", _js_requestAnimationFrame, 1);
+    _bind(duk_ctx, "cancelAnimationFrame", _js_cancelAnimationFrame, 1);
+
+    // HTTP
+    _bind(duk_ctx, "httpGet", _js_httpGet, 2);
+
+    // Modules
+    _bind(duk_ctx, "require", _js_require, 1);
+
+    // Animations
+    _bind(duk_ctx, "fadeIn", _js_fadeIn, 2);
+    _bind(duk_ctx, "fadeOut", _js_fadeOut, 2);
+    _bind(duk_ctx, "moveLabel", _js_moveLabel, 4);
+    _bind(duk_ctx, "setOpacity", _js_setOpacity, 2);
+
+    // Batched updates
+    _bind(duk_ctx, "applyUpdates", _js_applyUpdates, 1);
+
+    // Multi-Display
+    _bind(duk_ctx, "getDisplayCount", _js_getDisplayCount, 0);
+    _bind(duk_ctx, "sendToDisplay", _js_sendToDisplay, 2);
+
+    // MQTT
+    _bind(duk_ctx, "mqttConnect", _js_mqttConnect, 3);
+    _bind(duk_ctx, "mqttPublish", _js_mqttPublish, 2);
+    _bind(duk_ctx, "mqttSubscribe", _js_mqttSubscribe, 2);
+    _bind(duk_ctx, "mqttDisconnect", _js_mqttDisconnect, 0);
+
+    // WebSocket
+    _bind(duk_ctx, "wsConnect", _js_wsConnect, 1);
+    _bind(duk_ctx, "wsIsConnected", _js_wsIsConnected, 0);
+    _bind(duk_ctx, "wsSend", _js_wsSend, 1);
+    _bind(duk_ctx, "wsOnMessage", _js_wsOnMessage, 1);
+    _bind(duk_ctx, "wsDisconnect", _js_wsDisconnect, 0);
+
+    // Animation
+    _bind(duk_ctx, "loadAnimation", _js_loadAnimation, 1);
+    _bind(duk_ctx, "playAnimation", _js_playAnimation, 2);
+    _bind(duk_ctx, "stopAnimation", _js_stopAnimation, 1);
+    _bind(duk_ctx, "pauseAnimation", _js_pauseAnimation, 1);
+    _bind(duk_ctx, "resumeAnimation", _js_resumeAnimation, 1);
+    _bind(duk_ctx, "setAnimationPosition", _js_setAnimationPosition, 3);
+    _bind(duk_ctx, "setAnimationSpeed", _js_setAnimationSpeed, 2);
+    _bind(duk_ctx, "setAnimationOpacity", _js_setAnimationOpacity, 2);
+    _bind(duk_ctx, "unloadAnimation", _js_unloadAnimation, 1);
+    _bind(duk_ctx, "updateAnimations", _js_updateAnimations, 0);
+
+    DOKI_LOGI(JS_ENGINE, "✓ Registered Doki OS APIs (Advanced Features Enabled + Animation)");
+#endif
+}
+
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+void JSEngine::_bind(duk_context* ctx, const char* name, duk_c_function fn, duk_idx_t nargs) {
+#ifdef DOKI_JS_PROFILER
+    // Route the call through the timing trampoline; magic selects the binding
+    int index = JSProfiler::registerBinding(name, fn);
+    if (index >= 0) {
+        duk_push_c_function(ctx, _js_profiled, nargs);
+        duk_set_magic(ctx, -1, index);
+        duk_put_global_string(ctx, name);
+        return;
+    }
+#endif
+    duk_push_c_function(ctx, fn, nargs);
+    duk_put_global_string(ctx, name);
+}
+
+#ifdef DOKI_JS_PROFILER
+duk_ret_t JSEngine::_js_profiled(duk_context* ctx) {
+    uint16_t index = (uint16_t)duk_get_current_magic(ctx);
+
+    uint32_t start = micros();
+    duk_ret_t rc = JSProfiler::getBinding(index)(ctx);
+    JSProfiler::recordBinding(getContextData(ctx)->displayId, index, micros() - start);
+
+    return rc;
+}
+#endif
+#endif
+
+void JSEngine::setDisplayId(void* ctx, uint8_t displayId) {
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+    if (!ctx) return;
+
+    getContextData((duk_context*)ctx)->displayId = displayId;
+
+    DOKI_LOGD(JS_ENGINE, "Set display ID to %d for context", displayId);
+#endif
+}
+
+void JSEngine::setAppId(void* ctx, const char* appId) {
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+    if (!ctx || !appId) return;
+
+    // Separate from the app's own record, which onSaveState() replaces
+    JSContextData* data = getContextData((duk_context*)ctx);
+    data->stateRecord = String(appId) + ".kv";
+    data->kvState.clear();
+    data->kvLoaded = false;
+
+    DOKI_LOGD(JS_ENGINE, "Set app ID to %s for context", appId);
+#endif
+}
+
+void JSEngine::setDisplayScreen(void* ctx, void* screen) {
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+    if (!ctx) return;
+
+    getContextData((duk_context*)ctx)->screen = (lv_obj_t*)screen;
+
+    DOKI_LOGD(JS_ENGINE, "Set display screen pointer %p for context", screen);
+#endif
+}
+
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+JSContextData* JSEngine::getContextData(duk_context* ctx) {
+    JSContextData* data = _getHeapData(ctx);
+#ifdef DOKI_JS_SHARED_HEAP
+    if (data->shared) {
+        return data->shared->find(ctx);
+    }
+#endif
+    return data;
+}
+
+JSContextData* JSEngine::_getHeapData(duk_context* ctx) {
+    duk_memory_functions funcs;
+    duk_get_memory_functions(ctx, &funcs);
+    return (JSContextData*)funcs.udata;
+}
+#endif
+
+String JSEngine::getLastError() {
+    if (!_errorMutex) return _lastError;
+
+    xSemaphoreTake(_errorMutex, portMAX_DELAY);
+    String error = _lastError;
+    xSemaphoreGive(_errorMutex);
+    return error;
+}
+
+void JSEngine::_setLastError(const String& error) {
+    if (!_errorMutex) {
+        _lastError = error;
+        return;
+    }
+
+    xSemaphoreTake(_errorMutex, portMAX_DELAY);
+    _lastError = error;
+    xSemaphoreGive(_errorMutex);
+}
+
+bool JSEngine::hasFunction(void* ctx, const char* funcName) {
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+    if (!ctx || !funcName) return false;
+
+    duk_context* duk_ctx = (duk_context*)ctx;
+    duk_get_global_string(duk_ctx, funcName);
+    bool result = duk_is_function(duk_ctx, -1);
+    duk_pop(duk_ctx);
+    return result;
+#else
+    return false;
+#endif
+}
+
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+// Call stash[table][id](arg) if present; removes the entry unless keep is set
+static bool _callStashedCallback(duk_context* ctx, const char* table, uint32_t id,
+                                 uint32_t arg, bool keep) {
+    duk_push_global_stash(ctx);
+    if (!duk_get_prop_string(ctx, -1, table)) {
+        duk_pop_2(ctx);
+        return false;
+    }
+
+    duk_get_prop_index(ctx, -1, id);
+    if (!duk_is_function(ctx, -1)) {
+        duk_pop_3(ctx);
+        return false;  // Cancelled by an earlier callback
+    }
+
+    if (!keep) {
+        duk_del_prop_index(ctx, -2, id);
+    }
+
+    duk_push_uint(ctx, arg);
+    if (duk_pcall(ctx, 1) != 0) {
+        DOKI_LOGE(JS_ENGINE, "Error in %s callback %u: %s", table, (unsigned)id,
+                  duk_safe_to_string(ctx, -1));
+    }
+
+    duk_pop_3(ctx);  // result, table, stash
+    return true;
+}
 
-    duk_push_c_function(duk_ctx, _js_updateLabel, 2);
-    duk_put_global_string(duk_ctx, "updateLabel");
+// Deliver queued messages to the callback stored in the stash under `key`.
+// The callback may be a function or the name of a global function.
+// Messages stay queued while no callback is registered.
+static uint32_t _drainInbox(duk_context* ctx, JSMessageQueue& inbox, const char* key, bool withTopic) {
+    if (inbox.size() == 0) {
+        return 0;
+    }
 
-    duk_push_c_function(duk_ctx, _js_setLabelColor, 2);
-    duk_put_global_string(duk_ctx, "setLabelColor");
+    duk_push_global_stash(ctx);
+    duk_get_prop_string(ctx, -1, key);
+    if (duk_is_string(ctx, -1)) {
+        const char* name = duk_get_string(ctx, -1);
+        duk_pop(ctx);
+        duk_get_global_string(ctx, name);
+    }
+    if (!duk_is_function(ctx, -1)) {
+        // Nobody listens: discard, or the full ring would drop every later message
+        while (inbox.front() != nullptr) {
+            inbox.pop();
+        }
+        duk_pop_2(ctx);
+        return 0;
+    }
 
-    duk_push_c_function(duk_ctx, _js_setLabelSize, 2);
-    duk_put_global_string(duk_ctx, "setLabelSize");
+    JSContextData* data = JSEngine::getContextData(ctx);
+    uint32_t count = 0;
 
-    duk_push_c_function(duk_ctx, _js_createButton, 3);
-    duk_put_global_string(duk_ctx, "createButton");
+    // Bounded, so a flooding producer cannot hold the JS thread
+    const JSMessageQueue::Message* msg;
+    while (count < JS_MESSAGE_QUEUE_SLOTS && (msg = inbox.front()) != nullptr) {
+        duk_dup(ctx, -1);
+        if (withTopic) {
+            duk_push_lstring(ctx, msg->topic, msg->topicLength);
+        }
+        duk_push_lstring(ctx, msg->payload, msg->length);
+        inbox.pop();
+        count++;
+
+        if (duk_pcall(ctx, withTopic ? 2 : 1) != 0) {
+            DOKI_LOGE(JS_ENGINE, "Error in %s callback: %s", key, duk_safe_to_string(ctx, -1));
+        }
+        duk_pop(ctx);
+
+        if (data->timedOut) break;
+    }
+
+    duk_pop_2(ctx);  // callback, stash
+    return count;
+}
+
+// Deliver completed httpGet() responses as callback(body, status)
+static uint32_t _deliverHttpResponses(duk_context* ctx) {
+    JSContextData* data = JSEngine::getContextData(ctx);
+
+    std::vector<JSHttpWorker::Response> responses;
+    JSHttpWorker::collect(ctx, responses);
+    if (responses.empty()) {
+        return 0;
+    }
+
+    duk_push_global_stash(ctx);
+    duk_get_prop_string(ctx, -1, "__http");
+
+    uint32_t count = 0;
+    for (JSHttpWorker::Response& response : responses) {
+        data->httpPending--;
+
+        // Drop the stashed callback even when it can no longer run
+        if (duk_is_object(ctx, -1)) {
+            duk_get_prop_index(ctx, -1, response.id);
+            duk_del_prop_index(ctx, -2, response.id);
+
+            if (data->timedOut) {
+                duk_pop(ctx);
+                free(response.body);
+                continue;
+            }
+
+            if (duk_is_string(ctx, -1)) {
+                const char* name = duk_get_string(ctx, -1);
+                duk_pop(ctx);
+                duk_get_global_string(ctx, name);
+            }
 
-    duk_push_c_function(duk_ctx, _js_setBackgroundColor, 1);
-    duk_put_global_string(duk_ctx, "setBackgroundColor");
+            if (duk_is_function(ctx, -1)) {
+                if (response.body) {
+                    duk_push_lstring(ctx, response.body, response.length);
+                } else {
+                    duk_push_null(ctx);
+                }
+                duk_push_int(ctx, response.status);
 
-    duk_push_c_function(duk_ctx, _js_clearScreen, 0);
-    duk_put_global_string(duk_ctx, "clearScreen");
+                if (duk_pcall(ctx, 2) != 0) {
+                    DOKI_LOGE(JS_ENGINE, "Error in httpGet callback %u: %s", (unsigned)response.id,
+                              duk_safe_to_string(ctx, -1));
+                }
+                count++;
+            }
+            duk_pop(ctx);  // result or non-function
+        }
 
-    // Drawing
-    duk_push_c_function(duk_ctx, _js_drawRectangle, 5);
-    duk_put_global_string(duk_ctx, "drawRectangle");
+        free(response.body);
+    }
 
-    duk_push_c_function(duk_ctx, _js_drawCircle, 4);
-    duk_put_global_string(duk_ctx, "drawCircle");
+    duk_pop_2(ctx);  // __http, stash
+    return count;
+}
+#endif
 
-    // Advanced Text
-    duk_push_c_function(duk_ctx, _js_createScrollingLabel, 4);
-    duk_put_global_string(duk_ctx, "createScrollingLabel");
+uint32_t JSEngine::runTimers(void* ctx, uint32_t now) {
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+    if (!ctx) return 0;
 
-    duk_push_c_function(duk_ctx, _js_setTextAlign, 2);
-    duk_put_global_string(duk_ctx, "setTextAlign");
+    duk_context* duk_ctx = (duk_context*)ctx;
+    JSContextData* data = getContextData(duk_ctx);
 
-    // Screen Info
-    duk_push_c_function(duk_ctx, _js_getWidth, 0);
-    duk_put_global_string(duk_ctx, "getWidth");
+    std::vector<JSTimerWheel::Fired> fired;
+    data->timers.advance(now, fired);
+    if (fired.empty()) {
+        return 0;
+    }
 
-    duk_push_c_function(duk_ctx, _js_getHeight, 0);
-    duk_put_global_string(duk_ctx, "getHeight");
+    DOKI_TRACE_SCOPE("js", "timers");
+    uint32_t count = 0;
+    _beginCall(duk_ctx);
+    for (const JSTimerWheel::Fired& timer : fired) {
+        if (_callStashedCallback(duk_ctx, "__timers", timer.id, timer.id, timer.periodic)) {
+            count++;
+        }
+        if (data->timedOut) break;
+    }
+    _endCall(duk_ctx);
 
-    duk_push_c_function(duk_ctx, _js_getDisplayId, 0);
-    duk_put_global_string(duk_ctx, "getDisplayId");
+#ifdef DOKI_JS_PROFILER
+    JSProfiler::recordCall(data->displayId, JSProfiler::CALL_TIMERS, data->exec.lastCallUs);
+#endif
 
-    // Text Styling
-    duk_push_c_function(duk_ctx, _js_setTextColor, 2);
-    duk_put_global_string(duk_ctx, "setTextColor");
+    return count;
+#else
+    return 0;
+#endif
+}
 
-    duk_push_c_function(duk_ctx, _js_setTextSize, 2);
-    duk_put_global_string(duk_ctx, "setTextSize");
+uint32_t JSEngine::runAnimationFrame(void* ctx, uint32_t now) {
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+    if (!ctx) return 0;
 
-    // State Persistence
-    duk_push_c_function(duk_ctx, _js_saveState, 2);
-    duk_put_global_string(duk_ctx, "saveState");
+    duk_context* duk_ctx = (duk_context*)ctx;
+    JSContextData* data = getContextData(duk_ctx);
+    if (data->frameRequests.empty()) {
+        return 0;
+    }
 
-    duk_push_c_function(duk_ctx, _js_loadState, 1);
-    duk_put_global_string(duk_ctx, "loadState");
+    // Callbacks requesting the next frame must not run in this one
+    std::vector<uint32_t> requests;
+    requests.swap(data->frameRequests);
 
-    // Time
-    duk_push_c_function(duk_ctx, _js_millis, 0);
-    duk_put_global_string(duk_ctx, "millis");
+    DOKI_TRACE_SCOPE("js", "requestAnimationFrame");
+    uint32_t count = 0;
+    _beginCall(duk_ctx);
+    for (uint32_t id : requests) {
+        if (_callStashedCallback(duk_ctx, "__raf", id, now, false)) {
+            count++;
+        }
+        if (data->timedOut) break;
+    }
+    _endCall(duk_ctx);
 
-    duk_push_c_function(duk_ctx, _js_getTime, 0);
-    duk_put_global_string(duk_ctx, "getTime");
+#ifdef DOKI_JS_PROFILER
+    JSProfiler::recordCall(data->displayId, JSProfiler::CALL_FRAME, data->exec.lastCallUs);
+#endif
 
-    // HTTP
-    duk_push_c_function(duk_ctx, _js_httpGet, 1);
-    duk_put_global_string(duk_ctx, "httpGet");
+    return count;
+#else
+    return 0;
+#endif
+}
 
-    // Animations
-    duk_push_c_function(duk_ctx, _js_fadeIn, 2);
-    duk_put_global_string(duk_ctx, "fadeIn");
+uint32_t JSEngine::dispatchMessages(void* ctx) {
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+    if (!ctx) return 0;
 
-    duk_push_c_function(duk_ctx, _js_fadeOut, 2);
-    duk_put_global_string(duk_ctx, "fadeOut");
+    duk_context* duk_ctx = (duk_context*)ctx;
+    JSContextData* data = getContextData(duk_ctx);
 
-    duk_push_c_function(duk_ctx, _js_moveLabel, 4);
-    duk_put_global_string(duk_ctx, "moveLabel");
+    _pollNetwork(duk_ctx);
 
-    duk_push_c_function(duk_ctx, _js_setOpacity, 2);
-    duk_put_global_string(duk_ctx, "setOpacity");
+    if (data->mqttInbox.size() == 0 && data->wsInbox.size() == 0 && data->httpPending == 0) {
+        return 0;
+    }
 
-    // Multi-Display
-    duk_push_c_function(duk_ctx, _js_getDisplayCount, 0);
-    duk_put_global_string(duk_ctx, "getDisplayCount");
+    DOKI_TRACE_SCOPE("js", "messages");
+    _beginCall(duk_ctx);
+    uint32_t count = _drainInbox(duk_ctx, data->mqttInbox, "__mqtt_cb", true);
+    if (!data->timedOut) {
+        count += _drainInbox(duk_ctx, data->wsInbox, "__ws_cb", false);
+    }
+    if (data->httpPending > 0) {
+        count += _deliverHttpResponses(duk_ctx);
+    }
+    _endCall(duk_ctx);
 
-    duk_push_c_function(duk_ctx, _js_sendToDisplay, 2);
-    duk_put_global_string(duk_ctx, "sendToDisplay");
+#ifdef DOKI_JS_PROFILER
+    JSProfiler::recordCall(data->displayId, JSProfiler::CALL_MESSAGES, data->exec.lastCallUs);
+#endif
 
-    // MQTT
-    duk_push_c_function(duk_ctx, _js_mqttConnect, 3);
-    duk_put_global_string(duk_ctx, "mqttConnect");
+    return count;
+#else
+    return 0;
+#endif
+}
 
-    duk_push_c_function(duk_ctx, _js_mqttPublish, 2);
-    duk_put_global_string(duk_ctx, "mqttPublish");
+bool JSEngine::hasAnimationFrame(void* ctx) {
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+    if (!ctx) return false;
+    return !getContextData((duk_context*)ctx)->frameRequests.empty();
+#else
+    return false;
+#endif
+}
 
-    duk_push_c_function(duk_ctx, _js_mqttSubscribe, 1);
-    duk_put_global_string(duk_ctx, "mqttSubscribe");
+uint32_t JSEngine::getNextTimerDelay(void* ctx, uint32_t now) {
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+    if (!ctx) return UINT32_MAX;
+    return getContextData((duk_context*)ctx)->timers.nextDelay(now);
+#else
+    return UINT32_MAX;
+#endif
+}
 
-    duk_push_c_function(duk_ctx, _js_mqttDisconnect, 0);
-    duk_put_global_string(duk_ctx, "mqttDisconnect");
+bool JSEngine::hasTimedOut(void* ctx) {
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+    if (!ctx) return false;
+    return getContextData((duk_context*)ctx)->timedOut;
+#else
+    return false;
+#endif
+}
 
-    // WebSocket
-    duk_push_c_function(duk_ctx, _js_wsConnect, 1);
-    duk_put_global_string(duk_ctx, "wsConnect");
+bool JSEngine::getExecStats(void* ctx, JSExecStats& stats) {
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+    if (!ctx) return false;
+    stats = getContextData((duk_context*)ctx)->exec;
+    return true;
+#else
+    return false;
+#endif
+}
 
-    duk_push_c_function(duk_ctx, _js_wsIsConnected, 0);
-    duk_put_global_string(duk_ctx, "wsIsConnected");
+bool JSEngine::getMessageStats(void* ctx, JSMessageStats& stats) {
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+    if (!ctx) return false;
+    JSContextData* data = getContextData((duk_context*)ctx);
+    stats.mqttReceived = data->mqttInbox.getReceived();
+    stats.mqttDropped = data->mqttInbox.getDropped();
+    stats.wsReceived = data->wsInbox.getReceived();
+    stats.wsDropped = data->wsInbox.getDropped();
+    return true;
+#else
+    return false;
+#endif
+}
 
-    duk_push_c_function(duk_ctx, _js_wsSend, 1);
-    duk_put_global_string(duk_ctx, "wsSend");
+uint32_t JSEngine::collectGarbage(void* ctx) {
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+    if (!ctx) return 0;
+    JSContextData* data = _getHeapData((duk_context*)ctx);  // GC is heap-wide
 
-    duk_push_c_function(duk_ctx, _js_wsOnMessage, 0);
-    duk_put_global_string(duk_ctx, "wsOnMessage");
+    uint32_t start = micros();
+    duk_gc((duk_context*)ctx, 0);
+    uint32_t pauseUs = micros() - start;
 
-    duk_push_c_function(duk_ctx, _js_wsDisconnect, 0);
-    duk_put_global_string(duk_ctx, "wsDisconnect");
+    JSGcStats& gc = data->gc;
+    gc.idleRuns++;
+    gc.idleTotalUs += pauseUs;
+    gc.lastPauseUs = pauseUs;
+    if (pauseUs > gc.maxPauseUs) gc.maxPauseUs = pauseUs;
+    gc.allocsSinceGc = 0;
 
-    // Animation
-    duk_push_c_function(duk_ctx, _js_loadAnimation, 1);
-    duk_put_global_string(duk_ctx, "loadAnimation");
+    return pauseUs;
+#else
+    return 0;
+#endif
+}
 
-    duk_push_c_function(duk_ctx, _js_playAnimation, 2);
-    duk_put_global_string(duk_ctx, "playAnimation");
+bool JSEngine::getGcStats(void* ctx, JSGcStats& stats) {
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+    if (!ctx) return false;
+    stats = _getHeapData((duk_context*)ctx)->gc;
+    return true;
+#else
+    return false;
+#endif
+}
 
-    duk_push_c_function(duk_ctx, _js_stopAnimation, 1);
-    duk_put_global_string(duk_ctx, "stopAnimation");
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+// ========================================
+// Heap Allocators
+// ========================================
 
-    duk_push_c_function(duk_ctx, _js_pauseAnimation, 1);
-    duk_put_global_string(duk_ctx, "pauseAnimation");
+void* JSEngine::_alloc(void* udata, duk_size_t size) {
+    JSContextData* data = (JSContextData*)udata;
+    void* ptr = malloc(size);
 
-    duk_push_c_function(duk_ctx, _js_resumeAnimation, 1);
-    duk_put_global_string(duk_ctx, "resumeAnimation");
+    data->gc.allocsSinceGc++;
+    if (!ptr && size > 0) {
+        data->gc.emergency++;  // Duktape runs an emergency mark-and-sweep and retries
+    }
+    return ptr;
+}
 
-    duk_push_c_function(duk_ctx, _js_setAnimationPosition, 3);
-    duk_put_global_string(duk_ctx, "setAnimationPosition");
+void* JSEngine::_realloc(void* udata, void* ptr, duk_size_t size) {
+    JSContextData* data = (JSContextData*)udata;
+    void* result = realloc(ptr, size);
 
-    duk_push_c_function(duk_ctx, _js_setAnimationSpeed, 2);
-    duk_put_global_string(duk_ctx, "setAnimationSpeed");
+    data->gc.allocsSinceGc++;
+    if (!result && size > 0) {
+        data->gc.emergency++;
+    }
+    return result;
+}
 
-    duk_push_c_function(duk_ctx, _js_setAnimationOpacity, 2);
-    duk_put_global_string(duk_ctx, "setAnimationOpacity");
+void JSEngine::_free(void* udata, void* ptr) {
+    (void)udata;
+    free(ptr);
+}
 
-    duk_push_c_function(duk_ctx, _js_unloadAnimation, 1);
-    duk_put_global_string(duk_ctx, "unloadAnimation");
+// ========================================
+// Top-Level Call Accounting
+// ========================================
 
-    duk_push_c_function(duk_ctx, _js_updateAnimations, 0);
-    duk_put_global_string(duk_ctx, "updateAnimations");
+void JSEngine::_beginCall(duk_context* ctx) {
+    JSContextData* data = getContextData(ctx);
 
-    // Initialize display ID to 0 (can be overridden with setDisplayId)
-    duk_push_global_stash(duk_ctx);
-    duk_push_int(duk_ctx, 0);
-    duk_put_prop_string(duk_ctx, -2, "__displayId");
-    duk_pop(duk_ctx);
+    // Nested calls run under the outer call's deadline
+    if (data->callDepth++ > 0) return;
 
-    Serial.println("[JSEngine] ✓ Registered Doki OS APIs (Advanced Features Enabled + Animation)");
+#ifdef DOKI_JS_SHARED_HEAP
+    // The timeout hook only sees the heap userdata
+    JSContextData* heap = _getHeapData(ctx);
+    if (heap->shared) {
+        heap->shared->running = data;
+    }
 #endif
+
+    data->timedOut = false;
+    data->callStartUs = micros();
+    data->blockedUs = 0;
+    data->deadline = millis() + TIMEOUT_JS_EXECUTION_MS;
 }
 
-void JSEngine::setDisplayId(void* ctx, uint8_t displayId) {
-#ifdef ENABLE_JAVASCRIPT_SUPPORT
-    if (!ctx) return;
+void JSEngine::_endCall(duk_context* ctx) {
+    JSContextData* data = getContextData(ctx);
 
-    duk_context* duk_ctx = (duk_context*)ctx;
+    if (--data->callDepth > 0) return;
 
-    // Store display ID in the global stash (hidden from JS code)
-    duk_push_global_stash(duk_ctx);
-    duk_push_int(duk_ctx, displayId);
-    duk_put_prop_string(duk_ctx, -2, "__displayId");
-    duk_pop(duk_ctx);
+    // Waits in blocking bindings are not JS time
+    uint32_t elapsed = micros() - data->callStartUs - data->blockedUs;
+    JSExecStats& stats = data->exec;
 
-    Serial.printf("[JSEngine] Set display ID to %d for context\n", displayId);
-#endif
-}
+    stats.totalUs += elapsed;
+    stats.calls++;
+    stats.lastCallUs = elapsed;
+    if (elapsed > stats.maxCallUs) {
+        stats.maxCallUs = elapsed;
+    }
 
-void JSEngine::setDisplayScreen(void* ctx, void* screen) {
-#ifdef ENABLE_JAVASCRIPT_SUPPORT
-    if (!ctx) return;
+    // Roll the budget window
+    uint32_t now = millis();
+    if (now - stats.windowStart >= JS_BUDGET_WINDOW_MS) {
+        const uint32_t budgetUs = JS_BUDGET_WINDOW_MS * 10 * JS_BUDGET_PERCENT;  // ms * 1000 * % / 100
 
-    duk_context* duk_ctx = (duk_context*)ctx;
+        if (stats.windowUs > budgetUs) {
+            stats.overBudgetWindows++;
+        } else {
+            stats.overBudgetWindows = 0;
+        }
 
-    // Store display screen pointer in the global stash (hidden from JS code)
-    duk_push_global_stash(duk_ctx);
-    duk_push_pointer(duk_ctx, screen);
-    duk_put_prop_string(duk_ctx, -2, "__displayScreen");
-    duk_pop(duk_ctx);
+        stats.lastWindowUs = stats.windowUs;
+        stats.windowUs = 0;
+        stats.windowStart = now;
+        stats.windowSeq++;
+    }
+    stats.windowUs += elapsed;
 
-    Serial.printf("[JSEngine] Set display screen pointer %p for context\n", screen);
-#endif
+    if (data->timedOut) {
+        stats.timeouts++;
+        DOKI_LOGE(JS_ENGINE, "Execution timeout on display %d after %u ms",
+                  data->displayId, (unsigned)(elapsed / 1000));
+    }
 }
 
-const char* JSEngine::getLastError() {
-    return _lastError.c_str();
+uint32_t JSEngine::_pauseDeadline() {
+    return micros();
 }
 
+void JSEngine::_resumeDeadline(duk_context* ctx, uint32_t pausedAt) {
+    JSContextData* data = getContextData(ctx);
+    if (data->callDepth == 0) return;
+
+    // Give back the remaining budget the wait used up
+    uint32_t waitedUs = micros() - pausedAt;
+    data->blockedUs += waitedUs;
+    data->deadline += (waitedUs + 999) / 1000;
+}
+#endif
+
 bool JSEngine::isEnabled() {
 #ifdef ENABLE_JAVASCRIPT_SUPPORT
     return true;
@@ -442,6 +1364,35 @@ bool JSEngine::isEnabled() {
 #endif
 }
 
+// ========================================
+// Execution Timeout Hook
+// ========================================
+
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+/**
+ * Called by Duktape from its executor interrupt (DUK_USE_EXEC_TIMEOUT_CHECK
+ * in duk_config.h). Once it returns true it must keep doing so until the
+ * error has unwound out of the top-level call, so the flag is sticky.
+ */
+extern "C" duk_bool_t doki_js_exec_timeout_check(void* udata) {
+    JSContextData* data = (JSContextData*)udata;
+#ifdef DOKI_JS_SHARED_HEAP
+    if (data && data->shared) {
+        data = data->shared->running;
+    }
+#endif
+    if (!data || data->callDepth == 0) {
+        return 0;
+    }
+
+    if (!data->timedOut && (int32_t)(millis() - data->deadline) >= 0) {
+        data->timedOut = true;
+    }
+
+    return data->timedOut ? 1 : 0;
+}
+#endif
+
 // ========================================
 // Duktape API Binding Functions
 // ========================================
@@ -450,7 +1401,7 @@ bool JSEngine::isEnabled() {
 
 duk_ret_t JSEngine::_js_log(duk_context* ctx) {
     const char* message = duk_to_string(ctx, 0);
-    Serial.printf("[JS] %s\n", message);
+    DOKI_LOGI(JS, "%s", message);
     return 0;
 }
 
@@ -463,28 +1414,10 @@ duk_ret_t JSEngine::_js_createLabel(duk_context* ctx) {
     lv_label_set_text(label, text);
     lv_obj_set_pos(label, x, y);
 
-    // Store object pointer in global stash array
-    duk_push_global_stash(ctx);
-    duk_get_prop_string(ctx, -1, "__lvgl_objects");
-
-    // Create array if it doesn't exist
-    if (!duk_is_array(ctx, -1)) {
-        duk_pop(ctx);  // pop undefined
-        duk_push_array(ctx);
-        duk_dup(ctx, -1);  // duplicate array
-        duk_put_prop_string(ctx, -3, "__lvgl_objects");  // store in stash
-    }
+    // Register in the context's handle table
+    uint32_t objId = getContextData(ctx)->handles.add(label);
 
-    // Get next ID (array length)
-    duk_size_t objId = duk_get_length(ctx, -1);
-
-    // Store pointer at this ID
-    duk_push_pointer(ctx, (void*)label);
-    duk_put_prop_index(ctx, -2, objId);
-
-    duk_pop_2(ctx);  // pop array and stash
-
-    Serial.printf("[JS] Created label ID=%d: '%s' at (%d, %d)\n", (int)objId, text, x, y);
+    DOKI_LOGD(JS, "Created label ID=%u: '%s' at (%d, %d)", objId, text, x, y);
 
     // Return the ID
     duk_push_uint(ctx, objId);
@@ -503,7 +1436,7 @@ duk_ret_t JSEngine::_js_createButton(duk_context* ctx) {
     lv_label_set_text(label, text);
     lv_obj_center(label);
 
-    Serial.printf("[JS] Created button: '%s' at (%d, %d)\n", text, x, y);
+    DOKI_LOGD(JS, "Created button: '%s' at (%d, %d)", text, x, y);
     return 0;
 }
 
@@ -513,18 +1446,12 @@ duk_ret_t JSEngine::_js_setBackgroundColor(duk_context* ctx) {
     lv_obj_t* screen = lv_scr_act();
     lv_obj_set_style_bg_color(screen, lv_color_hex(color), 0);
 
-    Serial.printf("[JS] Set background color: 0x%06X\n", color);
+    DOKI_LOGD(JS, "Set background color: 0x%06X", color);
     return 0;
 }
 
 duk_ret_t JSEngine::_js_getDisplayId(duk_context* ctx) {
-    // Retrieve display ID from global stash
-    duk_push_global_stash(ctx);
-    duk_get_prop_string(ctx, -1, "__displayId");
-    int displayId = duk_to_int(ctx, -1);
-    duk_pop_2(ctx);  // Pop value and stash
-
-    duk_push_int(ctx, displayId);
+    duk_push_int(ctx, getContextData(ctx)->displayId);
     return 1;
 }
 
@@ -532,10 +1459,15 @@ duk_ret_t JSEngine::_js_saveState(duk_context* ctx) {
     const char* key = duk_to_string(ctx, 0);
     const char* value = duk_to_string(ctx, 1);
 
-    // Save to NVS
-    JsonDocument state;
-    state[key] = value;
-    bool success = StatePersistence::saveState("jsapp", state);
+    JSContextData* data = getContextData(ctx);
+    if (!_loadKeyValueState(data)) {
+        duk_push_boolean(ctx, false);
+        return 1;
+    }
+
+    // The app's keys stay in the context; only the store is written
+    data->kvState[key] = value;
+    bool success = StatePersistence::saveState(data->stateRecord.c_str(), data->kvState);
 
     duk_push_boolean(ctx, success);
     return 1;
@@ -544,18 +1476,30 @@ duk_ret_t JSEngine::_js_saveState(duk_context* ctx) {
 duk_ret_t JSEngine::_js_loadState(duk_context* ctx) {
     const char* key = duk_to_string(ctx, 0);
 
-    // Load from NVS
-    JsonDocument state;
-    if (StatePersistence::loadState("jsapp", state)) {
-        const char* value = state[key];
-        duk_push_string(ctx, value);
+    JSContextData* data = getContextData(ctx);
+    if (!_loadKeyValueState(data)) {
+        duk_push_null(ctx);
         return 1;
     }
 
-    duk_push_null(ctx);
+    const char* value = data->kvState[key];
+    duk_push_string(ctx, value);  // nullptr pushes null
     return 1;
 }
 
+bool JSEngine::_loadKeyValueState(JSContextData* data) {
+    if (data->stateRecord.isEmpty()) {
+        DOKI_LOGE(JS, "saveState/loadState: context has no app ID");
+        return false;
+    }
+
+    if (!data->kvLoaded) {
+        StatePersistence::loadState(data->stateRecord.c_str(), data->kvState);
+        data->kvLoaded = true;
+    }
+    return true;
+}
+
 // Screen Info Functions
 duk_ret_t JSEngine::_js_getWidth(duk_context* ctx) {
     // Get screen width (240 pixels for ST7789)
@@ -579,7 +1523,7 @@ duk_ret_t JSEngine::_js_setTextColor(duk_context* ctx) {
     // In a more advanced version, we'd return object IDs from createLabel()
     uint32_t color = duk_to_uint32(ctx, 0);
 
-    Serial.printf("[JS] setTextColor: 0x%06X (Note: applies to next created label)\n", color);
+    DOKI_LOGD(JS, "setTextColor: 0x%06X (Note: applies to next created label)", color);
 
     // Store color in stash for next label creation
     duk_push_global_stash(ctx);
@@ -593,7 +1537,7 @@ duk_ret_t JSEngine::_js_setTextColor(duk_context* ctx) {
 duk_ret_t JSEngine::_js_setTextSize(duk_context* ctx) {
     int size = duk_to_int(ctx, 0);
 
-    Serial.printf("[JS] setTextSize: %d (Note: applies to next created label)\n", size);
+    DOKI_LOGD(JS, "setTextSize: %d (Note: applies to next created label)", size);
 
     // Store size in stash for next label creation
     duk_push_global_stash(ctx);
@@ -611,6 +1555,107 @@ duk_ret_t JSEngine::_js_millis(duk_context* ctx) {
     return 1;
 }
 
+// ========================================
+// Timers
+// ========================================
+
+// Store fn (at index 0) in stash[table][id]
+static void _stashCallback(duk_context* ctx, const char* table, uint32_t id) {
+    duk_push_global_stash(ctx);
+    if (!duk_get_prop_string(ctx, -1, table)) {
+        duk_pop(ctx);
+        duk_push_object(ctx);
+        duk_dup(ctx, -1);
+        duk_put_prop_string(ctx, -3, table);
+    }
+
+    duk_dup(ctx, 0);
+    duk_put_prop_index(ctx, -2, id);
+    duk_pop_2(ctx);
+}
+
+static void _unstashCallback(duk_context* ctx, const char* table, uint32_t id) {
+    duk_push_global_stash(ctx);
+    if (duk_get_prop_string(ctx, -1, table)) {
+        duk_del_prop_index(ctx, -1, id);
+    }
+    duk_pop_2(ctx);
+}
+
+static duk_ret_t _addTimer(duk_context* ctx, bool periodic) {
+    duk_require_function(ctx, 0);
+    int32_t delay = duk_get_int_default(ctx, 1, 0);
+    if (delay < 0) delay = 0;
+
+    JSContextData* data = JSEngine::getContextData(ctx);
+    if (data->timers.size() >= JS_MAX_TIMERS) {
+        return duk_error(ctx, DUK_ERR_RANGE_ERROR, "too many timers (max %d)", JS_MAX_TIMERS);
+    }
+
+    // A zero interval would fire on every frame
+    uint32_t interval = 0;
+    if (periodic) {
+        interval = delay < (int32_t)JSTimerWheel::TICK_MS ? JSTimerWheel::TICK_MS : delay;
+        delay = interval;
+    }
+
+    uint32_t id = data->timers.add(delay, interval, millis());
+    _stashCallback(ctx, "__timers", id);
+
+    duk_push_uint(ctx, id);
+    return 1;
+}
+
+duk_ret_t JSEngine::_js_setTimeout(duk_context* ctx) {
+    return _addTimer(ctx, false);
+}
+
+duk_ret_t JSEngine::_js_setInterval(duk_context* ctx) {
+    return _addTimer(ctx, true);
+}
+
+duk_ret_t JSEngine::_js_clearTimer(duk_context* ctx) {
+    uint32_t id = duk_get_uint_default(ctx, 0, 0);
+    if (id == 0) return 0;
+
+    getContextData(ctx)->timers.cancel(id);
+    _unstashCallback(ctx, "__timers", id);
+    return 0;
+}
+
+duk_ret_t JSEngine::_js_requestAnimationFrame(duk_context* ctx) {
+    duk_require_function(ctx, 0);
+
+    JSContextData* data = getContextData(ctx);
+    if (data->frameRequests.size() >= JS_MAX_FRAME_REQUESTS) {
+        return duk_error(ctx, DUK_ERR_RANGE_ERROR, "too many frame requests (max %d)", JS_MAX_FRAME_REQUESTS);
+    }
+
+    uint32_t id = data->nextFrameId++;
+    if (data->nextFrameId == 0) data->nextFrameId = 1;
+
+    data->frameRequests.push_back(id);
+    _stashCallback(ctx, "__raf", id);
+
+    duk_push_uint(ctx, id);
+    return 1;
+}
+
+duk_ret_t JSEngine::_js_cancelAnimationFrame(duk_context* ctx) {
+    uint32_t id = duk_get_uint_default(ctx, 0, 0);
+    if (id == 0) return 0;
+
+    std::vector<uint32_t>& requests = getContextData(ctx)->frameRequests;
+    for (size_t i = 0; i < requests.size(); i++) {
+        if (requests[i] == id) {
+            requests.erase(requests.begin() + i);
+            break;
+        }
+    }
+    _unstashCallback(ctx, "__raf", id);
+    return 0;
+}
+
 duk_ret_t JSEngine::_js_getTime(duk_context* ctx) {
     // Use centralized TimeService singleton
     TimeService& timeService = TimeService::getInstance();
@@ -669,60 +1714,135 @@ duk_ret_t JSEngine::_js_getTime(duk_context* ctx) {
 duk_ret_t JSEngine::_js_httpGet(duk_context* ctx) {
     const char* url = duk_to_string(ctx, 0);
 
-    Serial.printf("[JS] HTTP GET: %s\n", url);
+    // httpGet(url, callback): runs on a worker task, returns a request ID
+    if (duk_is_function(ctx, 1) || duk_is_string(ctx, 1)) {
+        JSContextData* data = getContextData(ctx);
+
+        uint32_t id = JSHttpWorker::submit(ctx, url);
+        if (id == 0) {
+            duk_push_uint(ctx, 0);
+            return 1;
+        }
+        data->httpPending++;
+
+        duk_push_global_stash(ctx);
+        if (!duk_get_prop_string(ctx, -1, "__http")) {
+            duk_pop(ctx);
+            duk_push_object(ctx);
+            duk_dup(ctx, -1);
+            duk_put_prop_string(ctx, -3, "__http");
+        }
+        duk_dup(ctx, 1);
+        duk_put_prop_index(ctx, -2, id);
+        duk_pop_2(ctx);
+
+        duk_push_uint(ctx, id);
+        return 1;
+    }
+
+    // Legacy httpGet(url): blocks every display until the server answers
+    DOKI_LOGW(JS, "Blocking httpGet() - pass a callback to run it in the background");
+    DOKI_LOGD(JS, "HTTP GET: %s", url);
 
     // Use HTTPClient to fetch data
     HTTPClient http;
+    String payload;
+    uint32_t pausedAt = _pauseDeadline();
+
     http.begin(url);
     http.setTimeout(TIMEOUT_HTTP_REQUEST_MS);
 
     int httpCode = http.GET();
-
     if (httpCode == HTTP_CODE_OK) {
-        String payload = http.getString();
-        Serial.printf("[JS] HTTP Response: %d bytes\n", payload.length());
+        payload = http.getString();
+    }
+    http.end();
+
+    _resumeDeadline(ctx, pausedAt);
 
+    if (httpCode == HTTP_CODE_OK) {
+        DOKI_LOGD(JS, "HTTP Response: %u bytes", (unsigned)payload.length());
         duk_push_string(ctx, payload.c_str());
-        http.end();
         return 1;
     } else {
-        Serial.printf("[JS] HTTP Error: %d\n", httpCode);
-        http.end();
+        DOKI_LOGE(JS, "HTTP Error: %d", httpCode);
         duk_push_null(ctx);
         return 1;
     }
 }
 
+// Module Loader
+duk_ret_t JSEngine::_js_require(duk_context* ctx) {
+    const char* id = duk_require_string(ctx, 0);
+
+    String path;
+    if (!JSModuleCache::resolve(id, path)) {
+        return duk_error(ctx, DUK_ERR_ERROR, "Cannot find module '%s'", id);
+    }
+
+    // One instance per context: later require() calls share module.exports
+    duk_push_global_stash(ctx);                         // [id stash]
+    if (!duk_get_prop_string(ctx, -1, "__modules")) {
+        duk_pop(ctx);
+        duk_push_object(ctx);
+        duk_dup(ctx, -1);
+        duk_put_prop_string(ctx, -3, "__modules");
+    }                                                   // [id stash modules]
+
+    if (duk_get_prop_string(ctx, 2, path.c_str())) {
+        duk_get_prop_string(ctx, -1, "exports");
+        return 1;
+    }
+    duk_pop(ctx);
+
+    if (!JSModuleCache::pushFunction(ctx, path)) {
+        return duk_throw(ctx);
+    }                                                   // [id stash modules fn]
+
+    duk_push_object(ctx);                               // [... fn module]
+    duk_push_object(ctx);
+    duk_put_prop_string(ctx, 4, "exports");
+    duk_push_string(ctx, path.c_str());
+    duk_put_prop_string(ctx, 4, "id");
+
+    // Registered before running, so circular requires see partial exports
+    duk_dup(ctx, 4);
+    duk_put_prop_string(ctx, 2, path.c_str());
+
+    // fn.call(exports, exports, require, module)
+    duk_dup(ctx, 3);
+    duk_get_prop_string(ctx, 4, "exports");
+    duk_dup_top(ctx);
+    duk_push_current_function(ctx);
+    duk_dup(ctx, 4);
+
+    if (duk_pcall_method(ctx, 3) != 0) {
+        // Let a later require() retry instead of returning half-built exports
+        duk_del_prop_string(ctx, 2, path.c_str());
+        return duk_throw(ctx);
+    }
+    duk_pop(ctx);
+
+    duk_get_prop_string(ctx, 4, "exports");
+    return 1;
+}
+
 // Label Update Functions
 duk_ret_t JSEngine::_js_updateLabel(duk_context* ctx) {
     duk_uint_t objId = duk_to_uint(ctx, 0);
     const char* newText = duk_to_string(ctx, 1);
 
-    // Get object from stash
-    duk_push_global_stash(ctx);
-    duk_get_prop_string(ctx, -1, "__lvgl_objects");
-
-    if (!duk_is_array(ctx, -1)) {
-        Serial.println("[JS] ERROR: No objects array in stash");
-        duk_pop_2(ctx);
-        return 0;
-    }
-
-    duk_get_prop_index(ctx, -1, objId);
-    lv_obj_t* obj = (lv_obj_t*)duk_to_pointer(ctx, -1);
-    duk_pop_3(ctx);  // pop pointer, array, stash
+    JSContextData* data = getContextData(ctx);
+    lv_obj_t* obj = data->handles.resolve(objId);
 
     if (obj) {
-        // Get display ID from stash for logging
-        duk_push_global_stash(ctx);
-        duk_get_prop_string(ctx, -1, "__displayId");
-        int displayId = duk_to_int(ctx, -1);
-        duk_pop_2(ctx);  // Pop value and stash
-
-        lv_label_set_text(obj, newText);
-        Serial.printf("[JS Display %d] Updated label ID=%d: '%s'\n", displayId, objId, newText);
+        // lv_label_set_text() always reallocates and invalidates - skip no-op updates
+        if (strcmp(lv_label_get_text(obj), newText) != 0) {
+            lv_label_set_text(obj, newText);
+        }
+        DOKI_LOGD(JS, "Display %d: Updated label ID=%u: '%s'", data->displayId, objId, newText);
     } else {
-        Serial.printf("[JS] ERROR: Invalid object ID=%d\n", objId);
+        DOKI_LOGE(JS, "ERROR: Invalid or stale object ID=%u", objId);
     }
 
     return 0;
@@ -732,22 +1852,11 @@ duk_ret_t JSEngine::_js_setLabelColor(duk_context* ctx) {
     duk_uint_t objId = duk_to_uint(ctx, 0);
     uint32_t color = duk_to_uint32(ctx, 1);
 
-    // Get object from stash
-    duk_push_global_stash(ctx);
-    duk_get_prop_string(ctx, -1, "__lvgl_objects");
-
-    if (!duk_is_array(ctx, -1)) {
-        duk_pop_2(ctx);
-        return 0;
-    }
-
-    duk_get_prop_index(ctx, -1, objId);
-    lv_obj_t* obj = (lv_obj_t*)duk_to_pointer(ctx, -1);
-    duk_pop_3(ctx);
+    lv_obj_t* obj = getContextData(ctx)->handles.resolve(objId);
 
     if (obj) {
         lv_obj_set_style_text_color(obj, lv_color_hex(color), 0);
-        Serial.printf("[JS] Set label ID=%d color: 0x%06X\n", objId, color);
+        DOKI_LOGD(JS, "Set label ID=%d color: 0x%06X", objId, color);
     }
 
     return 0;
@@ -757,49 +1866,45 @@ duk_ret_t JSEngine::_js_setLabelSize(duk_context* ctx) {
     duk_uint_t objId = duk_to_uint(ctx, 0);
     int size = duk_to_int(ctx, 1);
 
-    // Get object from stash
-    duk_push_global_stash(ctx);
-    duk_get_prop_string(ctx, -1, "__lvgl_objects");
-
-    if (!duk_is_array(ctx, -1)) {
-        duk_pop_2(ctx);
-        return 0;
-    }
-
-    duk_get_prop_index(ctx, -1, objId);
-    lv_obj_t* obj = (lv_obj_t*)duk_to_pointer(ctx, -1);
-    duk_pop_3(ctx);
+    lv_obj_t* obj = getContextData(ctx)->handles.resolve(objId);
 
     if (obj) {
-        const lv_font_t* font = &lv_font_montserrat_14;  // default
-
-        if (size == 12) font = &lv_font_montserrat_12;
-        else if (size == 14) font = &lv_font_montserrat_14;
-        else if (size == 16) font = &lv_font_montserrat_16;
-        else if (size == 20) font = &lv_font_montserrat_20;
-        else if (size == 24) font = &lv_font_montserrat_24;
-
-        lv_obj_set_style_text_font(obj, font, 0);
-        Serial.printf("[JS] Set label ID=%d font size: %d\n", objId, size);
+        lv_obj_set_style_text_font(obj, JSUITemplate::fontForSize(size), 0);
+        DOKI_LOGD(JS, "Set label ID=%d font size: %d", objId, size);
     }
 
     return 0;
 }
 
 // Screen Management
+
+// Free buffers whose lv_canvas is deleted and whose arrays are finalized
+static void _releaseDeadCanvases(JSContextData* data) {
+    std::vector<JSCanvas>& canvases = data->canvases;
+    for (size_t i = 0; i < canvases.size();) {
+        if (canvases[i].jsRefs == 0 && !data->handles.resolve(canvases[i].handle)) {
+            free(canvases[i].pixels);
+            canvases.erase(canvases.begin() + i);
+        } else {
+            i++;
+        }
+    }
+}
+
 duk_ret_t JSEngine::_js_clearScreen(duk_context* ctx) {
     lv_obj_t* screen = lv_scr_act();
 
-    // Delete all children
+    // Delete all children (their delete hooks release the handles)
     lv_obj_clean(screen);
 
-    // Clear object array in stash
-    duk_push_global_stash(ctx);
-    duk_push_array(ctx);
-    duk_put_prop_string(ctx, -2, "__lvgl_objects");
-    duk_pop(ctx);
+    // Invalidate anything that was not a child of the active screen
+    JSContextData* data = getContextData(ctx);
+    data->handles.clear();
 
-    Serial.println("[JS] Cleared screen");
+    // Canvas buffers no array refers to any more can go now
+    _releaseDeadCanvases(data);
+
+    DOKI_LOGD(JS, "Cleared screen");
     return 0;
 }
 
@@ -818,7 +1923,7 @@ duk_ret_t JSEngine::_js_drawRectangle(duk_context* ctx) {
     lv_obj_set_style_border_width(rect, 0, 0);
     lv_obj_set_style_radius(rect, 0, 0);
 
-    Serial.printf("[JS] Drew rectangle: (%d,%d) %dx%d color=0x%06X\n", x, y, w, h, color);
+    DOKI_LOGD(JS, "Drew rectangle: (%d,%d) %dx%d color=0x%06X", x, y, w, h, color);
     return 0;
 }
 
@@ -836,7 +1941,233 @@ duk_ret_t JSEngine::_js_drawCircle(duk_context* ctx) {
     lv_obj_set_style_border_width(circle, 0, 0);
     lv_obj_set_style_radius(circle, LV_RADIUS_CIRCLE, 0);
 
-    Serial.printf("[JS] Drew circle: (%d,%d) radius=%d color=0x%06X\n", x, y, radius, color);
+    DOKI_LOGD(JS, "Drew circle: (%d,%d) radius=%d color=0x%06X", x, y, radius, color);
+    return 0;
+}
+
+// Canvas Functions
+
+// Resolve a canvas argument (the array returned by createCanvas, or its id)
+static JSCanvas* _getCanvas(duk_context* ctx, duk_idx_t index) {
+    uint32_t handle;
+    if (duk_is_object(ctx, index)) {
+        duk_get_prop_string(ctx, index, "id");
+        handle = duk_to_uint32(ctx, -1);
+        duk_pop(ctx);
+    } else {
+        handle = duk_to_uint32(ctx, index);
+    }
+
+    for (JSCanvas& canvas : JSEngine::getContextData(ctx)->canvases) {
+        if (canvas.handle == handle) return &canvas;
+    }
+    return nullptr;
+}
+
+// Finalizer of the Uint16Array returned by createCanvas
+static duk_ret_t _finalizeCanvasArray(duk_context* ctx) {
+    duk_get_prop_string(ctx, 0, DUK_HIDDEN_SYMBOL("pixels"));
+    void* pixels = duk_get_pointer(ctx, -1);
+    duk_pop(ctx);
+
+    // Finalizers of a shared heap may run outside the owning app: its
+    // buffers then stay until the app's context data is deleted
+    JSContextData* data = JSEngine::getContextData(ctx);
+    if (!data || !pixels) return 0;
+
+    for (JSCanvas& canvas : data->canvases) {
+        if (canvas.pixels == pixels) {
+            if (canvas.jsRefs > 0) canvas.jsRefs--;
+            _releaseDeadCanvases(data);
+            break;
+        }
+    }
+    return 0;
+}
+
+// Clip a rectangle to the canvas; false if nothing is left
+static bool _clipToCanvas(const JSCanvas& canvas, int& x, int& y, int& w, int& h) {
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > canvas.width) w = canvas.width - x;
+    if (y + h > canvas.height) h = canvas.height - y;
+    return w > 0 && h > 0;
+}
+
+// Mark part of a canvas for redraw (canvas coordinates)
+static void _invalidateCanvas(duk_context* ctx, const JSCanvas& canvas, int x, int y, int w, int h) {
+    lv_obj_t* obj = JSEngine::getContextData(ctx)->handles.resolve(canvas.handle);
+    if (!obj) return;  // Deleted (clearScreen) - drawing still lands in the buffer
+
+    lv_area_t coords;
+    lv_obj_get_coords(obj, &coords);
+
+    lv_area_t area;
+    area.x1 = coords.x1 + x;
+    area.y1 = coords.y1 + y;
+    area.x2 = area.x1 + w - 1;
+    area.y2 = area.y1 + h - 1;
+    lv_obj_invalidate_area(obj, &area);
+}
+
+duk_ret_t JSEngine::_js_createCanvas(duk_context* ctx) {
+    int w = duk_to_int(ctx, 0);
+    int h = duk_to_int(ctx, 1);
+    int x = duk_get_int_default(ctx, 2, 0);
+    int y = duk_get_int_default(ctx, 3, 0);
+
+    JSContextData* data = getContextData(ctx);
+
+    // Any shape up to one full screen of pixels (e.g. a wide sprite strip)
+    if (w <= 0 || h <= 0 || w > 0x7FFF || h > 0x7FFF || w * h > DISPLAY_WIDTH * DISPLAY_HEIGHT) {
+        DOKI_LOGE(JS, "createCanvas: invalid size %dx%d", w, h);
+        duk_push_null(ctx);
+        return 1;
+    }
+
+    // Only canvases still on screen count; clearScreen() leaves the others
+    _releaseDeadCanvases(data);
+    int live = 0;
+    for (const JSCanvas& entry : data->canvases) {
+        if (data->handles.resolve(entry.handle)) live++;
+    }
+    if (live >= JS_MAX_CANVASES) {
+        DOKI_LOGE(JS, "createCanvas: limit of %d canvases reached", JS_MAX_CANVASES);
+        duk_push_null(ctx);
+        return 1;
+    }
+
+    // The app's own screen: lv_scr_act() is whichever display is the LVGL default
+    lv_obj_t* screen = data->screen;
+    if (!screen) {
+        DOKI_LOGE(JS, "createCanvas: no display screen set in context");
+        duk_push_null(ctx);
+        return 1;
+    }
+
+    size_t bytes = (size_t)w * h * sizeof(uint16_t);
+    uint16_t* pixels = (uint16_t*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+    if (!pixels) {
+        pixels = (uint16_t*)malloc(bytes);
+    }
+    if (!pixels) {
+        DOKI_LOGE(JS, "createCanvas: out of memory for %dx%d", w, h);
+        duk_push_null(ctx);
+        return 1;
+    }
+    memset(pixels, 0, bytes);
+
+    lv_obj_t* canvas = lv_canvas_create(screen);
+    lv_canvas_set_buffer(canvas, pixels, w, h, LV_IMG_CF_TRUE_COLOR);
+    lv_obj_set_pos(canvas, x, y);
+
+    uint32_t handle = data->handles.add(canvas);
+    data->canvases.push_back({ handle, pixels, (uint16_t)w, (uint16_t)h, 1 });
+
+    // Uint16Array aliasing the pixel buffer - writes go straight to the canvas memory
+    duk_push_external_buffer(ctx);
+    duk_config_buffer(ctx, -1, pixels, bytes);
+    duk_push_buffer_object(ctx, -1, 0, bytes, DUK_BUFOBJ_UINT16ARRAY);
+    duk_remove(ctx, -2);
+
+    // The finalizer frees the buffer once the lv_canvas is gone as well
+    duk_push_pointer(ctx, pixels);
+    duk_put_prop_string(ctx, -2, DUK_HIDDEN_SYMBOL("pixels"));
+    duk_push_c_function(ctx, _finalizeCanvasArray, 1);
+    duk_set_finalizer(ctx, -2);
+
+    duk_push_uint(ctx, handle);
+    duk_put_prop_string(ctx, -2, "id");
+    duk_push_int(ctx, w);
+    duk_put_prop_string(ctx, -2, "width");
+    duk_push_int(ctx, h);
+    duk_put_prop_string(ctx, -2, "height");
+
+    DOKI_LOGD(JS, "Created canvas ID=%u: %dx%d at (%d, %d)", (unsigned)handle, w, h, x, y);
+    return 1;
+}
+
+duk_ret_t JSEngine::_js_canvasFill(duk_context* ctx) {
+    JSCanvas* canvas = _getCanvas(ctx, 0);
+    if (!canvas) return 0;
+
+    uint16_t color = lv_color_hex(duk_to_uint32(ctx, 1)).full;
+    int x = duk_get_int_default(ctx, 2, 0);
+    int y = duk_get_int_default(ctx, 3, 0);
+    int w = duk_get_int_default(ctx, 4, canvas->width);
+    int h = duk_get_int_default(ctx, 5, canvas->height);
+
+    if (!_clipToCanvas(*canvas, x, y, w, h)) return 0;
+
+    for (int row = y; row < y + h; row++) {
+        uint16_t* p = canvas->pixels + row * canvas->width + x;
+        for (int i = 0; i < w; i++) {
+            p[i] = color;
+        }
+    }
+
+    _invalidateCanvas(ctx, *canvas, x, y, w, h);
+    return 0;
+}
+
+duk_ret_t JSEngine::_js_canvasBlit(duk_context* ctx) {
+    JSCanvas* dst = _getCanvas(ctx, 0);
+    JSCanvas* src = _getCanvas(ctx, 1);
+    if (!dst || !src) return 0;
+
+    int dx = duk_to_int(ctx, 2);
+    int dy = duk_to_int(ctx, 3);
+    int sx = duk_get_int_default(ctx, 4, 0);
+    int sy = duk_get_int_default(ctx, 5, 0);
+    int w = duk_get_int_default(ctx, 6, src->width);
+    int h = duk_get_int_default(ctx, 7, src->height);
+    bool keyed = duk_is_number(ctx, 8);
+    uint16_t key = keyed ? lv_color_hex(duk_to_uint32(ctx, 8)).full : 0;
+
+    // Clip against the source, then carry the offset over to the destination
+    int ox = sx, oy = sy;
+    if (!_clipToCanvas(*src, sx, sy, w, h)) return 0;
+    dx += sx - ox;
+    dy += sy - oy;
+
+    ox = dx; oy = dy;
+    if (!_clipToCanvas(*dst, dx, dy, w, h)) return 0;
+    sx += dx - ox;
+    sy += dy - oy;
+
+    // Blitting a canvas onto itself downwards must copy bottom-up
+    bool reverse = (src == dst && dy > sy);
+
+    for (int i = 0; i < h; i++) {
+        int row = reverse ? h - 1 - i : i;
+        const uint16_t* s = src->pixels + (sy + row) * src->width + sx;
+        uint16_t* d = dst->pixels + (dy + row) * dst->width + dx;
+
+        if (!keyed) {
+            memmove(d, s, w * sizeof(uint16_t));
+        } else {
+            for (int col = 0; col < w; col++) {
+                if (s[col] != key) d[col] = s[col];
+            }
+        }
+    }
+
+    _invalidateCanvas(ctx, *dst, dx, dy, w, h);
+    return 0;
+}
+
+duk_ret_t JSEngine::_js_invalidate(duk_context* ctx) {
+    JSCanvas* canvas = _getCanvas(ctx, 0);
+    if (!canvas) return 0;
+
+    int x = duk_get_int_default(ctx, 1, 0);
+    int y = duk_get_int_default(ctx, 2, 0);
+    int w = duk_get_int_default(ctx, 3, canvas->width);
+    int h = duk_get_int_default(ctx, 4, canvas->height);
+
+    if (_clipToCanvas(*canvas, x, y, w, h)) {
+        _invalidateCanvas(ctx, *canvas, x, y, w, h);
+    }
     return 0;
 }
 
@@ -853,23 +2184,9 @@ duk_ret_t JSEngine::_js_createScrollingLabel(duk_context* ctx) {
     lv_obj_set_width(label, width);
     lv_label_set_long_mode(label, LV_LABEL_LONG_SCROLL_CIRCULAR);
 
-    // Store in stash and return ID
-    duk_push_global_stash(ctx);
-    duk_get_prop_string(ctx, -1, "__lvgl_objects");
-
-    if (!duk_is_array(ctx, -1)) {
-        duk_pop(ctx);
-        duk_push_array(ctx);
-        duk_dup(ctx, -1);
-        duk_put_prop_string(ctx, -3, "__lvgl_objects");
-    }
-
-    duk_size_t objId = duk_get_length(ctx, -1);
-    duk_push_pointer(ctx, (void*)label);
-    duk_put_prop_index(ctx, -2, objId);
-    duk_pop_2(ctx);
+    uint32_t objId = getContextData(ctx)->handles.add(label);
 
-    Serial.printf("[JS] Created scrolling label ID=%d: '%s' width=%d\n", (int)objId, text, width);
+    DOKI_LOGD(JS, "Created scrolling label ID=%u: '%s' width=%d", objId, text, width);
 
     duk_push_uint(ctx, objId);
     return 1;
@@ -879,18 +2196,7 @@ duk_ret_t JSEngine::_js_setTextAlign(duk_context* ctx) {
     duk_uint_t objId = duk_to_uint(ctx, 0);
     int align = duk_to_int(ctx, 1);  // 0=left, 1=center, 2=right
 
-    // Get object from stash
-    duk_push_global_stash(ctx);
-    duk_get_prop_string(ctx, -1, "__lvgl_objects");
-
-    if (!duk_is_array(ctx, -1)) {
-        duk_pop_2(ctx);
-        return 0;
-    }
-
-    duk_get_prop_index(ctx, -1, objId);
-    lv_obj_t* obj = (lv_obj_t*)duk_to_pointer(ctx, -1);
-    duk_pop_3(ctx);
+    lv_obj_t* obj = getContextData(ctx)->handles.resolve(objId);
 
     if (obj) {
         lv_text_align_t lv_align = LV_TEXT_ALIGN_LEFT;
@@ -898,7 +2204,7 @@ duk_ret_t JSEngine::_js_setTextAlign(duk_context* ctx) {
         else if (align == 2) lv_align = LV_TEXT_ALIGN_RIGHT;
 
         lv_obj_set_style_text_align(obj, lv_align, 0);
-        Serial.printf("[JS] Set label ID=%d text align: %d\n", objId, align);
+        DOKI_LOGD(JS, "Set label ID=%d text align: %d", objId, align);
     }
 
     return 0;
@@ -912,18 +2218,7 @@ duk_ret_t JSEngine::_js_fadeIn(duk_context* ctx) {
     duk_uint_t objId = duk_to_uint(ctx, 0);
     int duration = duk_to_int(ctx, 1);
 
-    // Get object from stash
-    duk_push_global_stash(ctx);
-    duk_get_prop_string(ctx, -1, "__lvgl_objects");
-
-    if (!duk_is_array(ctx, -1)) {
-        duk_pop_2(ctx);
-        return 0;
-    }
-
-    duk_get_prop_index(ctx, -1, objId);
-    lv_obj_t* obj = (lv_obj_t*)duk_to_pointer(ctx, -1);
-    duk_pop_3(ctx);
+    lv_obj_t* obj = getContextData(ctx)->handles.resolve(objId);
 
     if (obj) {
         lv_anim_t anim;
@@ -934,7 +2229,7 @@ duk_ret_t JSEngine::_js_fadeIn(duk_context* ctx) {
         lv_anim_set_exec_cb(&anim, (lv_anim_exec_xcb_t)lv_obj_set_style_opa);
         lv_anim_start(&anim);
 
-        Serial.printf("[JS] Fade in ID=%d duration=%dms\n", objId, duration);
+        DOKI_LOGD(JS, "Fade in ID=%d duration=%dms", objId, duration);
     }
 
     return 0;
@@ -944,18 +2239,7 @@ duk_ret_t JSEngine::_js_fadeOut(duk_context* ctx) {
     duk_uint_t objId = duk_to_uint(ctx, 0);
     int duration = duk_to_int(ctx, 1);
 
-    // Get object from stash
-    duk_push_global_stash(ctx);
-    duk_get_prop_string(ctx, -1, "__lvgl_objects");
-
-    if (!duk_is_array(ctx, -1)) {
-        duk_pop_2(ctx);
-        return 0;
-    }
-
-    duk_get_prop_index(ctx, -1, objId);
-    lv_obj_t* obj = (lv_obj_t*)duk_to_pointer(ctx, -1);
-    duk_pop_3(ctx);
+    lv_obj_t* obj = getContextData(ctx)->handles.resolve(objId);
 
     if (obj) {
         lv_anim_t anim;
@@ -966,7 +2250,7 @@ duk_ret_t JSEngine::_js_fadeOut(duk_context* ctx) {
         lv_anim_set_exec_cb(&anim, (lv_anim_exec_xcb_t)lv_obj_set_style_opa);
         lv_anim_start(&anim);
 
-        Serial.printf("[JS] Fade out ID=%d duration=%dms\n", objId, duration);
+        DOKI_LOGD(JS, "Fade out ID=%d duration=%dms", objId, duration);
     }
 
     return 0;
@@ -986,18 +2270,7 @@ duk_ret_t JSEngine::_js_moveLabel(duk_context* ctx) {
     int targetY = duk_to_int(ctx, 2);
     int duration = duk_to_int(ctx, 3);
 
-    // Get object from stash
-    duk_push_global_stash(ctx);
-    duk_get_prop_string(ctx, -1, "__lvgl_objects");
-
-    if (!duk_is_array(ctx, -1)) {
-        duk_pop_2(ctx);
-        return 0;
-    }
-
-    duk_get_prop_index(ctx, -1, objId);
-    lv_obj_t* obj = (lv_obj_t*)duk_to_pointer(ctx, -1);
-    duk_pop_3(ctx);
+    lv_obj_t* obj = getContextData(ctx)->handles.resolve(objId);
 
     if (obj) {
         int currentX = lv_obj_get_x(obj);
@@ -1021,7 +2294,7 @@ duk_ret_t JSEngine::_js_moveLabel(duk_context* ctx) {
         lv_anim_set_exec_cb(&anim_y, (lv_anim_exec_xcb_t)_anim_y_cb);
         lv_anim_start(&anim_y);
 
-        Serial.printf("[JS] Move ID=%d to (%d,%d) duration=%dms\n", objId, targetX, targetY, duration);
+        DOKI_LOGD(JS, "Move ID=%d to (%d,%d) duration=%dms", objId, targetX, targetY, duration);
     }
 
     return 0;
@@ -1031,27 +2304,214 @@ duk_ret_t JSEngine::_js_setOpacity(duk_context* ctx) {
     duk_uint_t objId = duk_to_uint(ctx, 0);
     int opacity = duk_to_int(ctx, 1);  // 0-255
 
-    // Get object from stash
-    duk_push_global_stash(ctx);
-    duk_get_prop_string(ctx, -1, "__lvgl_objects");
-
-    if (!duk_is_array(ctx, -1)) {
-        duk_pop_2(ctx);
-        return 0;
-    }
-
-    duk_get_prop_index(ctx, -1, objId);
-    lv_obj_t* obj = (lv_obj_t*)duk_to_pointer(ctx, -1);
-    duk_pop_3(ctx);
+    lv_obj_t* obj = getContextData(ctx)->handles.resolve(objId);
 
     if (obj) {
         lv_obj_set_style_opa(obj, opacity, 0);
-        Serial.printf("[JS] Set opacity ID=%d: %d\n", objId, opacity);
+        DOKI_LOGD(JS, "Set opacity ID=%d: %d", objId, opacity);
     }
 
     return 0;
 }
 
+// ========================================
+// Batched UI Updates
+// ========================================
+
+duk_ret_t JSEngine::_js_applyUpdates(duk_context* ctx) {
+    if (!duk_is_array(ctx, 0)) {
+        return DUK_RET_TYPE_ERROR;
+    }
+
+    // Native copy of one entry, filled before the lock is taken
+    struct Update {
+        duk_uint_t id;
+        const char* text;        // Kept alive by the texts array below
+        uint32_t color;
+        int32_t opacity;
+        int32_t x;
+        int32_t y;
+        uint8_t has;             // HAS_* bits
+    };
+    enum : uint8_t { HAS_TEXT = 1, HAS_COLOR = 2, HAS_OPACITY = 4, HAS_X = 8, HAS_Y = 16 };
+
+    JSContextData* data = getContextData(ctx);
+    duk_size_t count = duk_get_length(ctx, 0);
+    uint32_t changed = 0;
+    uint32_t invalid = 0;
+
+    // Property reads run getters and Proxy traps (and the timeout
+    // interrupt), any of which can throw. Read everything first: a throw
+    // here unwinds with nothing held, and both buffers belong to the heap
+    Update* updates = (Update*)duk_push_fixed_buffer(ctx, count * sizeof(Update));
+    duk_idx_t textsIdx = duk_push_array(ctx);
+
+    for (duk_size_t i = 0; i < count; i++) {
+        Update& u = updates[i];
+        u.has = 0;
+        u.id = 0;
+
+        duk_get_prop_index(ctx, 0, (duk_uarridx_t)i);
+        if (!duk_is_object(ctx, -1)) {
+            duk_pop(ctx);
+            continue;
+        }
+
+        duk_get_prop_string(ctx, -1, "id");
+        u.id = duk_get_uint(ctx, -1);
+        duk_pop(ctx);
+
+        if (duk_get_prop_string(ctx, -1, "text") && duk_is_string(ctx, -1)) {
+            u.text = duk_get_string(ctx, -1);
+            duk_put_prop_index(ctx, textsIdx, (duk_uarridx_t)i);
+            u.has |= HAS_TEXT;
+        } else {
+            duk_pop(ctx);
+        }
+
+        if (duk_get_prop_string(ctx, -1, "color") && duk_is_number(ctx, -1)) {
+            u.color = duk_get_uint(ctx, -1);
+            u.has |= HAS_COLOR;
+        }
+        duk_pop(ctx);
+
+        if (duk_get_prop_string(ctx, -1, "opacity") && duk_is_number(ctx, -1)) {
+            u.opacity = duk_get_int(ctx, -1);
+            u.has |= HAS_OPACITY;
+        }
+        duk_pop(ctx);
+
+        if (duk_get_prop_string(ctx, -1, "x") && duk_is_number(ctx, -1)) {
+            u.x = duk_get_int(ctx, -1);
+            u.has |= HAS_X;
+        }
+        duk_pop(ctx);
+
+        if (duk_get_prop_string(ctx, -1, "y") && duk_is_number(ctx, -1)) {
+            u.y = duk_get_int(ctx, -1);
+            u.has |= HAS_Y;
+        }
+        duk_pop(ctx);
+
+        duk_pop(ctx);  // pop update object
+    }
+
+    // Only native calls from here to unlock()
+    LVGLManager::lock();
+
+    for (duk_size_t i = 0; i < count; i++) {
+        const Update& u = updates[i];
+        lv_obj_t* obj = u.id ? data->handles.resolve(u.id) : nullptr;
+        if (!obj) {
+            invalid++;
+            continue;
+        }
+
+        if ((u.has & HAS_TEXT) && lv_obj_check_type(obj, &lv_label_class) &&
+            strcmp(lv_label_get_text(obj), u.text) != 0) {
+            lv_label_set_text(obj, u.text);
+            changed++;
+        }
+
+        if (u.has & HAS_COLOR) {
+            lv_color_t color = lv_color_hex(u.color);
+            if (lv_obj_get_style_text_color(obj, 0).full != color.full) {
+                lv_obj_set_style_text_color(obj, color, 0);
+                changed++;
+            }
+        }
+
+        if (u.has & HAS_OPACITY) {
+            lv_opa_t opa = u.opacity < 0 ? 0 : (u.opacity > 255 ? 255 : u.opacity);
+            if (lv_obj_get_style_opa(obj, 0) != opa) {
+                lv_obj_set_style_opa(obj, opa, 0);
+                changed++;
+            }
+        }
+
+        // x and y are applied together so LVGL only recomputes layout once
+        lv_coord_t x = lv_obj_get_x(obj);
+        lv_coord_t y = lv_obj_get_y(obj);
+        lv_coord_t newX = (u.has & HAS_X) ? u.x : x;
+        lv_coord_t newY = (u.has & HAS_Y) ? u.y : y;
+
+        if (newX != x || newY != y) {
+            lv_obj_set_pos(obj, newX, newY);
+            changed++;
+        }
+    }
+
+    LVGLManager::unlock();
+
+    duk_pop_2(ctx);  // texts, updates
+
+    if (invalid > 0) {
+        DOKI_LOGW(JS, "applyUpdates: skipped %u invalid entries", (unsigned)invalid);
+    }
+    DOKI_LOGD(JS, "applyUpdates: %u entries, %u properties changed", (unsigned)count, (unsigned)changed);
+
+    duk_push_uint(ctx, changed);
+    return 1;
+}
+
+// ========================================
+// Declarative UI Templates
+// ========================================
+
+duk_ret_t JSEngine::_js_createUI(duk_context* ctx) {
+    JSUITemplate::Compiled compiled;
+    JSUITemplate::Template tmpl = {};
+    const char* error = nullptr;
+    bool ok;
+
+    if (duk_is_string(ctx, 0)) {
+        ok = JSUITemplate::load(duk_get_string(ctx, 0), compiled, tmpl, error);
+    } else if (duk_is_object(ctx, 0)) {
+        JsonDocument doc;
+        ok = readJson(ctx, 0, doc.to<JsonVariant>());
+        if (!ok) {
+            error = "template is not JSON-compatible";
+        } else if ((ok = JSUITemplate::compile(doc.as<JsonVariantConst>(), compiled, error))) {
+            tmpl = compiled.view();
+        }
+    } else {
+        ok = false;
+        error = "expected a template object or a /ui path";
+    }
+
+    if (!ok) {
+        // duk_error() longjmps past destructors: free the partial template first
+        compiled = JSUITemplate::Compiled();
+        return duk_error(ctx, DUK_ERR_TYPE_ERROR, "createUI: %s", error);
+    }
+
+    // The app's own screen: lv_scr_act() is whichever display is the LVGL default
+    JSContextData* data = getContextData(ctx);
+    if (!data->screen) {
+        compiled = JSUITemplate::Compiled();
+        return duk_error(ctx, DUK_ERR_ERROR, "createUI: no display screen set in context");
+    }
+
+    uint32_t handles[JS_UI_TEMPLATE_MAX_NODES];
+
+    // One lock for the whole tree; no Duktape calls while it is held
+    uint32_t start = micros();
+    LVGLManager::lock();
+    uint16_t created = JSUITemplate::instantiate(tmpl, data->screen, data->handles, handles);
+    LVGLManager::unlock();
+    uint32_t elapsed = micros() - start;
+
+    duk_push_object(ctx);
+    for (uint16_t i = 0; i < tmpl.count; i++) {
+        if (tmpl.nodes[i].id == JSUITemplate::NO_STRING) continue;
+        duk_push_uint(ctx, handles[i]);
+        duk_put_prop_string(ctx, -2, tmpl.strings + tmpl.nodes[i].id);
+    }
+
+    DOKI_LOGD(JS, "createUI: %u widgets in %u us", (unsigned)created, (unsigned)elapsed);
+    return 1;
+}
+
 // ========================================
 // Advanced Features: Multi-Display Coordination
 // ========================================
@@ -1087,7 +2547,7 @@ duk_ret_t JSEngine::_js_sendToDisplay(duk_context* ctx) {
 
     duk_pop_2(ctx);  // pop messages object and stash
 
-    Serial.printf("[JS] Sent message to display %d: %s\n", targetDisplayId, message);
+    DOKI_LOGD(JS, "Sent message to display %d: %s", targetDisplayId, message);
     return 0;
 }
 
@@ -1095,44 +2555,20 @@ duk_ret_t JSEngine::_js_sendToDisplay(duk_context* ctx) {
 // Advanced Features: MQTT Support
 // ========================================
 
-// Global MQTT client (one per JS context)
+// One MQTT client, owned by the context that connected last.
+// The callback only touches the owner's inbox, never the Duktape heap.
 static WiFiClient mqttWifiClient;
 static PubSubClient* mqttClient = nullptr;
 static duk_context* mqttDukContext = nullptr;
+static std::atomic<JSMessageQueue*> mqttInbox(nullptr);
 
 static void mqttCallback(char* topic, byte* payload, unsigned int length) {
-    if (!mqttDukContext) return;
-
-    Serial.printf("[MQTT] Message on topic '%s'\n", topic);
-
-    // Store message in stash for JavaScript to retrieve
-    duk_push_global_stash(mqttDukContext);
-    duk_get_prop_string(mqttDukContext, -1, "__mqtt_messages");
-
-    if (!duk_is_array(mqttDukContext, -1)) {
-        duk_pop(mqttDukContext);
-        duk_push_array(mqttDukContext);
-        duk_dup(mqttDukContext, -1);
-        duk_put_prop_string(mqttDukContext, -3, "__mqtt_messages");
-    }
+    JSMessageQueue* inbox = mqttInbox.load(std::memory_order_acquire);
+    if (!inbox) return;
 
-    // Add message to array
-    duk_idx_t arrIdx = duk_get_length(mqttDukContext, -1);
-    duk_push_object(mqttDukContext);
-
-    duk_push_string(mqttDukContext, topic);
-    duk_put_prop_string(mqttDukContext, -2, "topic");
-
-    String payloadStr = "";
-    for (unsigned int i = 0; i < length; i++) {
-        payloadStr += (char)payload[i];
+    if (!inbox->push(topic, payload, length)) {
+        DOKI_LOGD(MQTT, "Inbox full, dropped message on '%s'", topic);
     }
-    duk_push_string(mqttDukContext, payloadStr.c_str());
-    duk_put_prop_string(mqttDukContext, -2, "message");
-
-    duk_put_prop_index(mqttDukContext, -2, arrIdx);
-
-    duk_pop_2(mqttDukContext);  // pop array and stash
 }
 
 duk_ret_t JSEngine::_js_mqttConnect(duk_context* ctx) {
@@ -1140,26 +2576,36 @@ duk_ret_t JSEngine::_js_mqttConnect(duk_context* ctx) {
     int port = duk_to_int(ctx, 1);
     const char* clientId = duk_to_string(ctx, 2);
 
-    Serial.printf("[MQTT] Attempting connection to %s:%d as '%s'...\n", broker, port, clientId);
+    DOKI_LOGI(MQTT, "Attempting connection to %s:%d as '%s'...", broker, port, clientId);
 
     if (!mqttClient) {
         mqttClient = new PubSubClient(mqttWifiClient);
     }
 
+    JSMessageQueue* inbox = &getContextData(ctx)->mqttInbox;
+    if (!inbox->open()) {
+        DOKI_LOGE(MQTT, "✗ Out of memory for message queue");
+        duk_push_boolean(ctx, false);
+        return 1;
+    }
+
     mqttDukContext = ctx;
+    mqttInbox.store(inbox, std::memory_order_release);
     mqttClient->setServer(broker, port);
     mqttClient->setCallback(mqttCallback);
 
     // Set socket timeout to prevent blocking (default is too long)
     mqttClient->setSocketTimeout(TIMEOUT_MQTT_SOCKET_SEC);
 
-    // Attempt connection (this may still block briefly, but with timeout)
+    // Attempt connection (blocks up to the socket timeout)
+    uint32_t pausedAt = _pauseDeadline();
     bool connected = mqttClient->connect(clientId);
+    _resumeDeadline(ctx, pausedAt);
 
     if (connected) {
-        Serial.println("[MQTT] ✓ Connected successfully");
+        DOKI_LOGI(MQTT, "✓ Connected successfully");
     } else {
-        Serial.printf("[MQTT] ✗ Connection failed (state: %d)\n", mqttClient->state());
+        DOKI_LOGE(MQTT, "✗ Connection failed (state: %d)", mqttClient->state());
     }
 
     duk_push_boolean(ctx, connected);
@@ -1171,15 +2617,17 @@ duk_ret_t JSEngine::_js_mqttPublish(duk_context* ctx) {
     const char* message = duk_to_string(ctx, 1);
 
     if (!mqttClient || !mqttClient->connected()) {
-        Serial.println("[MQTT] Not connected");
+        DOKI_LOGW(MQTT, "Not connected");
         duk_push_boolean(ctx, false);
         return 1;
     }
 
+    uint32_t pausedAt = _pauseDeadline();
     mqttClient->loop();  // Process incoming messages
     bool success = mqttClient->publish(topic, message);
+    _resumeDeadline(ctx, pausedAt);
 
-    Serial.printf("[MQTT] Publish to '%s': %s\n", topic, message);
+    DOKI_LOGD(MQTT, "Publish to '%s': %s", topic, message);
 
     duk_push_boolean(ctx, success);
     return 1;
@@ -1188,15 +2636,25 @@ duk_ret_t JSEngine::_js_mqttPublish(duk_context* ctx) {
 duk_ret_t JSEngine::_js_mqttSubscribe(duk_context* ctx) {
     const char* topic = duk_to_string(ctx, 0);
 
+    // Optional callback(topic, message), function or global function name
+    if (duk_is_function(ctx, 1) || duk_is_string(ctx, 1)) {
+        duk_push_global_stash(ctx);
+        duk_dup(ctx, 1);
+        duk_put_prop_string(ctx, -2, "__mqtt_cb");
+        duk_pop(ctx);
+    }
+
     if (!mqttClient || !mqttClient->connected()) {
-        Serial.println("[MQTT] Not connected");
+        DOKI_LOGW(MQTT, "Not connected");
         duk_push_boolean(ctx, false);
         return 1;
     }
 
+    uint32_t pausedAt = _pauseDeadline();
     bool success = mqttClient->subscribe(topic);
+    _resumeDeadline(ctx, pausedAt);
 
-    Serial.printf("[MQTT] Subscribe to '%s': %s\n", topic, success ? "OK" : "FAILED");
+    DOKI_LOGD(MQTT, "Subscribe to '%s': %s", topic, success ? "OK" : "FAILED");
 
     duk_push_boolean(ctx, success);
     return 1;
@@ -1205,8 +2663,9 @@ duk_ret_t JSEngine::_js_mqttSubscribe(duk_context* ctx) {
 duk_ret_t JSEngine::_js_mqttDisconnect(duk_context* ctx) {
     if (mqttClient) {
         mqttClient->disconnect();
-        Serial.println("[MQTT] Disconnected");
+        DOKI_LOGI(MQTT, "Disconnected");
     }
+    _detachNetwork(ctx);
     return 0;
 }
 
@@ -1217,59 +2676,71 @@ duk_ret_t JSEngine::_js_mqttDisconnect(duk_context* ctx) {
 #ifdef ENABLE_WEBSOCKET_SUPPORT
 static WebSocketsClient* wsClient = nullptr;
 static duk_context* wsDukContext = nullptr;
+static std::atomic<JSMessageQueue*> wsInbox(nullptr);
 
 // Links2004 library uses event-driven callbacks
 static void wsEventCallback(WStype_t type, uint8_t* payload, size_t length) {
     switch(type) {
         case WStype_DISCONNECTED:
-            Serial.println("[WebSocket] ✗ Disconnected");
+            DOKI_LOGW(WEBSOCKET, "✗ Disconnected");
             break;
 
         case WStype_CONNECTED:
-            Serial.printf("[WebSocket] ✓ Connected to: %s\n", payload);
+            DOKI_LOGI(WEBSOCKET, "✓ Connected to: %s", payload);
             break;
 
         case WStype_TEXT:
-            Serial.printf("[WebSocket] ← Message received: %s\n", payload);
-
-            // Store message in Duktape stash
-            if (wsDukContext) {
-                duk_push_global_stash(wsDukContext);
-                duk_get_prop_string(wsDukContext, -1, "__ws_messages");
-
-                if (!duk_is_array(wsDukContext, -1)) {
-                    duk_pop(wsDukContext);
-                    duk_push_array(wsDukContext);
-                    duk_dup(wsDukContext, -1);
-                    duk_put_prop_string(wsDukContext, -3, "__ws_messages");
-                }
-
-                duk_idx_t arrIdx = duk_get_length(wsDukContext, -1);
-                duk_push_string(wsDukContext, (char*)payload);
-                duk_put_prop_index(wsDukContext, -2, arrIdx);
+            DOKI_LOGD(WEBSOCKET, "← Message received: %s", payload);
 
-                duk_pop_2(wsDukContext);  // pop array and stash
+            if (JSMessageQueue* inbox = wsInbox.load(std::memory_order_acquire)) {
+                if (!inbox->push(nullptr, payload, length)) {
+                    DOKI_LOGD(WEBSOCKET, "Inbox full, dropped message");
+                }
             }
             break;
 
         case WStype_ERROR:
-            Serial.printf("[WebSocket] ⚠️ ERROR: %s\n", payload);
+            DOKI_LOGE(WEBSOCKET, "⚠️ ERROR: %s", payload);
             break;
 
         default:
-            Serial.printf("[WebSocket] Event type: %d\n", type);
+            DOKI_LOGD(WEBSOCKET, "Event type: %d", type);
             break;
     }
 }
 #endif
 
+void JSEngine::_detachNetwork(duk_context* ctx) {
+    if (mqttDukContext == ctx) {
+        mqttInbox.store(nullptr, std::memory_order_release);
+        mqttDukContext = nullptr;
+    }
+#ifdef ENABLE_WEBSOCKET_SUPPORT
+    if (wsDukContext == ctx) {
+        wsInbox.store(nullptr, std::memory_order_release);
+        wsDukContext = nullptr;
+    }
+#endif
+}
+
+void JSEngine::_pollNetwork(duk_context* ctx) {
+    // Callbacks fire from inside loop() and only fill the inboxes
+    if (mqttDukContext == ctx && mqttClient) {
+        mqttClient->loop();
+    }
+#ifdef ENABLE_WEBSOCKET_SUPPORT
+    if (wsDukContext == ctx && wsClient) {
+        wsClient->loop();
+    }
+#endif
+}
+
 duk_ret_t JSEngine::_js_wsConnect(duk_context* ctx) {
 #ifdef ENABLE_WEBSOCKET_SUPPORT
     const char* url = duk_to_string(ctx, 0);
 
-    Serial.println("========== WebSocket Connect (Links2004) ==========");
-    Serial.printf("[WS] JavaScript called wsConnect('%s')\n", url);
-    Serial.printf("[WS] Free heap: %d bytes\n", ESP.getFreeHeap());
+    DOKI_LOGD(WEBSOCKET, "JavaScript called wsConnect('%s')", url);
+    DOKI_LOGD(WEBSOCKET, "Free heap: %d bytes", ESP.getFreeHeap());
 
     // Parse URL (format: ws://host:port/path or wss://host:port/path)
     String urlStr = String(url);
@@ -1307,56 +2778,67 @@ duk_ret_t JSEngine::_js_wsConnect(duk_context* ctx) {
         host = hostPort;
     }
 
-    Serial.printf("[WS] Parsed - Host: %s, Port: %d, Path: %s, SSL: %s\n",
+    DOKI_LOGD(WEBSOCKET, "Parsed - Host: %s, Port: %d, Path: %s, SSL: %s",
         host.c_str(), port, path.c_str(), useSSL ? "yes" : "no");
 
     // Create client if needed
     if (!wsClient) {
-        Serial.println("[WS] Creating new WebSocketsClient...");
+        DOKI_LOGD(WEBSOCKET, "Creating new WebSocketsClient...");
         wsClient = new WebSocketsClient();
-        Serial.printf("[WS] Client created at: %p\n", (void*)wsClient);
+        DOKI_LOGD(WEBSOCKET, "Client created at: %p", (void*)wsClient);
 
         // CRITICAL FIX #1: Set short reconnect interval (default is ~5000ms!)
         // This allows quick retries if first connection fails
         wsClient->setReconnectInterval(DELAY_WS_RECONNECT_MS);
-        Serial.printf("[WS] Set reconnect interval to %dms\n", DELAY_WS_RECONNECT_MS);
+        DOKI_LOGD(WEBSOCKET, "Set reconnect interval to %dms", DELAY_WS_RECONNECT_MS);
     } else {
         // CRITICAL FIX #2: Disconnect cleanly before reconnecting
         // This resets the reconnection timer and cleans up old state
-        Serial.println("[WS] Disconnecting existing connection...");
+        DOKI_LOGD(WEBSOCKET, "Disconnecting existing connection...");
+        uint32_t pausedAt = _pauseDeadline();
         wsClient->disconnect();
         delay(DELAY_WS_CLEANUP_MS);  // Brief delay for cleanup
+        _resumeDeadline(ctx, pausedAt);
+    }
+
+    JSMessageQueue* inbox = &getContextData(ctx)->wsInbox;
+    if (!inbox->open()) {
+        DOKI_LOGE(WEBSOCKET, "✗ Out of memory for message queue");
+        duk_push_boolean(ctx, false);
+        return 1;
     }
 
     wsDukContext = ctx;
+    wsInbox.store(inbox, std::memory_order_release);
 
     // Set up event handler
-    Serial.println("[WS] Setting up event callback...");
+    DOKI_LOGD(WEBSOCKET, "Setting up event callback...");
     wsClient->onEvent(wsEventCallback);
 
     // Connect using Links2004 API (library copies strings internally)
+    uint32_t pausedAt = _pauseDeadline();
     if (useSSL) {
-        Serial.printf("[WS] Calling beginSSL(%s, %d, %s) for secure connection...\n",
+        DOKI_LOGD(WEBSOCKET, "Calling beginSSL(%s, %d, %s) for secure connection...",
             host.c_str(), port, path.c_str());
         wsClient->beginSSL(host.c_str(), port, path.c_str());
     } else {
-        Serial.printf("[WS] Calling begin(%s, %d, %s) for plain connection...\n",
+        DOKI_LOGD(WEBSOCKET, "Calling begin(%s, %d, %s) for plain connection...",
             host.c_str(), port, path.c_str());
         wsClient->begin(host.c_str(), port, path.c_str());
     }
+    _resumeDeadline(ctx, pausedAt);
 
     // NON-BLOCKING: Connection happens asynchronously
     // JavaScript must call wsOnMessage() frequently (10-20ms) to process events via loop()
     // The wsEventCallback will update wsConnected when connection succeeds
-    Serial.println("[WS] Connection initiated (non-blocking)");
-    Serial.println("[WS] Call wsOnMessage() every 10-20ms to process connection");
-    Serial.println("=================================================");
+    DOKI_LOGD(WEBSOCKET, "Connection initiated (non-blocking)");
+    DOKI_LOGD(WEBSOCKET, "Call wsOnMessage() every 10-20ms to process connection");
 
     // Return true to indicate connection was initiated
     duk_push_boolean(ctx, true);
     return 1;
 #else
-    Serial.println("[WebSocket] Not supported - enable ENABLE_WEBSOCKET_SUPPORT");
+    DOKI_LOGI(WEBSOCKET, "Not supported - enable ENABLE_WEBSOCKET_SUPPORT");
     duk_push_boolean(ctx, false);
     return 1;
 #endif
@@ -1380,7 +2862,7 @@ duk_ret_t JSEngine::_js_wsSend(duk_context* ctx) {
     const char* message = duk_to_string(ctx, 0);
 
     if (!wsClient || !wsClient->isConnected()) {
-        Serial.println("[WebSocket] Not connected - cannot send");
+        DOKI_LOGW(WEBSOCKET, "Not connected - cannot send");
         duk_push_boolean(ctx, false);
         return 1;
     }
@@ -1388,7 +2870,7 @@ duk_ret_t JSEngine::_js_wsSend(duk_context* ctx) {
     // Links2004 library: sendTXT() for text messages
     bool success = wsClient->sendTXT(message);
 
-    Serial.printf("[WebSocket] → Sent (%s): %s\n", success ? "✓" : "✗", message);
+    DOKI_LOGD(WEBSOCKET, "→ Sent (%s): %s", success ? "✓" : "✗", message);
 
     duk_push_boolean(ctx, success);
     return 1;
@@ -1400,60 +2882,25 @@ duk_ret_t JSEngine::_js_wsSend(duk_context* ctx) {
 
 duk_ret_t JSEngine::_js_wsOnMessage(duk_context* ctx) {
 #ifdef ENABLE_WEBSOCKET_SUPPORT
-    // Get the callback function (if provided)
-    bool hasCallback = duk_is_function(ctx, 0);
+    // Callback may be a function or a global function name; anything
+    // else unregisters it and leaves messages queued
+    duk_push_global_stash(ctx);
+    if (duk_is_function(ctx, 0) || duk_is_string(ctx, 0)) {
+        duk_dup(ctx, 0);
+    } else {
+        duk_push_undefined(ctx);
+    }
+    duk_put_prop_string(ctx, -2, "__ws_cb");
+    duk_pop(ctx);
 
     // IMPORTANT: Call loop() to process WebSocket events (connection, messages, etc.)
-    // This must be called frequently (every 10-20ms) for reliable connections
-    // Runs in JavaScript thread - thread-safe!
-    if (wsClient) {
+    // JSApp also polls every tick; calling it here keeps old poll-driven scripts responsive
+    if (wsClient && wsDukContext == ctx) {
         wsClient->loop();
     }
 
-    // If no callback provided, we still called loop() above (for connection processing)
-    if (!hasCallback) {
-        return 0;
-    }
-
-    // Retrieve messages from stash and invoke callback for each
-    duk_push_global_stash(ctx);
-    duk_get_prop_string(ctx, -1, "__ws_messages");
-
-    // Check if messages array exists
-    if (duk_is_array(ctx, -1)) {
-        duk_size_t messageCount = duk_get_length(ctx, -1);
-
-        // Process all messages
-        for (duk_size_t i = 0; i < messageCount; i++) {
-            // Get message at index i
-            duk_get_prop_index(ctx, -1, i);
-
-            if (duk_is_string(ctx, -1)) {
-                const char* message = duk_get_string(ctx, -1);
-                Serial.printf("[WebSocket] Delivering message to JS: %s\n", message);
-
-                // Invoke the callback: callback(message)
-                duk_dup(ctx, 0);        // Push callback function
-                duk_dup(ctx, -2);       // Push message as argument
-
-                if (duk_pcall(ctx, 1) != 0) {
-                    Serial.printf("[WebSocket] Error in callback: %s\n", duk_safe_to_string(ctx, -1));
-                }
-                duk_pop(ctx);  // Pop result
-            }
-
-            duk_pop(ctx);  // Pop message
-        }
-
-        // Clear the messages array after processing
-        duk_pop(ctx);  // Pop messages array
-        duk_push_array(ctx);  // Push new empty array
-        duk_put_prop_string(ctx, -2, "__ws_messages");  // Store empty array
-    } else {
-        duk_pop(ctx);  // Pop undefined/non-array
-    }
-
-    duk_pop(ctx);  // Pop stash
+    // Deliver everything queued so far in one batch
+    _drainInbox(ctx, getContextData(ctx)->wsInbox, "__ws_cb", false);
 #endif
     return 0;
 }
@@ -1464,8 +2911,9 @@ duk_ret_t JSEngine::_js_wsDisconnect(duk_context* ctx) {
         wsClient->disconnect();
         delete wsClient;
         wsClient = nullptr;
-        Serial.println("[WebSocket] Disconnected and cleaned up");
+        DOKI_LOGI(WEBSOCKET, "Disconnected and cleaned up");
     }
+    _detachNetwork(ctx);
 #endif
     return 0;
 }
@@ -1477,16 +2925,13 @@ duk_ret_t JSEngine::_js_wsDisconnect(duk_context* ctx) {
 duk_ret_t JSEngine::_js_loadAnimation(duk_context* ctx) {
     const char* filepath = duk_to_string(ctx, 0);
 
-    Serial.printf("[JS] Loading animation: %s\n", filepath);
+    DOKI_LOGD(JS, "Loading animation: %s", filepath);
 
-    // Get display screen from stash (set by JSApp during onCreate)
-    duk_push_global_stash(ctx);
-    duk_get_prop_string(ctx, -1, "__displayScreen");
-    lv_obj_t* screen = (lv_obj_t*)duk_get_pointer(ctx, -1);
-    duk_pop_2(ctx);  // Pop pointer and stash
+    // Display screen is set by JSApp during onCreate
+    lv_obj_t* screen = getContextData(ctx)->screen;
 
     if (!screen) {
-        Serial.println("[JS] ERROR: No display screen set in context");
+        DOKI_LOGE(JS, "ERROR: No display screen set in context");
         duk_push_int(ctx, -1);
         return 1;
     }
@@ -1507,12 +2952,12 @@ duk_ret_t JSEngine::_js_loadAnimation(duk_context* ctx) {
     int32_t animId = mgr.loadAnimation(filepath, screen, options);
 
     if (animId < 0) {
-        Serial.println("[JS] Error: Failed to load animation");
+        DOKI_LOGE(JS, "Error: Failed to load animation");
         duk_push_int(ctx, -1);
         return 1;
     }
 
-    Serial.printf("[JS] Animation loaded with ID: %d\n", animId);
+    DOKI_LOGD(JS, "Animation loaded with ID: %d", animId);
     duk_push_int(ctx, animId);
     return 1;
 }
@@ -1525,7 +2970,7 @@ duk_ret_t JSEngine::_js_playAnimation(duk_context* ctx) {
         loop = duk_to_boolean(ctx, 1);
     }
 
-    Serial.printf("[JS] Playing animation %d (loop=%d)\n", animId, loop);
+    DOKI_LOGD(JS, "Playing animation %d (loop=%d)", animId, loop);
 
     Doki::Animation::AnimationManager& mgr = Doki::Animation::AnimationManager::getInstance();
 
@@ -1542,7 +2987,7 @@ duk_ret_t JSEngine::_js_playAnimation(duk_context* ctx) {
 duk_ret_t JSEngine::_js_stopAnimation(duk_context* ctx) {
     int32_t animId = duk_to_int(ctx, 0);
 
-    Serial.printf("[JS] Stopping animation %d\n", animId);
+    DOKI_LOGD(JS, "Stopping animation %d", animId);
 
     Doki::Animation::AnimationManager& mgr = Doki::Animation::AnimationManager::getInstance();
     mgr.stopAnimation(animId);
@@ -1602,7 +3047,7 @@ duk_ret_t JSEngine::_js_setAnimationOpacity(duk_context* ctx) {
 duk_ret_t JSEngine::_js_unloadAnimation(duk_context* ctx) {
     int32_t animId = duk_to_int(ctx, 0);
 
-    Serial.printf("[JS] Unloading animation %d\n", animId);
+    DOKI_LOGD(JS, "Unloading animation %d", animId);
 
     Doki::Animation::AnimationManager& mgr = Doki::Animation::AnimationManager::getInstance();
     mgr.unloadAnimation(animId);
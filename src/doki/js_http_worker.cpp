@@ -0,0 +1,272 @@
+/**
+ * @file js_http_worker.cpp
+ * @brief Implementation of background HTTP requests for JS apps
+ */
+
+#include "doki/js_http_worker.h"
+#include "doki/logger.h"
+#include "timing_constants.h"
+#include <HTTPClient.h>
+#include <esp_heap_caps.h>
+
+namespace Doki {
+
+// ========================================
+// Static Member Initialization
+// ========================================
+
+std::vector<JSHttpWorker::Request*> JSHttpWorker::_requests;
+SemaphoreHandle_t JSHttpWorker::_mutex = nullptr;
+QueueHandle_t JSHttpWorker::_queue = nullptr;
+uint32_t JSHttpWorker::_nextId = 1;
+
+// Body sink for HTTPClient::writeToStream() - handles chunked encoding
+// for us and fails the transfer once the buffer is full
+class BoundedBodyStream : public Stream {
+public:
+    BoundedBodyStream(char* buffer, size_t capacity)
+        : _buffer(buffer), _capacity(capacity), _length(0) {}
+
+    size_t write(uint8_t c) {
+        return write(&c, 1);
+    }
+
+    size_t write(const uint8_t* data, size_t size) {
+        if (size > _capacity - _length) {
+            return 0;  // Too large - writeToStream() reports HTTPC_ERROR_STREAM_WRITE
+        }
+        memcpy(_buffer + _length, data, size);
+        _length += size;
+        return size;
+    }
+
+    int available() { return 0; }
+    int read() { return -1; }
+    int peek() { return -1; }
+
+    size_t length() const { return _length; }
+
+private:
+    char* _buffer;
+    size_t _capacity;
+    size_t _length;
+};
+
+// ========================================
+// Public Methods
+// ========================================
+
+bool JSHttpWorker::init() {
+    if (_queue) {
+        return true;
+    }
+
+    _mutex = xSemaphoreCreateMutex();
+    _queue = xQueueCreate(JS_HTTP_QUEUE_SIZE, sizeof(Request*));
+    if (!_mutex || !_queue) {
+        DOKI_LOGE(HTTP, "✗ Failed to create HTTP worker queue");
+        return false;
+    }
+
+    for (uint8_t i = 0; i < JS_HTTP_WORKERS; i++) {
+        xTaskCreatePinnedToCore(
+            _workerTask,
+            "JS_HttpWorker",
+            TASK_STACK_JS_HTTP,
+            nullptr,
+            TASK_PRIORITY_JS_HTTP,
+            nullptr,
+            TASK_CORE_JS_HTTP
+        );
+    }
+
+    DOKI_LOGI(HTTP, "✓ HTTP workers started (%d)", JS_HTTP_WORKERS);
+    return true;
+}
+
+uint32_t JSHttpWorker::submit(void* owner, const char* url) {
+    if (!_queue || !owner || !url) {
+        return 0;
+    }
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+
+    uint8_t pending = 0;
+    for (const Request* request : _requests) {
+        if (request->owner == owner) pending++;
+    }
+
+    if (pending >= JS_HTTP_MAX_PENDING) {
+        xSemaphoreGive(_mutex);
+        DOKI_LOGW(HTTP, "Too many pending requests (%d), rejected: %s", JS_HTTP_MAX_PENDING, url);
+        return 0;
+    }
+
+    Request* request = new Request();
+    request->owner = owner;
+    request->id = _nextId++;
+    if (_nextId == 0) _nextId = 1;
+    request->state = State::QUEUED;
+    request->url = url;
+    request->response = { request->id, 0, nullptr, 0 };
+
+    if (xQueueSend(_queue, &request, 0) != pdTRUE) {
+        xSemaphoreGive(_mutex);
+        DOKI_LOGW(HTTP, "Request queue full, rejected: %s", url);
+        delete request;
+        return 0;
+    }
+
+    _requests.push_back(request);
+    uint32_t id = request->id;
+    xSemaphoreGive(_mutex);
+
+    DOKI_LOGD(HTTP, "Queued request %u: %s", (unsigned)id, url);
+    return id;
+}
+
+size_t JSHttpWorker::collect(void* owner, std::vector<Response>& out) {
+    if (!_mutex) return 0;
+
+    size_t count = 0;
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+
+    for (size_t i = 0; i < _requests.size(); ) {
+        Request* request = _requests[i];
+        if (request->owner == owner && request->state == State::DONE) {
+            out.push_back(request->response);
+            _requests.erase(_requests.begin() + i);
+            delete request;  // Body ownership moved to the caller
+            count++;
+        } else {
+            i++;
+        }
+    }
+
+    xSemaphoreGive(_mutex);
+    return count;
+}
+
+void JSHttpWorker::cancelAll(void* owner) {
+    if (!_mutex || !owner) return;
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+
+    for (size_t i = 0; i < _requests.size(); ) {
+        Request* request = _requests[i];
+        if (request->owner != owner) {
+            i++;
+            continue;
+        }
+
+        if (request->state == State::DONE) {
+            _requests.erase(_requests.begin() + i);
+            _free(request);
+        } else {
+            // Still referenced by the queue or a worker, which frees it
+            request->owner = nullptr;
+            i++;
+        }
+    }
+
+    xSemaphoreGive(_mutex);
+}
+
+// ========================================
+// Private Helper Methods
+// ========================================
+
+void JSHttpWorker::_workerTask(void* param) {
+    Request* request = nullptr;
+
+    while (true) {
+        if (xQueueReceive(_queue, &request, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        // Skip requests cancelled while they were queued
+        xSemaphoreTake(_mutex, portMAX_DELAY);
+        bool cancelled = request->owner == nullptr;
+        if (!cancelled) {
+            request->state = State::RUNNING;
+        }
+        xSemaphoreGive(_mutex);
+
+        if (!cancelled) {
+            _perform(request);
+        }
+
+        xSemaphoreTake(_mutex, portMAX_DELAY);
+        request->state = State::DONE;
+        if (request->owner == nullptr) {
+            for (size_t i = 0; i < _requests.size(); i++) {
+                if (_requests[i] == request) {
+                    _requests.erase(_requests.begin() + i);
+                    break;
+                }
+            }
+            _free(request);
+        }
+        xSemaphoreGive(_mutex);
+    }
+}
+
+void JSHttpWorker::_perform(Request* request) {
+    Response& response = request->response;
+    uint32_t start = millis();
+
+    HTTPClient http;
+    http.begin(request->url);
+    http.setTimeout(TIMEOUT_HTTP_REQUEST_MS);
+
+    response.status = http.GET();
+
+    if (response.status == HTTP_CODE_OK) {
+        int size = http.getSize();  // -1 if unknown (chunked)
+
+        if (size > JS_HTTP_MAX_RESPONSE_BYTES) {
+            response.status = HTTPC_ERROR_STREAM_WRITE;
+        } else {
+            size_t capacity = size >= 0 ? (size_t)size : JS_HTTP_MAX_RESPONSE_BYTES;
+
+            // Only ever memcpy'd, so PSRAM is fine
+            char* body = (char*)heap_caps_malloc(capacity + 1, MALLOC_CAP_SPIRAM);
+            if (!body) {
+                body = (char*)malloc(capacity + 1);
+            }
+
+            if (!body) {
+                response.status = HTTPC_ERROR_TOO_LESS_RAM;
+            } else {
+                BoundedBodyStream stream(body, capacity);
+                int written = http.writeToStream(&stream);
+
+                if (written < 0) {
+                    free(body);
+                    response.status = written;
+                } else {
+                    body[stream.length()] = '\0';
+                    response.body = body;
+                    response.length = stream.length();
+                }
+            }
+        }
+    }
+
+    http.end();
+
+    if (response.status == HTTP_CODE_OK) {
+        DOKI_LOGD(HTTP, "Request %u: %u bytes in %u ms", (unsigned)request->id,
+                  (unsigned)response.length, (unsigned)(millis() - start));
+    } else {
+        DOKI_LOGW(HTTP, "Request %u failed: %d (%s)", (unsigned)request->id,
+                  response.status, request->url.c_str());
+    }
+}
+
+void JSHttpWorker::_free(Request* request) {
+    free(request->response.body);
+    delete request;
+}
+
+} // namespace Doki
@@ -0,0 +1,225 @@
+/**
+ * @file js_module_cache.cpp
+ * @brief Implementation of the require() module bytecode cache
+ */
+
+#include "doki/js_module_cache.h"
+
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+
+#include "doki/filesystem_manager.h"
+#include "doki/logger.h"
+#include <esp_heap_caps.h>
+
+namespace Doki {
+
+static const char* MODULE_DIR = "/lib/";
+
+// CommonJS wrapper. The header shares the module's first line, so error
+// line numbers still match the file.
+static const char MODULE_HEADER[] = "function (exports, require, module) {";
+static const char MODULE_FOOTER[] = "\n}";
+
+// ========================================
+// Static Member Initialization
+// ========================================
+
+JSModuleCache::Module JSModuleCache::_modules[JS_MODULE_CACHE_ENTRIES];
+uint32_t JSModuleCache::_moduleCount = 0;
+size_t JSModuleCache::_bytes = 0;
+JSModuleCache::PathEntry JSModuleCache::_paths[JS_MODULE_PATH_CACHE_SIZE];
+uint32_t JSModuleCache::_pathNext = 0;
+SemaphoreHandle_t JSModuleCache::_mutex = nullptr;
+uint32_t JSModuleCache::_hits = 0;
+uint32_t JSModuleCache::_misses = 0;
+
+// ========================================
+// Public Methods
+// ========================================
+
+bool JSModuleCache::init() {
+    if (_mutex) {
+        return true;
+    }
+
+    _mutex = xSemaphoreCreateMutex();
+    if (!_mutex) {
+        DOKI_LOGE(JS_ENGINE, "✗ Failed to create module cache lock");
+        return false;
+    }
+
+    return true;
+}
+
+bool JSModuleCache::resolve(const char* id, String& path) {
+    if (!_mutex || !id || !*id) {
+        return false;
+    }
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    for (const PathEntry& entry : _paths) {
+        if (entry.id == id) {
+            path = entry.path;
+            xSemaphoreGive(_mutex);
+            return !path.isEmpty();
+        }
+    }
+    xSemaphoreGive(_mutex);
+
+    String candidate = id;
+    if (candidate.startsWith("./")) {
+        candidate = candidate.substring(2);
+    }
+    if (!candidate.startsWith("/")) {
+        candidate = MODULE_DIR + candidate;
+    }
+    if (!candidate.endsWith(".js")) {
+        candidate += ".js";
+    }
+
+    // Only /lib is cached for the whole boot; app files can be replaced at runtime
+    bool found = candidate.startsWith(MODULE_DIR) &&
+                 candidate.indexOf("..") < 0 &&
+                 FilesystemManager::exists(candidate);
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    PathEntry& entry = _paths[_pathNext++ % JS_MODULE_PATH_CACHE_SIZE];
+    entry.id = id;
+    entry.path = found ? candidate : String();
+    xSemaphoreGive(_mutex);
+
+    if (!found) {
+        DOKI_LOGW(JS_ENGINE, "Module not found: %s", id);
+        return false;
+    }
+
+    path = candidate;
+    return true;
+}
+
+bool JSModuleCache::pushFunction(duk_context* ctx, const String& path) {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    const Module* module = _find(path);
+    xSemaphoreGive(_mutex);
+
+    if (!module) {
+        _misses++;
+        return _compile(ctx, path);
+    }
+
+    _hits++;
+
+    // Entries are never freed, so the bytecode is aliased rather than copied
+    duk_push_external_buffer(ctx);
+    duk_config_buffer(ctx, -1, module->bytecode, module->size);
+    duk_load_function(ctx);
+    return true;
+}
+
+uint32_t JSModuleCache::getModuleCount() {
+    return _moduleCount;
+}
+
+size_t JSModuleCache::getBytes() {
+    return _bytes;
+}
+
+// ========================================
+// Private Methods
+// ========================================
+
+const JSModuleCache::Module* JSModuleCache::_find(const String& path) {
+    for (uint32_t i = 0; i < _moduleCount; i++) {
+        if (_modules[i].path == path) {
+            return &_modules[i];
+        }
+    }
+    return nullptr;
+}
+
+bool JSModuleCache::_compile(duk_context* ctx, const String& path) {
+    uint8_t* data = nullptr;
+    size_t size = 0;
+
+    if (!FilesystemManager::readFile(path, &data, size) || !data) {
+        duk_push_error_object(ctx, DUK_ERR_ERROR, "Failed to open module: %s", path.c_str());
+        return false;
+    }
+
+    size_t headerLength = sizeof(MODULE_HEADER) - 1;
+    size_t footerLength = sizeof(MODULE_FOOTER) - 1;
+    size_t length = headerLength + size + footerLength;
+
+    char* source = new char[length];
+    if (!source) {
+        delete[] data;
+        duk_push_error_object(ctx, DUK_ERR_ERROR, "Out of memory loading module: %s", path.c_str());
+        return false;
+    }
+
+    memcpy(source, MODULE_HEADER, headerLength);
+    memcpy(source + headerLength, data, size);
+    memcpy(source + headerLength + size, MODULE_FOOTER, footerLength);
+    delete[] data;
+
+    uint32_t start = micros();
+
+    duk_push_string(ctx, path.c_str());  // Filename for error messages
+    duk_int_t rc = duk_pcompile_lstring_filename(ctx, DUK_COMPILE_FUNCTION, source, length);
+    delete[] source;
+
+    if (rc != 0) {
+        return false;  // Error object left on the stack
+    }
+
+    uint32_t compileUs = micros() - start;
+
+    // Keep a bytecode copy for the next context; this one uses the compiled function
+    duk_dup_top(ctx);
+    duk_dump_function(ctx);
+    duk_size_t bytecodeSize = 0;
+    void* bytecode = duk_get_buffer_data(ctx, -1, &bytecodeSize);
+    _store(path, bytecode, bytecodeSize);
+    duk_pop(ctx);
+
+    DOKI_LOGI(JS_ENGINE, "Compiled module %s (%u B source -> %u B bytecode, %u us)",
+              path.c_str(), (unsigned)size, (unsigned)bytecodeSize, (unsigned)compileUs);
+    return true;
+}
+
+void JSModuleCache::_store(const String& path, const void* bytecode, size_t size) {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+
+    // Another display may have compiled it in the meantime
+    if (_find(path)) {
+        xSemaphoreGive(_mutex);
+        return;
+    }
+
+    if (_moduleCount >= JS_MODULE_CACHE_ENTRIES || _bytes + size > JS_MODULE_CACHE_MAX_BYTES) {
+        xSemaphoreGive(_mutex);
+        DOKI_LOGW(JS_ENGINE, "Module cache full, %s will be compiled per app", path.c_str());
+        return;
+    }
+
+    uint8_t* copy = (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    if (!copy) {
+        xSemaphoreGive(_mutex);
+        DOKI_LOGW(JS_ENGINE, "No PSRAM for module bytecode: %s", path.c_str());
+        return;
+    }
+    memcpy(copy, bytecode, size);
+
+    Module& module = _modules[_moduleCount];
+    module.path = path;
+    module.bytecode = copy;
+    module.size = size;
+    _bytes += size;
+    _moduleCount++;
+
+    xSemaphoreGive(_mutex);
+}
+
+} // namespace Doki
+
+#endif // ENABLE_JAVASCRIPT_SUPPORT
@@ -0,0 +1,185 @@
+/**
+ * @file js_profiler.cpp
+ * @brief Implementation of the JS binding / callback profiler
+ */
+
+#include "doki/js_profiler.h"
+
+#if defined(DOKI_JS_PROFILER) && defined(ENABLE_JAVASCRIPT_SUPPORT)
+
+#include "doki/logger.h"
+#include <algorithm>
+
+namespace Doki {
+
+static const char* const CALL_NAMES[JSProfiler::CALL_COUNT] = {
+    "onCreate", "onStart", "onUpdate", "onPause", "onDestroy", "onSaveState", "onRestoreState",
+    "script", "timers", "frame", "messages"
+};
+
+static_assert(JSProfiler::CALL_SCRIPT == 7, "CALL_NAMES must list every JSLifecycle value first");
+
+// ========================================
+// Static Member Initialization
+// ========================================
+
+JSProfiler::Binding JSProfiler::_bindings[JS_PROFILER_MAX_BINDINGS];
+volatile uint16_t JSProfiler::_bindingCount = 0;
+JSProfiler::Slot JSProfiler::_slots[DISPLAY_COUNT];
+SemaphoreHandle_t JSProfiler::_mutex = nullptr;
+
+// ========================================
+// Public Methods
+// ========================================
+
+bool JSProfiler::init() {
+    if (_mutex) {
+        return true;
+    }
+
+    _mutex = xSemaphoreCreateMutex();
+    if (!_mutex) {
+        DOKI_LOGE(JS_ENGINE, "✗ Failed to create profiler lock");
+        return false;
+    }
+
+    reset();
+    DOKI_LOGI(JS_ENGINE, "✓ JS profiler enabled (GET /api/js/profile)");
+    return true;
+}
+
+int JSProfiler::registerBinding(const char* name, duk_c_function fn) {
+    if (!_mutex) {
+        return -1;
+    }
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+
+    int index = -1;
+    for (uint16_t i = 0; i < _bindingCount; i++) {
+        if (_bindings[i].fn == fn && strcmp(_bindings[i].name, name) == 0) {
+            index = i;
+            break;
+        }
+    }
+
+    if (index < 0 && _bindingCount < JS_PROFILER_MAX_BINDINGS) {
+        index = _bindingCount;
+        _bindings[index].name = name;
+        _bindings[index].fn = fn;
+        _bindingCount = index + 1;
+    }
+
+    xSemaphoreGive(_mutex);
+
+    if (index < 0) {
+        DOKI_LOGW(JS_ENGINE, "Profiler binding table full, %s not profiled", name);
+    }
+    return index;
+}
+
+void JSProfiler::recordBinding(uint8_t displayId, uint16_t index, uint32_t us) {
+    if (displayId >= DISPLAY_COUNT) return;
+
+    BindingStat& stat = _slots[displayId].bindings[index];
+    stat.calls++;
+    stat.totalUs += us;
+    if (us > stat.maxUs) stat.maxUs = us;
+}
+
+void JSProfiler::recordCall(uint8_t displayId, uint8_t kind, uint32_t us) {
+    if (displayId >= DISPLAY_COUNT || kind >= CALL_COUNT) return;
+
+    CallStat& stat = _slots[displayId].calls[kind];
+    stat.samples[stat.count % JS_PROFILER_SAMPLES] = us;
+    stat.count++;
+    stat.totalUs += us;
+    if (us > stat.maxUs) stat.maxUs = us;
+}
+
+void JSProfiler::beginApp(uint8_t displayId, const char* appId) {
+    if (displayId >= DISPLAY_COUNT) return;
+
+    Slot& slot = _slots[displayId];
+    _clear(slot);
+    snprintf(slot.app, sizeof(slot.app), "%s", appId ? appId : "");
+}
+
+void JSProfiler::reset() {
+    for (Slot& slot : _slots) {
+        _clear(slot);
+    }
+}
+
+void JSProfiler::toJson(JsonObject out) {
+    JsonArray displays = out["displays"].to<JsonArray>();
+    uint16_t bindingCount = _bindingCount;
+
+    for (uint8_t d = 0; d < DISPLAY_COUNT; d++) {
+        const Slot& slot = _slots[d];
+
+        JsonObject display = displays.add<JsonObject>();
+        display["id"] = d;
+        display["app"] = slot.app;
+
+        // Most expensive bindings first
+        uint16_t order[JS_PROFILER_MAX_BINDINGS];
+        uint16_t used = 0;
+        for (uint16_t i = 0; i < bindingCount; i++) {
+            if (slot.bindings[i].calls > 0) order[used++] = i;
+        }
+        std::sort(order, order + used, [&slot](uint16_t a, uint16_t b) {
+            return slot.bindings[a].totalUs > slot.bindings[b].totalUs;
+        });
+
+        JsonArray bindings = display["bindings"].to<JsonArray>();
+        for (uint16_t i = 0; i < used; i++) {
+            const BindingStat& stat = slot.bindings[order[i]];
+            JsonObject binding = bindings.add<JsonObject>();
+            binding["name"] = _bindings[order[i]].name;
+            binding["calls"] = stat.calls;
+            binding["totalUs"] = stat.totalUs;
+            binding["avgUs"] = (uint32_t)(stat.totalUs / stat.calls);
+            binding["maxUs"] = stat.maxUs;
+        }
+
+        JsonObject calls = display["calls"].to<JsonObject>();
+        for (uint8_t k = 0; k < CALL_COUNT; k++) {
+            const CallStat& stat = slot.calls[k];
+            if (stat.count == 0) continue;
+
+            JsonObject call = calls[CALL_NAMES[k]].to<JsonObject>();
+            call["count"] = stat.count;
+            call["totalUs"] = stat.totalUs;
+            call["p50Us"] = _percentile(stat, 50);
+            call["p99Us"] = _percentile(stat, 99);
+            call["maxUs"] = stat.maxUs;
+        }
+    }
+}
+
+// ========================================
+// Private Methods
+// ========================================
+
+void JSProfiler::_clear(Slot& slot) {
+    memset(slot.bindings, 0, sizeof(slot.bindings));
+    memset(slot.calls, 0, sizeof(slot.calls));
+}
+
+uint32_t JSProfiler::_percentile(const CallStat& stat, uint8_t percent) {
+    uint32_t n = stat.count < JS_PROFILER_SAMPLES ? stat.count : JS_PROFILER_SAMPLES;
+    if (n == 0) return 0;
+
+    uint32_t sorted[JS_PROFILER_SAMPLES];
+    memcpy(sorted, stat.samples, n * sizeof(uint32_t));
+    std::sort(sorted, sorted + n);
+
+    // Nearest rank over the recent samples
+    uint32_t rank = (n * percent + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+} // namespace Doki
+
+#endif // DOKI_JS_PROFILER && ENABLE_JAVASCRIPT_SUPPORT
@@ -0,0 +1,375 @@
+/**
+ * @file js_ui_template.cpp
+ * @brief Implementation of createUI() template compilation and instantiation
+ */
+
+#include "doki/js_ui_template.h"
+
+#ifdef ENABLE_JAVASCRIPT_SUPPORT
+
+#include "doki/filesystem_manager.h"
+#include "doki/logger.h"
+#include <esp_heap_caps.h>
+
+namespace Doki {
+
+static const char* TEMPLATE_DIR = "/ui/";
+
+// ========================================
+// Static Member Initialization
+// ========================================
+
+JSUITemplate::Entry JSUITemplate::_entries[JS_UI_TEMPLATE_CACHE_ENTRIES];
+uint32_t JSUITemplate::_entryCount = 0;
+SemaphoreHandle_t JSUITemplate::_mutex = nullptr;
+uint32_t JSUITemplate::_hits = 0;
+uint32_t JSUITemplate::_misses = 0;
+
+// ========================================
+// Property Decoding
+// ========================================
+
+// Number, "#RRGGBB" or "0xRRGGBB"; -1 if absent or unparsable
+static int32_t _parseColor(JsonVariantConst value) {
+    if (value.is<uint32_t>()) {
+        return (int32_t)(value.as<uint32_t>() & 0xFFFFFF);
+    }
+
+    const char* text = value.as<const char*>();
+    if (!text) return -1;
+
+    if (text[0] == '#') text++;
+    else if (text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) text += 2;
+
+    char* end = nullptr;
+    unsigned long color = strtoul(text, &end, 16);
+    return (end != text && *end == '\0') ? (int32_t)(color & 0xFFFFFF) : -1;
+}
+
+static int8_t _parseAlign(JsonVariantConst value) {
+    if (value.is<int>()) {
+        int align = value.as<int>();
+        return (align >= 0 && align <= 2) ? (int8_t)align : -1;
+    }
+
+    const char* text = value.as<const char*>();
+    if (!text) return -1;
+    if (strcmp(text, "left") == 0) return 0;
+    if (strcmp(text, "center") == 0) return 1;
+    if (strcmp(text, "right") == 0) return 2;
+    return -1;
+}
+
+static int16_t _parseCoord(JsonVariantConst value, int16_t fallback) {
+    return value.is<int>() ? (int16_t)value.as<int>() : fallback;
+}
+
+// Append a NUL-terminated string to the pool
+static bool _addString(std::vector<char>& pool, const char* text, uint16_t& offset) {
+    size_t length = strlen(text) + 1;
+    if (pool.size() + length >= JSUITemplate::NO_STRING) {
+        return false;
+    }
+
+    offset = (uint16_t)pool.size();
+    pool.insert(pool.end(), text, text + length);
+    return true;
+}
+
+// ========================================
+// Public Methods
+// ========================================
+
+bool JSUITemplate::init() {
+    if (_mutex) {
+        return true;
+    }
+
+    _mutex = xSemaphoreCreateMutex();
+    if (!_mutex) {
+        DOKI_LOGE(JS_ENGINE, "✗ Failed to create UI template cache lock");
+        return false;
+    }
+
+    return true;
+}
+
+bool JSUITemplate::compile(JsonVariantConst root, Compiled& out, const char*& error) {
+    out.nodes.clear();
+    out.strings.clear();
+    out.screenBg = -1;
+
+    JsonArrayConst children;
+    if (root.is<JsonArrayConst>()) {
+        children = root.as<JsonArrayConst>();
+    } else if (root.is<JsonObjectConst>()) {
+        out.screenBg = _parseColor(root["bg"]);
+        children = root["children"].as<JsonArrayConst>();
+    } else {
+        error = "template must be an object or an array";
+        return false;
+    }
+
+    for (JsonVariantConst child : children) {
+        if (!_compileNode(child, NO_PARENT, 1, out, error)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool JSUITemplate::load(const char* path, Compiled& scratch, Template& out, const char*& error) {
+    String candidate = path;
+    if (!candidate.startsWith("/")) {
+        candidate = TEMPLATE_DIR + candidate;
+    }
+    if (!candidate.endsWith(".json")) {
+        candidate += ".json";
+    }
+
+    if (!candidate.startsWith(TEMPLATE_DIR) || candidate.indexOf("..") >= 0) {
+        error = "templates must live under /ui";
+        return false;
+    }
+
+    if (_mutex) {
+        xSemaphoreTake(_mutex, portMAX_DELAY);
+        const Entry* entry = _find(candidate);
+        if (entry) {
+            out = entry->tmpl;
+        }
+        xSemaphoreGive(_mutex);
+
+        if (entry) {
+            _hits++;
+            return true;
+        }
+    }
+
+    _misses++;
+
+    uint8_t* data = nullptr;
+    size_t size = 0;
+    if (!FilesystemManager::readFile(candidate, &data, size) || !data) {
+        error = "template file not found";
+        return false;
+    }
+
+    uint32_t start = micros();
+
+    JsonDocument doc;
+    DeserializationError parseError = deserializeJson(doc, (const char*)data, size);
+    delete[] data;
+
+    if (parseError) {
+        DOKI_LOGE(JS_ENGINE, "UI template %s: %s", candidate.c_str(), parseError.c_str());
+        error = "template is not valid JSON";
+        return false;
+    }
+
+    if (!compile(doc.as<JsonVariantConst>(), scratch, error)) {
+        return false;
+    }
+
+    uint32_t compileUs = micros() - start;
+
+    if (!_store(candidate, scratch, out)) {
+        out = scratch.view();
+    }
+
+    DOKI_LOGI(JS_ENGINE, "Compiled UI template %s (%u nodes, %u us)",
+              candidate.c_str(), (unsigned)scratch.nodes.size(), (unsigned)compileUs);
+    return true;
+}
+
+uint16_t JSUITemplate::instantiate(const Template& tmpl, lv_obj_t* screen,
+                                   JSHandleTable& handles, uint32_t* out) {
+    lv_obj_t* objects[JS_UI_TEMPLATE_MAX_NODES];
+
+    if (tmpl.screenBg >= 0) {
+        lv_obj_set_style_bg_color(screen, lv_color_hex(tmpl.screenBg), 0);
+    }
+
+    for (uint16_t i = 0; i < tmpl.count; i++) {
+        const Node& node = tmpl.nodes[i];
+        lv_obj_t* parent = node.parent == NO_PARENT ? screen : objects[node.parent];
+        lv_obj_t* obj;
+
+        if (node.type == NODE_CONTAINER) {
+            obj = lv_obj_create(parent);
+            lv_obj_set_style_border_width(obj, 0, 0);
+            lv_obj_set_style_pad_all(obj, 0, 0);
+            lv_obj_clear_flag(obj, LV_OBJ_FLAG_SCROLLABLE);
+
+            if (node.w >= 0 && node.h >= 0) lv_obj_set_size(obj, node.w, node.h);
+            if (node.bg >= 0) lv_obj_set_style_bg_color(obj, lv_color_hex(node.bg), 0);
+            if (node.radius >= 0) lv_obj_set_style_radius(obj, node.radius, 0);
+        } else {
+            obj = lv_label_create(parent);
+            lv_label_set_text(obj, node.text != NO_STRING ? tmpl.strings + node.text : "");
+
+            if (node.w >= 0) lv_obj_set_width(obj, node.w);
+            if (node.scroll) lv_label_set_long_mode(obj, LV_LABEL_LONG_SCROLL_CIRCULAR);
+        }
+
+        lv_obj_set_pos(obj, node.x, node.y);
+
+        if (node.color >= 0) lv_obj_set_style_text_color(obj, lv_color_hex(node.color), 0);
+        if (node.font > 0) lv_obj_set_style_text_font(obj, fontForSize(node.font), 0);
+        if (node.opacity >= 0) lv_obj_set_style_opa(obj, node.opacity, 0);
+        if (node.align >= 0) {
+            static const lv_text_align_t ALIGNS[] = {
+                LV_TEXT_ALIGN_LEFT, LV_TEXT_ALIGN_CENTER, LV_TEXT_ALIGN_RIGHT
+            };
+            lv_obj_set_style_text_align(obj, ALIGNS[node.align], 0);
+        }
+
+        objects[i] = obj;
+        out[i] = node.id != NO_STRING ? handles.add(obj) : JSHandleTable::INVALID_HANDLE;
+    }
+
+    return tmpl.count;
+}
+
+const lv_font_t* JSUITemplate::fontForSize(int size) {
+    if (size == 12) return &lv_font_montserrat_12;
+    if (size == 16) return &lv_font_montserrat_16;
+    if (size == 20) return &lv_font_montserrat_20;
+    if (size == 24) return &lv_font_montserrat_24;
+    return &lv_font_montserrat_14;  // default
+}
+
+// ========================================
+// Private Methods
+// ========================================
+
+const JSUITemplate::Entry* JSUITemplate::_find(const String& path) {
+    for (uint32_t i = 0; i < _entryCount; i++) {
+        if (_entries[i].path == path) {
+            return &_entries[i];
+        }
+    }
+    return nullptr;
+}
+
+bool JSUITemplate::_compileNode(JsonVariantConst node, int16_t parent, uint8_t depth,
+                                Compiled& out, const char*& error) {
+    if (!node.is<JsonObjectConst>()) {
+        error = "every node must be an object";
+        return false;
+    }
+    if (depth > JS_JSON_MAX_DEPTH) {
+        error = "template nested too deeply";
+        return false;
+    }
+    if (out.nodes.size() >= JS_UI_TEMPLATE_MAX_NODES) {
+        error = "too many nodes in template";
+        return false;
+    }
+
+    Node n;
+    const char* type = node["type"].as<const char*>();
+    if (!type || strcmp(type, "label") == 0) {
+        n.type = NODE_LABEL;
+    } else if (strcmp(type, "container") == 0) {
+        n.type = NODE_CONTAINER;
+    } else {
+        error = "unknown node type";
+        return false;
+    }
+
+    n.font = node["font"].is<int>() ? (uint8_t)node["font"].as<int>() : 0;
+    n.align = _parseAlign(node["align"]);
+    n.opacity = -1;
+    if (node["opacity"].is<int>()) {
+        int opacity = node["opacity"].as<int>();
+        n.opacity = opacity < 0 ? 0 : (opacity > 255 ? 255 : opacity);
+    }
+    n.scroll = node["scroll"].as<bool>();
+    n.parent = parent;
+    n.x = _parseCoord(node["x"], 0);
+    n.y = _parseCoord(node["y"], 0);
+    n.w = _parseCoord(node["w"], -1);
+    n.h = _parseCoord(node["h"], -1);
+    n.radius = _parseCoord(node["radius"], -1);
+    n.color = _parseColor(node["color"]);
+    n.bg = _parseColor(node["bg"]);
+    n.text = NO_STRING;
+    n.id = NO_STRING;
+
+    const char* text = node["text"];
+    const char* id = node["id"];
+    if ((text && !_addString(out.strings, text, n.text)) ||
+        (id && !_addString(out.strings, id, n.id))) {
+        error = "template strings too large";
+        return false;
+    }
+
+    int16_t index = (int16_t)out.nodes.size();
+    out.nodes.push_back(n);
+
+    JsonArrayConst children = node["children"].as<JsonArrayConst>();
+    if (!children.isNull() && n.type != NODE_CONTAINER) {
+        error = "only containers can have children";
+        return false;
+    }
+
+    for (JsonVariantConst child : children) {
+        if (!_compileNode(child, index, depth + 1, out, error)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool JSUITemplate::_store(const String& path, const Compiled& compiled, Template& out) {
+    if (!_mutex) {
+        return false;
+    }
+
+    size_t nodeBytes = compiled.nodes.size() * sizeof(Node);
+    size_t size = nodeBytes + compiled.strings.size();
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+
+    // Another display may have compiled it in the meantime
+    const Entry* existing = _find(path);
+    if (existing) {
+        out = existing->tmpl;
+        xSemaphoreGive(_mutex);
+        return true;
+    }
+
+    if (_entryCount >= JS_UI_TEMPLATE_CACHE_ENTRIES) {
+        xSemaphoreGive(_mutex);
+        DOKI_LOGW(JS_ENGINE, "UI template cache full, %s will be parsed per app", path.c_str());
+        return false;
+    }
+
+    uint8_t* block = (uint8_t*)heap_caps_malloc(size > 0 ? size : 1, MALLOC_CAP_SPIRAM);
+    if (!block) {
+        xSemaphoreGive(_mutex);
+        DOKI_LOGW(JS_ENGINE, "No PSRAM for UI template: %s", path.c_str());
+        return false;
+    }
+    memcpy(block, compiled.nodes.data(), nodeBytes);
+    memcpy(block + nodeBytes, compiled.strings.data(), compiled.strings.size());
+
+    Entry& entry = _entries[_entryCount];
+    entry.path = path;
+    entry.tmpl.nodes = (const Node*)block;
+    entry.tmpl.count = (uint16_t)compiled.nodes.size();
+    entry.tmpl.screenBg = compiled.screenBg;
+    entry.tmpl.strings = (const char*)(block + nodeBytes);
+    out = entry.tmpl;
+    _entryCount++;
+
+    xSemaphoreGive(_mutex);
+    return true;
+}
+
+} // namespace Doki
+
+#endif // ENABLE_JAVASCRIPT_SUPPORT
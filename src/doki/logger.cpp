@@ -0,0 +1,268 @@
+/**
+ * @file logger.cpp
+ * @brief Implementation of the structured logger
+ */
+
+#include "doki/logger.h"
+#include "hardware_config.h"
+#include "timing_constants.h"
+#include <esp_heap_caps.h>
+#include <stdarg.h>
+
+namespace Doki {
+
+// ========================================
+// Static Member Initialization
+// ========================================
+
+Logger::Cell* Logger::_cells = nullptr;
+std::atomic<uint32_t> Logger::_enqueuePos(0);
+uint32_t Logger::_dequeuePos = 0;
+std::atomic<uint32_t> Logger::_dropped(0);
+
+uint8_t Logger::_levels[(uint8_t)LogModule::COUNT] = {
+    DOKI_LOG_LEVEL_CORE,
+    DOKI_LOG_LEVEL_APP,
+    DOKI_LOG_LEVEL_JS_ENGINE,
+    DOKI_LOG_LEVEL_JS,
+    DOKI_LOG_LEVEL_EVENT,
+    DOKI_LOG_LEVEL_HTTP,
+    DOKI_LOG_LEVEL_STATE,
+    DOKI_LOG_LEVEL_MQTT,
+    DOKI_LOG_LEVEL_WEBSOCKET,
+    DOKI_LOG_LEVEL_ANIMATION
+};
+
+LogRecord* Logger::_history = nullptr;
+uint32_t Logger::_historyCount = 0;
+SemaphoreHandle_t Logger::_historyMutex = nullptr;
+TaskHandle_t Logger::_drainTask = nullptr;
+
+// ========================================
+// Public Methods
+// ========================================
+
+bool Logger::init() {
+    if (_cells) {
+        return true;
+    }
+
+    // Ring cells hold atomics, keep them in internal RAM
+    _cells = (Cell*)heap_caps_malloc(sizeof(Cell) * RING_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+
+    // History is only touched by memcpy, so PSRAM is fine
+    _history = (LogRecord*)heap_caps_malloc(sizeof(LogRecord) * HISTORY_SIZE, MALLOC_CAP_SPIRAM);
+    if (!_history) {
+        _history = (LogRecord*)malloc(sizeof(LogRecord) * HISTORY_SIZE);
+    }
+
+    _historyMutex = xSemaphoreCreateMutex();
+
+    if (!_cells || !_history || !_historyMutex) {
+        Serial.println("[Logger] ✗ Failed to allocate log buffers");
+        _freeBuffers();
+        return false;
+    }
+
+    for (uint32_t i = 0; i < RING_SIZE; i++) {
+        new (&_cells[i].sequence) std::atomic<uint32_t>(i);
+    }
+
+    BaseType_t created = xTaskCreatePinnedToCore(
+        _drainTaskEntry,
+        "Logger_Drain",
+        TASK_STACK_LOGGER,
+        nullptr,
+        TASK_PRIORITY_LOGGER,
+        &_drainTask,
+        TASK_CORE_LOGGER
+    );
+    if (created != pdPASS) {
+        // Nothing would empty the ring: keep writing straight through
+        Serial.println("[Logger] ✗ Failed to start drain task, logging synchronously");
+        _drainTask = nullptr;
+        _freeBuffers();
+        return false;
+    }
+
+    Serial.printf("[Logger] ✓ Initialized (%u slots, %u history)\n",
+                  (unsigned)RING_SIZE, (unsigned)HISTORY_SIZE);
+    return true;
+}
+
+void Logger::setLevel(LogModule module, uint8_t level) {
+    if (module >= LogModule::COUNT) return;
+
+    static const uint8_t compiled[(uint8_t)LogModule::COUNT] = {
+        DOKI_LOG_LEVEL_CORE, DOKI_LOG_LEVEL_APP, DOKI_LOG_LEVEL_JS_ENGINE,
+        DOKI_LOG_LEVEL_JS, DOKI_LOG_LEVEL_EVENT, DOKI_LOG_LEVEL_HTTP,
+        DOKI_LOG_LEVEL_STATE, DOKI_LOG_LEVEL_MQTT, DOKI_LOG_LEVEL_WEBSOCKET,
+        DOKI_LOG_LEVEL_ANIMATION
+    };
+
+    uint8_t maxLevel = compiled[(uint8_t)module];
+    _levels[(uint8_t)module] = level > maxLevel ? maxLevel : level;
+}
+
+void Logger::write(LogModule module, uint8_t level, const char* fmt, ...) {
+    va_list args;
+
+    // Before init(): no ring yet, write straight through
+    if (!_cells) {
+        char line[LogRecord::TEXT_SIZE];
+        va_start(args, fmt);
+        vsnprintf(line, sizeof(line), fmt, args);
+        va_end(args);
+        Serial.printf("[%s] %s\n", getModuleName(module), line);
+        return;
+    }
+
+    // Claim a slot
+    Cell* cell;
+    uint32_t pos = _enqueuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        cell = &_cells[pos & RING_MASK];
+        uint32_t seq = cell->sequence.load(std::memory_order_acquire);
+        int32_t diff = (int32_t)seq - (int32_t)pos;
+
+        if (diff == 0) {
+            if (_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Ring full - drop rather than block the caller
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = _enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    // Format directly into the claimed slot
+    LogRecord& rec = cell->record;
+    rec.seq = pos;
+    rec.timestamp = millis();
+    rec.level = level;
+    rec.module = (uint8_t)module;
+
+    va_start(args, fmt);
+    int n = vsnprintf(rec.text, sizeof(rec.text), fmt, args);
+    va_end(args);
+
+    if (n < 0) n = 0;
+    rec.length = (n < (int)sizeof(rec.text)) ? n : sizeof(rec.text) - 1;
+
+    // Publish to the drain task
+    cell->sequence.store(pos + 1, std::memory_order_release);
+}
+
+void Logger::getHistory(uint32_t sinceSeq, std::vector<LogRecord>& out, size_t maxRecords) {
+    if (!_history || !_historyMutex) return;
+
+    xSemaphoreTake(_historyMutex, portMAX_DELAY);
+
+    uint32_t available = _historyCount < HISTORY_SIZE ? _historyCount : HISTORY_SIZE;
+    uint32_t first = _historyCount - available;
+
+    for (uint32_t i = first; i < _historyCount && out.size() < maxRecords; i++) {
+        const LogRecord& rec = _history[i % HISTORY_SIZE];
+        if (rec.seq >= sinceSeq) {
+            out.push_back(rec);
+        }
+    }
+
+    xSemaphoreGive(_historyMutex);
+}
+
+const char* Logger::getModuleName(LogModule module) {
+    switch (module) {
+        case LogModule::CORE:       return "Main";
+        case LogModule::APP:        return "AppManager";
+        case LogModule::JS_ENGINE:  return "JSEngine";
+        case LogModule::JS:         return "JS";
+        case LogModule::EVENT:      return "EventSystem";
+        case LogModule::HTTP:       return "SimpleHTTP";
+        case LogModule::STATE:      return "StatePersistence";
+        case LogModule::MQTT:       return "MQTT";
+        case LogModule::WEBSOCKET:  return "WebSocket";
+        case LogModule::ANIMATION:  return "Animation";
+        default:                    return "Unknown";
+    }
+}
+
+const char* Logger::getLevelName(uint8_t level) {
+    switch (level) {
+        case DOKI_LOG_ERROR:    return "ERROR";
+        case DOKI_LOG_WARN:     return "WARN";
+        case DOKI_LOG_INFO:     return "INFO";
+        case DOKI_LOG_DEBUG:    return "DEBUG";
+        case DOKI_LOG_VERBOSE:  return "VERBOSE";
+        default:                return "NONE";
+    }
+}
+
+// ========================================
+// Private Helper Methods
+// ========================================
+
+void Logger::_freeBuffers() {
+    // write() falls back to Serial while _cells is null
+    free(_cells);
+    free(_history);
+    if (_historyMutex) vSemaphoreDelete(_historyMutex);
+    _cells = nullptr;
+    _history = nullptr;
+    _historyMutex = nullptr;
+}
+
+bool Logger::_pop(LogRecord& out) {
+    Cell* cell = &_cells[_dequeuePos & RING_MASK];
+    uint32_t seq = cell->sequence.load(std::memory_order_acquire);
+
+    if ((int32_t)seq - (int32_t)(_dequeuePos + 1) < 0) {
+        return false;  // Empty (or producer still formatting)
+    }
+
+    memcpy(&out, &cell->record, sizeof(LogRecord));
+    cell->sequence.store(_dequeuePos + RING_SIZE, std::memory_order_release);
+    _dequeuePos++;
+    return true;
+}
+
+void Logger::_print(const LogRecord& record) {
+    // Same "[Module] message" shape the rest of the firmware prints
+    Serial.printf("[%s] %s\n", getModuleName((LogModule)record.module), record.text);
+}
+
+void Logger::_drainTaskEntry(void* param) {
+    LogRecord rec;
+    uint32_t reportedDrops = 0;
+
+    while (true) {
+        bool drained = false;
+
+        while (_pop(rec)) {
+            drained = true;
+
+            // Serial may block at 115200 baud - fine on this task
+            _print(rec);
+
+            xSemaphoreTake(_historyMutex, portMAX_DELAY);
+            memcpy(&_history[_historyCount % HISTORY_SIZE], &rec, sizeof(LogRecord));
+            _historyCount++;
+            xSemaphoreGive(_historyMutex);
+        }
+
+        uint32_t drops = _dropped.load(std::memory_order_relaxed);
+        if (drops != reportedDrops) {
+            Serial.printf("[Logger] Warning: %u log records dropped\n", (unsigned)(drops - reportedDrops));
+            reportedDrops = drops;
+        }
+
+        if (!drained) {
+            vTaskDelay(pdMS_TO_TICKS(UPDATE_INTERVAL_LOG_DRAIN_MS));
+        }
+    }
+}
+
+} // namespace Doki
@@ -4,12 +4,21 @@
  */
 
 #include "doki/lvgl_manager.h"
+#include "doki/tracer.h"
+#include <lvgl.h>
+#include "timing_constants.h"
 
 namespace Doki {
 
 // Static member initialization
 SemaphoreHandle_t LVGLManager::_mutex = nullptr;
 bool LVGLManager::_initialized = false;
+volatile TaskHandle_t LVGLManager::_owner = nullptr;
+uint32_t LVGLManager::_depth = 0;
+uint8_t LVGLManager::_holdScope = LVGLManager::SCOPE_SYSTEM;
+uint32_t LVGLManager::_holdStart = 0;
+LVGLManager::ScopeStats LVGLManager::_stats[LVGLManager::SCOPE_COUNT];
+TaskHandle_t LVGLManager::_renderTask = nullptr;
 
 bool LVGLManager::init() {
     if (_initialized) {
@@ -27,20 +36,35 @@ bool LVGLManager::init() {
         return false;
     }
 
+    memset(_stats, 0, sizeof(_stats));
+
     _initialized = true;
     Serial.println("[LVGLManager] ✓ LVGL recursive mutex initialized");
 
     return true;
 }
 
-void LVGLManager::lock() {
+void LVGLManager::lock(uint8_t scope) {
     if (!_initialized || _mutex == nullptr) {
         Serial.println("[LVGLManager] Warning: Mutex not initialized, skipping lock");
         return;
     }
 
-    // Wait indefinitely for recursive mutex
-    xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+    // Nested acquisition: the outermost one is what gets measured
+    if (_owner == xTaskGetCurrentTaskHandle()) {
+        xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+        _depth++;
+        return;
+    }
+
+    // Try without blocking first so contention can be counted
+    uint32_t start = micros();
+    bool contended = xSemaphoreTakeRecursive(_mutex, 0) != pdTRUE;
+    if (contended) {
+        xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+    }
+
+    _acquired(scope, contended, contended ? micros() - start : 0);
 }
 
 void LVGLManager::unlock() {
@@ -49,20 +73,209 @@ void LVGLManager::unlock() {
     }
 
     // Release recursive mutex
-    xSemaphoreGiveRecursive(_mutex);
+    _release(1);
 }
 
-bool LVGLManager::tryLock(uint32_t timeoutMs) {
+bool LVGLManager::tryLock(uint32_t timeoutMs, uint8_t scope) {
     if (!_initialized || _mutex == nullptr) {
         Serial.println("[LVGLManager] Warning: Mutex not initialized");
         return false;
     }
 
-    // Convert ms to ticks
-    TickType_t ticks = pdMS_TO_TICKS(timeoutMs);
+    if (_owner == xTaskGetCurrentTaskHandle()) {
+        xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+        _depth++;
+        return true;
+    }
+
+    uint32_t start = micros();
+    bool contended = xSemaphoreTakeRecursive(_mutex, 0) != pdTRUE;
+    if (contended) {
+        // Convert ms to ticks
+        TickType_t ticks = pdMS_TO_TICKS(timeoutMs);
+
+        // Try to acquire recursive mutex with timeout
+        if (xSemaphoreTakeRecursive(_mutex, ticks) != pdTRUE) {
+            return false;
+        }
+    }
+
+    _acquired(scope, contended, contended ? micros() - start : 0);
+    return true;
+}
+
+bool LVGLManager::startRenderTask() {
+    if (_renderTask) {
+        return true;
+    }
+
+    BaseType_t result = xTaskCreatePinnedToCore(
+        _renderTaskFunc,
+        "lvgl_render",
+        TASK_STACK_DISPLAY,
+        nullptr,
+        TASK_PRIORITY_DISPLAY,
+        &_renderTask,
+        TASK_CORE_DISPLAY
+    );
+
+    if (result != pdPASS) {
+        Serial.println("[LVGLManager] ✗ Failed to start render task");
+        _renderTask = nullptr;
+        return false;
+    }
+
+    Serial.printf("[LVGLManager] ✓ Render task started on core %d\n", TASK_CORE_DISPLAY);
+    return true;
+}
+
+// ========================================
+// Lock Statistics
+// ========================================
+
+void LVGLManager::toJson(JsonObject out) {
+    if (!_initialized) return;
+
+    // Copy under the mutex itself, without counting this acquisition
+    ScopeStats stats[SCOPE_COUNT];
+    xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+    memcpy(stats, _stats, sizeof(stats));
+    xSemaphoreGiveRecursive(_mutex);
+
+    out["slowHoldMs"] = LVGL_LOCK_SLOW_HOLD_MS;
+    JsonObject scopes = out["scopes"].to<JsonObject>();
+
+    for (uint8_t s = 0; s < SCOPE_COUNT; s++) {
+        const ScopeStats& stat = stats[s];
+        if (stat.acquisitions == 0) continue;
+
+        char name[12];
+        if (s == SCOPE_RENDER) {
+            snprintf(name, sizeof(name), "render");
+        } else if (s == SCOPE_SYSTEM) {
+            snprintf(name, sizeof(name), "system");
+        } else {
+            snprintf(name, sizeof(name), "display%u", s);
+        }
+
+        JsonObject scope = scopes[name].to<JsonObject>();
+        scope["acquisitions"] = stat.acquisitions;
+        scope["contended"] = stat.contended;
+        scope["waitAvgUs"] = stat.contended ? (uint32_t)(stat.waitTotalUs / stat.contended) : 0;
+        scope["waitMaxUs"] = stat.waitMaxUs;
+        scope["holdAvgUs"] = (uint32_t)(stat.holdTotalUs / stat.acquisitions);
+        scope["holdMaxUs"] = stat.holdMaxUs;
+        scope["slowHolds"] = stat.slowHolds;
+    }
+}
+
+void LVGLManager::resetStats() {
+    if (!_initialized) return;
+
+    xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+    memset(_stats, 0, sizeof(_stats));
+    xSemaphoreGiveRecursive(_mutex);
+}
+
+// ========================================
+// Unlocked Guard
+// ========================================
 
-    // Try to acquire recursive mutex with timeout
-    return xSemaphoreTakeRecursive(_mutex, ticks) == pdTRUE;
+LVGLManager::Unlocked::Unlocked() : _depth(0), _scope(SCOPE_SYSTEM) {
+    if (!_initialized || _owner != xTaskGetCurrentTaskHandle()) {
+        return;
+    }
+
+    _depth = LVGLManager::_depth;
+    _scope = _holdScope;
+    _release(_depth);
+}
+
+LVGLManager::Unlocked::~Unlocked() {
+    for (uint32_t i = 0; i < _depth; i++) {
+        lock(_scope);
+    }
+}
+
+// ========================================
+// Private Methods
+// ========================================
+
+void LVGLManager::_acquired(uint8_t scope, bool contended, uint32_t waitUs) {
+    if (scope >= SCOPE_COUNT) {
+        scope = SCOPE_SYSTEM;
+    }
+
+    _owner = xTaskGetCurrentTaskHandle();
+    _depth = 1;
+    _holdScope = scope;
+
+    ScopeStats& stat = _stats[scope];
+    stat.acquisitions++;
+    if (contended) {
+        stat.contended++;
+        stat.waitTotalUs += waitUs;
+        if (waitUs > stat.waitMaxUs) stat.waitMaxUs = waitUs;
+    }
+
+    _holdStart = micros();
+}
+
+void LVGLManager::_release(uint32_t depth) {
+    if (_owner != xTaskGetCurrentTaskHandle()) {
+        // Unbalanced unlock(); hand it to FreeRTOS, which rejects it
+        xSemaphoreGiveRecursive(_mutex);
+        return;
+    }
+
+    uint32_t holdUs = 0;
+    uint8_t scope = _holdScope;
+    bool last = depth >= _depth;
+
+    if (last) {
+        holdUs = micros() - _holdStart;
+
+        ScopeStats& stat = _stats[scope];
+        stat.holdTotalUs += holdUs;
+        if (holdUs > stat.holdMaxUs) stat.holdMaxUs = holdUs;
+        if (holdUs > LVGL_LOCK_SLOW_HOLD_MS * 1000UL) stat.slowHolds++;
+
+        depth = _depth;
+        _depth = 0;
+        _owner = nullptr;
+    } else {
+        _depth -= depth;
+    }
+
+    for (uint32_t i = 0; i < depth; i++) {
+        xSemaphoreGiveRecursive(_mutex);
+    }
+
+    // Report after giving the lock back, Serial is slow
+    if (last && holdUs > LVGL_LOCK_SLOW_HOLD_MS * 1000UL) {
+        Serial.printf("[LVGLManager] Warning: lock held %lu ms (scope %u)\n",
+                      (unsigned long)(holdUs / 1000), scope);
+    }
+}
+
+void LVGLManager::_renderTaskFunc(void* param) {
+    while (true) {
+        lock(SCOPE_RENDER);
+        uint32_t idle;
+        {
+            DOKI_TRACE_SCOPE("lvgl", "lv_timer_handler");
+            idle = lv_timer_handler();
+        }
+        unlock();
+
+        // Sleep until the next LVGL timer; at least one tick so the
+        // loop task gets the lock between frames
+        if (idle > LVGL_RENDER_MAX_IDLE_MS) {
+            idle = LVGL_RENDER_MAX_IDLE_MS;
+        }
+        TickType_t ticks = pdMS_TO_TICKS(idle);
+        vTaskDelay(ticks > 0 ? ticks : 1);
+    }
 }
 
 } // namespace Doki
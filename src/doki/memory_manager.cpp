@@ -44,7 +44,7 @@ bool MemoryManager::stopTracking(const char* appId) {
         Serial.printf("  PSRAM not freed: %d bytes\n", stats.psramAllocated);
         
         // Publish low memory event
-        EventSystem::publish(EventType::SYSTEM_ERROR, "MemoryManager", (void*)appId);
+        EventSystem::publish(EventType::SYSTEM_ERROR, "MemoryManager", EventPayload::fromText(appId));
     } else {
         Serial.printf("[MemoryManager] ✓ Clean shutdown: %s (no leaks)\n", appId);
     }
@@ -7,7 +7,13 @@
 #include "doki/media_service.h"
 #include "doki/media_cache.h"
 #include "doki/app_manager.h"
+#include "doki/app_profiler.h"
+#include "doki/lvgl_manager.h"
 #include "doki/filesystem_manager.h"
+#include "doki/logger.h"
+#include "doki/js_profiler.h"
+#include "doki/tracer.h"
+#include <memory>
 #include <WiFi.h>
 
 namespace Doki {
@@ -47,6 +53,25 @@ bool SimpleHttpServer::begin(uint16_t port) {
     // API: Get displays status
     _server->on("/api/status", HTTP_GET, handleGetStatus);
 
+    // API: Get recent log records
+    _server->on("/api/logs", HTTP_GET, handleGetLogs);
+
+    // API: App load/unload latency histograms (DELETE resets them)
+    _server->on("/api/perf", HTTP_GET, handleGetPerf);
+    _server->on("/api/perf", HTTP_DELETE, handleResetPerf);
+
+#if defined(DOKI_JS_PROFILER) && defined(ENABLE_JAVASCRIPT_SUPPORT)
+    // API: JS binding / callback profile (DELETE resets it)
+    _server->on("/api/js/profile", HTTP_GET, handleGetJSProfile);
+    _server->on("/api/js/profile", HTTP_DELETE, handleResetJSProfile);
+#endif
+
+#ifdef DOKI_TRACE
+    // API: Span/event timeline as Chrome trace JSON (DELETE clears it)
+    _server->on("/api/trace", HTTP_GET, handleGetTrace);
+    _server->on("/api/trace", HTTP_DELETE, handleClearTrace);
+#endif
+
     // API: Get media info
     _server->on("/api/media/info", HTTP_GET, handleMediaInfo);
 
@@ -116,6 +141,7 @@ void SimpleHttpServer::setStatusCallback(void (*callback)(uint8_t, String&, uint
 }
 
 void SimpleHttpServer::handleGetApps(AsyncWebServerRequest* request) {
+    DOKI_TRACE_SCOPE("http", "GET /api/apps");
     JsonDocument doc;
     JsonArray apps = doc["apps"].to<JsonArray>();
 
@@ -134,6 +160,7 @@ void SimpleHttpServer::handleGetApps(AsyncWebServerRequest* request) {
 }
 
 void SimpleHttpServer::handleLoadApp(AsyncWebServerRequest* request) {
+    DOKI_TRACE_SCOPE("http", "POST /api/load");
     if (!request->hasParam("display") || !request->hasParam("app")) {
         request->send(400, "application/json", "{\"error\":\"Missing display or app parameter\"}");
         return;
@@ -159,18 +186,28 @@ void SimpleHttpServer::handleLoadApp(AsyncWebServerRequest* request) {
 }
 
 void SimpleHttpServer::handleGetStatus(AsyncWebServerRequest* request) {
+    DOKI_TRACE_SCOPE("http", "GET /api/status");
     JsonDocument doc;
     JsonArray disps = doc["displays"].to<JsonArray>();
 
     uint8_t numDisplays = AppManager::getNumDisplays();
     for (uint8_t i = 0; i < numDisplays; i++) {
-        const char* appId = AppManager::getAppId(i);
-        uint32_t uptime = AppManager::getAppUptime(i) / 1000; // Convert ms to seconds
-
         JsonObject d = disps.add<JsonObject>();
         d["id"] = i;
-        d["app"] = appId;
-        d["uptime"] = uptime;
+
+        // The loop task swaps and tears down apps under this lock
+        LVGLManager::lock(i);
+
+        const char* appId = AppManager::getAppId(i);
+        d["app"] = String(appId ? appId : "");
+        d["uptime"] = AppManager::getAppUptime(i) / 1000; // Convert ms to seconds
+
+        DokiApp* app = AppManager::getApp(i);
+        if (app) {
+            app->getRuntimeStats(d["stats"].to<JsonObject>());
+        }
+
+        LVGLManager::unlock();
     }
 
     String response;
@@ -178,7 +215,99 @@ void SimpleHttpServer::handleGetStatus(AsyncWebServerRequest* request) {
     request->send(200, "application/json", response);
 }
 
+void SimpleHttpServer::handleGetLogs(AsyncWebServerRequest* request) {
+    DOKI_TRACE_SCOPE("http", "GET /api/logs");
+    uint32_t since = 0;
+    size_t limit = 64;
+
+    if (request->hasParam("since")) {
+        since = request->getParam("since")->value().toInt();
+    }
+    if (request->hasParam("limit")) {
+        long value = request->getParam("limit")->value().toInt();
+        if (value > 0 && value < 64) limit = value;
+    }
+
+    std::vector<LogRecord> records;
+    Logger::getHistory(since, records, limit);
+
+    JsonDocument doc;
+    JsonArray lines = doc["lines"].to<JsonArray>();
+
+    for (const LogRecord& rec : records) {
+        JsonObject line = lines.add<JsonObject>();
+        line["seq"] = rec.seq;
+        line["t"] = rec.timestamp;
+        line["level"] = Logger::getLevelName(rec.level);
+        line["module"] = Logger::getModuleName((LogModule)rec.module);
+        line["msg"] = rec.text;
+    }
+
+    doc["next"] = records.empty() ? since : records.back().seq + 1;
+    doc["dropped"] = Logger::getDroppedCount();
+
+    String response;
+    serializeJson(doc, response);
+    request->send(200, "application/json", response);
+}
+
+void SimpleHttpServer::handleGetPerf(AsyncWebServerRequest* request) {
+    DOKI_TRACE_SCOPE("http", "GET /api/perf");
+    JsonDocument doc;
+    AppProfiler::toJson(doc.to<JsonObject>());
+    LVGLManager::toJson(doc["lvglLock"].to<JsonObject>());
+
+    String response;
+    serializeJson(doc, response);
+    request->send(200, "application/json", response);
+}
+
+void SimpleHttpServer::handleResetPerf(AsyncWebServerRequest* request) {
+    DOKI_TRACE_SCOPE("http", "DELETE /api/perf");
+    AppProfiler::reset();
+    LVGLManager::resetStats();
+    request->send(200, "application/json", "{\"success\":true}");
+}
+
+#if defined(DOKI_JS_PROFILER) && defined(ENABLE_JAVASCRIPT_SUPPORT)
+void SimpleHttpServer::handleGetJSProfile(AsyncWebServerRequest* request) {
+    DOKI_TRACE_SCOPE("http", "GET /api/js/profile");
+    JsonDocument doc;
+    JSProfiler::toJson(doc.to<JsonObject>());
+
+    String response;
+    serializeJson(doc, response);
+    request->send(200, "application/json", response);
+}
+
+void SimpleHttpServer::handleResetJSProfile(AsyncWebServerRequest* request) {
+    DOKI_TRACE_SCOPE("http", "DELETE /api/js/profile");
+    JSProfiler::reset();
+    request->send(200, "application/json", "{\"success\":true}");
+}
+#endif
+
+#ifdef DOKI_TRACE
+void SimpleHttpServer::handleGetTrace(AsyncWebServerRequest* request) {
+    // Snapshot now, format while the response is sent: the whole
+    // document would not fit in RAM at once
+    std::shared_ptr<TraceExport> trace = std::make_shared<TraceExport>();
+    AsyncWebServerResponse* response = request->beginChunkedResponse("application/json",
+        [trace](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+            return trace->read(buffer, maxLen);
+        });
+    response->addHeader("Content-Disposition", "attachment; filename=\"doki-trace.json\"");
+    request->send(response);
+}
+
+void SimpleHttpServer::handleClearTrace(AsyncWebServerRequest* request) {
+    Tracer::clear();
+    request->send(200, "application/json", "{\"success\":true}");
+}
+#endif
+
 void SimpleHttpServer::handleMediaInfo(AsyncWebServerRequest* request) {
+    DOKI_TRACE_SCOPE("http", "GET /api/media/info");
     if (!request->hasParam("display")) {
         request->send(400, "application/json", "{\"error\":\"Missing display parameter\"}");
         return;
@@ -223,6 +352,7 @@ void SimpleHttpServer::handleMediaInfo(AsyncWebServerRequest* request) {
 }
 
 void SimpleHttpServer::handleMediaDelete(AsyncWebServerRequest* request) {
+    DOKI_TRACE_SCOPE("http", "DELETE /api/media/delete");
     if (!request->hasParam("display") || !request->hasParam("type")) {
         request->send(400, "application/json", "{\"error\":\"Missing display or type parameter\"}");
         return;
@@ -258,6 +388,7 @@ void SimpleHttpServer::handleMediaDelete(AsyncWebServerRequest* request) {
 }
 
 void SimpleHttpServer::handleUploadJS(AsyncWebServerRequest* request) {
+    DOKI_TRACE_SCOPE("http", "POST /api/upload-js");
     // Check for required parameters
     if (!request->hasParam("display", true) || !request->hasParam("code", true)) {
         request->send(400, "application/json", "{\"error\":\"Missing display or code parameter\"}");
@@ -329,6 +460,7 @@ void SimpleHttpServer::handleMediaUpload(AsyncWebServerRequest* request,
                                           uint8_t* data,
                                           size_t len,
                                           bool final) {
+    DOKI_TRACE_SCOPE("http", "POST /api/media/upload");
     // First chunk - initialize upload
     if (index == 0) {
         Serial.printf("[SimpleHTTP] Starting upload: %s\n", filename.c_str());
@@ -490,6 +622,7 @@ void SimpleHttpServer::handleAnimationUpload(AsyncWebServerRequest* request,
                                               uint8_t* data,
                                               size_t len,
                                               bool final) {
+    DOKI_TRACE_SCOPE("http", "POST /api/animations/upload");
     // First chunk - initialize upload
     if (index == 0) {
         Serial.printf("[SimpleHTTP] Starting animation upload: %s\n", filename.c_str());
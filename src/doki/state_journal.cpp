@@ -0,0 +1,337 @@
+/**
+ * @file state_journal.cpp
+ * @brief Implementation of the append-only app state store
+ */
+
+#include "doki/state_journal.h"
+#include "doki/logger.h"
+#include <esp_rom_crc.h>
+
+namespace Doki {
+
+// Static member initialization
+bool StateJournal::_ready = false;
+std::unordered_map<std::string, StateJournal::IndexEntry> StateJournal::_index;
+uint32_t StateJournal::_sequence = 1;
+uint32_t StateJournal::_fileSize = 0;
+uint32_t StateJournal::_liveBytes = 0;
+
+static uint32_t crcOf(uint32_t crc, const void* data, size_t size) {
+    return esp_rom_crc32_le(crc, (const uint8_t*)data, size);
+}
+
+// ========================================
+// Public Methods
+// ========================================
+
+bool StateJournal::init() {
+    if (_ready) {
+        return true;
+    }
+
+    if (!FilesystemManager::isMounted()) {
+        DOKI_LOGE(STATE, "Filesystem not mounted");
+        return false;
+    }
+
+    // Interrupted compaction: the copy is complete only if the old
+    // journal was already removed (see compact())
+    if (DOKI_FS.exists(COMPACT_PATH)) {
+        if (DOKI_FS.exists(JOURNAL_PATH)) {
+            DOKI_FS.remove(COMPACT_PATH);
+        } else {
+            DOKI_FS.rename(COMPACT_PATH, JOURNAL_PATH);
+        }
+    }
+
+    uint32_t validBytes = 0;
+    uint32_t start = millis();
+    if (!_replay(validBytes)) {
+        DOKI_LOGE(STATE, "Failed to read journal");
+        return false;
+    }
+
+    _ready = true;
+
+    if (validBytes < _fileSize) {
+        DOKI_LOGW(STATE, "Dropping %lu damaged bytes at the end of the journal",
+                      (unsigned long)(_fileSize - validBytes));
+        compact();
+    } else {
+        _maybeCompact();
+    }
+
+    DOKI_LOGI(STATE, "✓ %u state(s), %lu of %lu bytes live (%lu ms)",
+                  (unsigned)_index.size(), (unsigned long)_liveBytes, (unsigned long)_fileSize,
+                  (unsigned long)(millis() - start));
+    return true;
+}
+
+bool StateJournal::contains(const char* appId) {
+    return _index.find(appId) != _index.end();
+}
+
+size_t StateJournal::getSize(const char* appId) {
+    auto it = _index.find(appId);
+    return it != _index.end() ? it->second.length : 0;
+}
+
+bool StateJournal::read(const char* appId, std::vector<uint8_t>& out) {
+    auto it = _index.find(appId);
+    if (!_ready || it == _index.end()) {
+        return false;
+    }
+
+    const std::string& key = it->first;
+    const IndexEntry& entry = it->second;
+
+    File file = DOKI_FS.open(JOURNAL_PATH, FILE_READ);
+    if (!file) {
+        DOKI_LOGE(STATE, "Failed to open journal");
+        return false;
+    }
+
+    out.resize(entry.length);
+    bool ok = file.seek(entry.offset + sizeof(RecordHeader) + key.size()) &&
+              file.read(out.data(), entry.length) == entry.length;
+    file.close();
+
+    if (!ok || crcOf(crcOf(0, key.data(), key.size()), out.data(), out.size()) != entry.crc) {
+        DOKI_LOGE(STATE, "State of '%s' is damaged", appId);
+        out.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool StateJournal::append(const char* appId, const uint8_t* data, size_t size) {
+    if (!_ready || !data || size == 0 || size > STATE_JOURNAL_MAX_RECORD) {
+        return false;
+    }
+
+    return _write(appId, data, size);
+}
+
+bool StateJournal::remove(const char* appId) {
+    if (!_ready) {
+        return false;
+    }
+
+    if (!contains(appId)) {
+        return true;
+    }
+
+    return _write(appId, nullptr, 0);
+}
+
+bool StateJournal::clear() {
+    if (DOKI_FS.exists(JOURNAL_PATH) && !DOKI_FS.remove(JOURNAL_PATH)) {
+        DOKI_LOGE(STATE, "Failed to delete journal");
+        return false;
+    }
+
+    _index.clear();
+    _fileSize = 0;
+    _liveBytes = 0;
+    return true;
+}
+
+bool StateJournal::compact() {
+    if (!_ready) {
+        return false;
+    }
+
+    uint32_t start = millis();
+    uint32_t before = _fileSize;
+
+    File in = DOKI_FS.open(JOURNAL_PATH, FILE_READ);
+    File out = DOKI_FS.open(COMPACT_PATH, FILE_WRITE);
+    if (!out) {
+        DOKI_LOGE(STATE, "Failed to create compacted journal");
+        if (in) in.close();
+        return false;
+    }
+
+    // Latest record of each app, keeping its sequence number
+    std::unordered_map<std::string, IndexEntry> index;
+    std::vector<uint8_t> payload;
+    uint32_t offset = 0;
+    bool ok = true;
+
+    for (auto it = _index.begin(); it != _index.end() && ok; ++it) {
+        const std::string& key = it->first;
+        const IndexEntry& entry = it->second;
+
+        payload.resize(entry.length);
+        if (!in || !in.seek(entry.offset + sizeof(RecordHeader) + key.size()) ||
+            in.read(payload.data(), entry.length) != entry.length ||
+            crcOf(crcOf(0, key.data(), key.size()), payload.data(), payload.size()) != entry.crc) {
+            DOKI_LOGW(STATE, "Dropping damaged state of '%s'", key.c_str());
+            continue;
+        }
+
+        ok = _writeRecord(out, key, entry.sequence, payload.data(), entry.length);
+        index[key] = { offset, entry.length, entry.sequence, entry.crc };
+        offset += _recordSize(key.size(), entry.length);
+    }
+
+    if (in) in.close();
+    out.close();
+
+    if (!ok) {
+        DOKI_LOGE(STATE, "Failed to write compacted journal");
+        DOKI_FS.remove(COMPACT_PATH);
+        return false;
+    }
+
+    // A crash between these two leaves only the copy, which init() adopts
+    DOKI_FS.remove(JOURNAL_PATH);
+    if (!DOKI_FS.rename(COMPACT_PATH, JOURNAL_PATH)) {
+        DOKI_LOGE(STATE, "Failed to replace journal");
+        _ready = false;
+        return false;
+    }
+
+    _index.swap(index);
+    _fileSize = offset;
+    _liveBytes = offset;
+
+    DOKI_LOGI(STATE, "✓ Compacted %lu -> %lu bytes (%lu ms)",
+                  (unsigned long)before, (unsigned long)offset, (unsigned long)(millis() - start));
+    return true;
+}
+
+// ========================================
+// Private Methods
+// ========================================
+
+uint32_t StateJournal::_recordSize(size_t keyLength, uint32_t length) {
+    return sizeof(RecordHeader) + keyLength + length;
+}
+
+bool StateJournal::_replay(uint32_t& validBytes) {
+    _index.clear();
+    _fileSize = 0;
+    _liveBytes = 0;
+    validBytes = 0;
+
+    if (!DOKI_FS.exists(JOURNAL_PATH)) {
+        return true;
+    }
+
+    File file = DOKI_FS.open(JOURNAL_PATH, FILE_READ);
+    if (!file) {
+        return false;
+    }
+
+    uint32_t size = file.size();
+    uint32_t offset = 0;
+    uint8_t chunk[256];
+    char key[256];
+
+    while (offset + sizeof(RecordHeader) <= size) {
+        RecordHeader header;
+        if (!file.seek(offset) || file.read((uint8_t*)&header, sizeof(header)) != sizeof(header)) break;
+
+        // Garbage or a record cut short by a power loss
+        if (header.magic != RECORD_MAGIC || header.keyLength == 0 ||
+            header.length > STATE_JOURNAL_MAX_RECORD) break;
+        uint32_t recordSize = _recordSize(header.keyLength, header.length);
+        if (offset + recordSize > size) break;
+
+        if (file.read((uint8_t*)key, header.keyLength) != header.keyLength) break;
+        uint32_t crc = crcOf(0, key, header.keyLength);
+
+        uint32_t left = header.length;
+        while (left > 0) {
+            size_t n = left < sizeof(chunk) ? left : sizeof(chunk);
+            if (file.read(chunk, n) != n) break;
+            crc = crcOf(crc, chunk, n);
+            left -= n;
+        }
+        if (left > 0 || crc != header.crc) break;
+
+        _apply(std::string(key, header.keyLength), offset, header.length, header.sequence, header.crc);
+        if (header.sequence >= _sequence) {
+            _sequence = header.sequence + 1;
+        }
+        offset += recordSize;
+    }
+
+    file.close();
+
+    _fileSize = size;
+    validBytes = offset;
+    return true;
+}
+
+bool StateJournal::_write(const char* appId, const uint8_t* data, uint32_t size) {
+    std::string key(appId ? appId : "");
+    if (key.empty() || key.size() > 255) {
+        return false;
+    }
+
+    File file = DOKI_FS.open(JOURNAL_PATH, FILE_APPEND);
+    if (!file) {
+        DOKI_LOGE(STATE, "Failed to open journal");
+        return false;
+    }
+
+    uint32_t offset = _fileSize;
+    uint32_t sequence = _sequence++;
+    bool ok = _writeRecord(file, key, sequence, data, size);
+    file.close();
+
+    if (!ok) {
+        // Records appended after a torn one would be lost on the next
+        // replay; rewrite the journal from the index right away
+        DOKI_LOGE(STATE, "Failed to append state of '%s'", appId);
+        compact();
+        return false;
+    }
+
+    uint32_t crc = crcOf(crcOf(0, key.data(), key.size()), data, size);
+    _fileSize += _recordSize(key.size(), size);
+    _apply(key, offset, size, sequence, crc);
+    _maybeCompact();
+
+    return true;
+}
+
+bool StateJournal::_writeRecord(File& file, const std::string& key, uint32_t sequence,
+                                const uint8_t* data, uint32_t size) {
+    RecordHeader header = {};
+    header.magic = RECORD_MAGIC;
+    header.sequence = sequence;
+    header.length = size;
+    header.crc = crcOf(crcOf(0, key.data(), key.size()), data, size);
+    header.keyLength = (uint8_t)key.size();
+
+    return file.write((const uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+           file.write((const uint8_t*)key.data(), key.size()) == key.size() &&
+           (size == 0 || file.write(data, size) == size);
+}
+
+void StateJournal::_apply(const std::string& key, uint32_t offset, uint32_t length,
+                          uint32_t sequence, uint32_t crc) {
+    auto it = _index.find(key);
+    if (it != _index.end()) {
+        _liveBytes -= _recordSize(key.size(), it->second.length);
+        _index.erase(it);
+    }
+
+    // Removal records are never live
+    if (length > 0) {
+        _index[key] = { offset, length, sequence, crc };
+        _liveBytes += _recordSize(key.size(), length);
+    }
+}
+
+void StateJournal::_maybeCompact() {
+    if (_fileSize >= STATE_JOURNAL_COMPACT_MIN_BYTES && _fileSize > 2 * _liveBytes) {
+        compact();
+    }
+}
+
+} // namespace Doki
@@ -4,120 +4,139 @@
  */
 
 #include "doki/state_persistence.h"
+#include "doki/state_journal.h"
+#include "doki/logger.h"
+#include <esp_system.h>
+#include "timing_constants.h"
 
 namespace Doki {
 
+// NVS limits key names to 15 characters
+static constexpr size_t NVS_KEY_MAX_LENGTH = 15;
+
 // Static member initialization
 bool StatePersistence::_initialized = false;
+bool StatePersistence::_journal = false;
 Preferences StatePersistence::_prefs;
+SemaphoreHandle_t StatePersistence::_mutex = nullptr;
+std::map<std::string, StatePersistence::Entry> StatePersistence::_cache;
+uint32_t StatePersistence::_pending = 0;
+uint32_t StatePersistence::_firstDirtyAt = 0;
+uint32_t StatePersistence::_lastSaveAt = 0;
 
 bool StatePersistence::init() {
     if (_initialized) {
-        Serial.println("[StatePersistence] Already initialized");
+        DOKI_LOGD(STATE, "Already initialized");
         return true;
     }
 
-    Serial.println("[StatePersistence] Initializing...");
+    DOKI_LOGI(STATE, "Initializing...");
+
+    _mutex = xSemaphoreCreateMutex();
+    if (!_mutex) {
+        DOKI_LOGE(STATE, "Failed to create mutex");
+        return false;
+    }
+
+    // NVS is initialized by StorageManager; open our namespace once and
+    // keep it open for the lifetime of the system
+    if (!_prefs.begin(NAMESPACE, false)) {
+        DOKI_LOGE(STATE, "Failed to open NVS");
+        return false;
+    }
+
+    // Journal on the filesystem; NVS only if that is unavailable
+    _journal = StateJournal::init();
+    if (!_journal) {
+        DOKI_LOGW(STATE, "State journal unavailable, using NVS");
+    }
+
+    // Pending states must not be lost to ESP.restart()
+    esp_register_shutdown_handler(_onShutdown);
 
-    // NVS is initialized by StorageManager, so we just mark as initialized
     _initialized = true;
 
-    Serial.println("[StatePersistence] ✓ Initialized");
+    DOKI_LOGI(STATE, "✓ Initialized (MessagePack, write-back cache, %s)",
+                  _journal ? "journal" : "NVS");
     return true;
 }
 
 bool StatePersistence::saveState(const char* appId, const JsonDocument& state) {
     if (!_initialized) {
-        Serial.println("[StatePersistence] Error: Not initialized");
+        DOKI_LOGE(STATE, "Not initialized");
         return false;
     }
 
     if (!appId) {
-        Serial.println("[StatePersistence] Error: Invalid app ID");
+        DOKI_LOGE(STATE, "Invalid app ID");
         return false;
     }
 
-    // Serialize JSON to string
-    String jsonString;
-    serializeJson(state, jsonString);
+    // Encode outside the lock
+    size_t size = measureMsgPack(state);
 
     // Check size limit
-    if (jsonString.length() > MAX_STATE_SIZE) {
-        Serial.printf("[StatePersistence] Error: State too large (%d bytes, max %d)\n",
-                      jsonString.length(), MAX_STATE_SIZE);
+    if (size > _maxStateSize()) {
+        DOKI_LOGE(STATE, "State too large (%u bytes, max %u)",
+                      (unsigned)size, (unsigned)_maxStateSize());
         return false;
     }
 
-    // Open preferences
-    if (!_prefs.begin(NAMESPACE, false)) {
-        Serial.println("[StatePersistence] Error: Failed to open NVS");
-        return false;
-    }
-
-    // Generate key
-    String key = _makeKey(appId);
+    std::vector<uint8_t> packed(size);
+    serializeMsgPack(state, packed.data(), size);
 
-    // Save to NVS
-    size_t written = _prefs.putString(key.c_str(), jsonString);
-    _prefs.end();
+    xSemaphoreTake(_mutex, portMAX_DELAY);
 
-    if (written == 0) {
-        Serial.printf("[StatePersistence] Error: Failed to save state for '%s'\n", appId);
-        return false;
+    // An unchanged state never reaches storage
+    Entry& entry = _entry(appId);
+    std::vector<uint8_t> current;
+    bool changed = !_read(appId, entry, current) || current != packed;
+    if (changed) {
+        entry.packed.swap(packed);
+        entry.resident = true;
+        _markDirty(entry);
     }
+    _lastSaveAt = millis();
+
+    xSemaphoreGive(_mutex);
 
-    Serial.printf("[StatePersistence] ✓ Saved state for '%s' (%d bytes)\n",
-                  appId, jsonString.length());
+    DOKI_LOGD(STATE, "✓ Saved state for '%s' (%u bytes%s)",
+                  appId, (unsigned)size, changed ? ", pending" : ", unchanged");
 
     return true;
 }
 
 bool StatePersistence::loadState(const char* appId, JsonDocument& state) {
     if (!_initialized) {
-        Serial.println("[StatePersistence] Error: Not initialized");
+        DOKI_LOGE(STATE, "Not initialized");
         return false;
     }
 
     if (!appId) {
-        Serial.println("[StatePersistence] Error: Invalid app ID");
-        return false;
-    }
-
-    // Open preferences
-    if (!_prefs.begin(NAMESPACE, true)) { // Read-only
-        Serial.println("[StatePersistence] Error: Failed to open NVS");
-        return false;
-    }
-
-    // Generate key
-    String key = _makeKey(appId);
-
-    // Check if state exists
-    if (!_prefs.isKey(key.c_str())) {
-        _prefs.end();
-        Serial.printf("[StatePersistence] No saved state for '%s'\n", appId);
+        DOKI_LOGE(STATE, "Invalid app ID");
         return false;
     }
 
-    // Load from NVS
-    String jsonString = _prefs.getString(key.c_str(), "");
-    _prefs.end();
+    std::vector<uint8_t> packed;
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    bool found = _read(appId, _entry(appId), packed);
+    xSemaphoreGive(_mutex);
 
-    if (jsonString.isEmpty()) {
-        Serial.printf("[StatePersistence] Error: Empty state for '%s'\n", appId);
+    // No saved state
+    if (!found) {
         return false;
     }
 
-    // Deserialize JSON
-    DeserializationError error = deserializeJson(state, jsonString);
+    // Deserialize MessagePack
+    DeserializationError error = deserializeMsgPack(state, packed.data(), packed.size());
     if (error) {
-        Serial.printf("[StatePersistence] Error: Failed to parse state for '%s': %s\n",
+        DOKI_LOGE(STATE, "Failed to parse state for '%s': %s",
                       appId, error.c_str());
         return false;
     }
 
-    Serial.printf("[StatePersistence] ✓ Loaded state for '%s' (%d bytes)\n",
-                  appId, jsonString.length());
+    DOKI_LOGD(STATE, "✓ Loaded state for '%s' (%u bytes)",
+                  appId, (unsigned)packed.size());
 
     return true;
 }
@@ -127,43 +146,40 @@ bool StatePersistence::hasState(const char* appId) {
         return false;
     }
 
-    if (!_prefs.begin(NAMESPACE, true)) {
-        return false;
-    }
-
-    String key = _makeKey(appId);
-    bool exists = _prefs.isKey(key.c_str());
-
-    _prefs.end();
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    const Entry& entry = _entry(appId);
+    bool exists = !entry.resident || !entry.packed.empty();
+    xSemaphoreGive(_mutex);
 
     return exists;
 }
 
 bool StatePersistence::clearState(const char* appId) {
     if (!_initialized) {
-        Serial.println("[StatePersistence] Error: Not initialized");
+        DOKI_LOGE(STATE, "Not initialized");
         return false;
     }
 
     if (!appId) {
-        Serial.println("[StatePersistence] Error: Invalid app ID");
+        DOKI_LOGE(STATE, "Invalid app ID");
         return false;
     }
 
-    if (!_prefs.begin(NAMESPACE, false)) {
-        Serial.println("[StatePersistence] Error: Failed to open NVS");
-        return false;
+    // Removed from storage with the next commit
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    Entry& entry = _entry(appId);
+    bool removed = !entry.resident || !entry.packed.empty();
+    if (removed) {
+        entry.packed.clear();
+        entry.resident = true;
+        _markDirty(entry);
     }
-
-    String key = _makeKey(appId);
-    bool removed = _prefs.remove(key.c_str());
-
-    _prefs.end();
+    xSemaphoreGive(_mutex);
 
     if (removed) {
-        Serial.printf("[StatePersistence] ✓ Cleared state for '%s'\n", appId);
+        DOKI_LOGI(STATE, "✓ Cleared state for '%s'", appId);
     } else {
-        Serial.printf("[StatePersistence] No state to clear for '%s'\n", appId);
+        DOKI_LOGD(STATE, "No state to clear for '%s'", appId);
     }
 
     return removed;
@@ -171,22 +187,23 @@ bool StatePersistence::clearState(const char* appId) {
 
 bool StatePersistence::clearAllStates() {
     if (!_initialized) {
-        Serial.println("[StatePersistence] Error: Not initialized");
-        return false;
-    }
-
-    if (!_prefs.begin(NAMESPACE, false)) {
-        Serial.println("[StatePersistence] Error: Failed to open NVS");
+        DOKI_LOGE(STATE, "Not initialized");
         return false;
     }
 
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    _cache.clear();
+    _pending = 0;
     bool cleared = _prefs.clear();
-    _prefs.end();
+    if (_journal) {
+        cleared = StateJournal::clear() && cleared;
+    }
+    xSemaphoreGive(_mutex);
 
     if (cleared) {
-        Serial.println("[StatePersistence] ✓ Cleared all states");
+        DOKI_LOGI(STATE, "✓ Cleared all states");
     } else {
-        Serial.println("[StatePersistence] Error: Failed to clear states");
+        DOKI_LOGE(STATE, "Failed to clear states");
     }
 
     return cleared;
@@ -197,23 +214,224 @@ size_t StatePersistence::getStateSize(const char* appId) {
         return 0;
     }
 
-    if (!_prefs.begin(NAMESPACE, true)) {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    const Entry& entry = _entry(appId);
+    size_t size = entry.resident ? entry.packed.size() : StateJournal::getSize(appId);
+    xSemaphoreGive(_mutex);
+
+    return size;
+}
+
+void StatePersistence::update() {
+    if (!_initialized || _pending == 0) {
+        return;
+    }
+
+    // Wait for a quiet period, so a burst of app switches is one commit,
+    // but never keep a change in RAM only for too long
+    uint32_t now = millis();
+    if (now - _lastSaveAt < STATE_FLUSH_QUIET_MS &&
+        now - _firstDirtyAt < STATE_FLUSH_MAX_DELAY_MS) {
+        return;
+    }
+
+    flush();
+}
+
+uint32_t StatePersistence::flush() {
+    if (!_initialized) {
         return 0;
     }
 
-    String key = _makeKey(appId);
-    size_t size = _prefs.getString(key.c_str(), "").length();
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    uint32_t written = _commit();
+    xSemaphoreGive(_mutex);
 
-    _prefs.end();
+    return written;
+}
 
-    return size;
+uint32_t StatePersistence::getPendingCount() {
+    return _pending;
 }
 
+// ========================================
+// Private Methods
+// ========================================
+
 String StatePersistence::_makeKey(const char* appId) {
+    // Simple key: "s_<appId>", hashed (FNV-1a) if that is too long for NVS
+    String key = "s_";
+    key += appId;
+    if (key.length() <= NVS_KEY_MAX_LENGTH) {
+        return key;
+    }
+
+    uint32_t hash = 2166136261u;
+    for (const char* c = appId; *c; c++) {
+        hash ^= (uint8_t)*c;
+        hash *= 16777619u;
+    }
+
+    char hashed[NVS_KEY_MAX_LENGTH + 1];
+    snprintf(hashed, sizeof(hashed), "h_%08lx", (unsigned long)hash);
+    return String(hashed);
+}
+
+String StatePersistence::_makeLegacyKey(const char* appId) {
     // Simple key: "app_<appId>"
     String key = "app_";
     key += appId;
     return key;
 }
 
+StatePersistence::Entry& StatePersistence::_entry(const char* appId) {
+    auto it = _cache.find(appId);
+    if (it != _cache.end()) {
+        return it->second;
+    }
+
+    // First access: one lookup, then the cache answers (also "no state")
+    Entry& entry = _cache[appId];
+    entry.resident = true;
+    entry.dirty = false;
+    entry.nvs = false;
+    entry.legacy = false;
+
+    if (_journal && StateJournal::contains(appId)) {
+        // Small states are worth keeping in RAM, large ones stay on the journal
+        if (StateJournal::getSize(appId) <= STATE_CACHE_MAX_BYTES) {
+            StateJournal::read(appId, entry.packed);
+        } else {
+            entry.resident = false;
+        }
+        return entry;
+    }
+
+    String key = _makeKey(appId);
+    size_t length = _prefs.isKey(key.c_str()) ? _prefs.getBytesLength(key.c_str()) : 0;
+    if (length > 0) {
+        entry.packed.resize(length);
+        if (_prefs.getBytes(key.c_str(), entry.packed.data(), length) != length) {
+            entry.packed.clear();
+        }
+
+        // Saved to NVS while the journal was unavailable: move it over
+        if (_journal) {
+            entry.nvs = true;
+            _markDirty(entry);
+        }
+        return entry;
+    }
+
+    // State saved as JSON text by an earlier firmware: convert it and
+    // rewrite it as MessagePack with the next commit
+    String legacyKey = _makeLegacyKey(appId);
+    if (legacyKey.length() <= NVS_KEY_MAX_LENGTH && _prefs.isKey(legacyKey.c_str())) {
+        JsonDocument state;
+        String jsonString = _prefs.getString(legacyKey.c_str(), "");
+        if (!jsonString.isEmpty() && !deserializeJson(state, jsonString)) {
+            entry.packed.resize(measureMsgPack(state));
+            serializeMsgPack(state, entry.packed.data(), entry.packed.size());
+        }
+        entry.legacy = true;
+        _markDirty(entry);
+    }
+
+    return entry;
+}
+
+bool StatePersistence::_read(const char* appId, const Entry& entry, std::vector<uint8_t>& out) {
+    if (!entry.resident) {
+        return StateJournal::read(appId, out);
+    }
+
+    out = entry.packed;
+    return !out.empty();
+}
+
+size_t StatePersistence::_maxStateSize() {
+    return _journal ? STATE_JOURNAL_MAX_RECORD : MAX_STATE_SIZE;
+}
+
+void StatePersistence::_markDirty(Entry& entry) {
+    if (entry.dirty) {
+        return;
+    }
+
+    entry.dirty = true;
+    if (_pending++ == 0) {
+        _firstDirtyAt = millis();
+    }
+}
+
+uint32_t StatePersistence::_commit() {
+    uint32_t written = 0;
+
+    for (auto it = _cache.begin(); it != _cache.end(); ++it) {
+        const char* appId = it->first.c_str();
+        Entry& entry = it->second;
+        if (!entry.dirty) continue;
+
+        String key = _makeKey(appId);
+        bool ok;
+        if (_journal) {
+            ok = entry.packed.empty() ? StateJournal::remove(appId)
+                                      : StateJournal::append(appId, entry.packed.data(), entry.packed.size());
+        } else if (entry.packed.empty()) {
+            ok = !_prefs.isKey(key.c_str()) || _prefs.remove(key.c_str());
+        } else {
+            ok = _prefs.putBytes(key.c_str(), entry.packed.data(), entry.packed.size()) == entry.packed.size();
+        }
+
+        if (!ok) {
+            DOKI_LOGE(STATE, "Failed to commit state for '%s'", appId);
+            continue;
+        }
+
+        if (entry.nvs) {
+            _prefs.remove(key.c_str());
+            entry.nvs = false;
+        }
+        if (entry.legacy) {
+            _prefs.remove(_makeLegacyKey(appId).c_str());
+            entry.legacy = false;
+        }
+
+        // Large states are read back from the journal when needed
+        if (_journal && entry.packed.size() > STATE_CACHE_MAX_BYTES) {
+            std::vector<uint8_t>().swap(entry.packed);
+            entry.resident = false;
+        }
+
+        entry.dirty = false;
+        _pending--;
+        written++;
+    }
+
+    if (_pending > 0) {
+        // Retry after another quiet period rather than on every loop
+        _firstDirtyAt = _lastSaveAt = millis();
+    }
+
+    if (written > 0) {
+        DOKI_LOGI(STATE, "✓ Committed %lu state(s) to %s", (unsigned long)written,
+                      _journal ? "journal" : "NVS");
+    }
+
+    return written;
+}
+
+void StatePersistence::_onShutdown() {
+    if (!_initialized || _pending == 0) {
+        return;
+    }
+
+    // Don't hang the restart if the lock holder can't run any more
+    if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return;
+    }
+    _commit();
+    xSemaphoreGive(_mutex);
+}
+
 } // namespace Doki
@@ -0,0 +1,266 @@
+/**
+ * @file tracer.cpp
+ * @brief Implementation of the span/instant tracer
+ */
+
+#include "doki/tracer.h"
+
+#ifdef DOKI_TRACE
+
+#include <esp_heap_caps.h>
+#include <stdarg.h>
+
+namespace Doki {
+
+// Static member initialization
+Tracer::Slot* Tracer::_rings[portNUM_PROCESSORS] = {};
+std::atomic<uint32_t> Tracer::_head[portNUM_PROCESSORS] = {};
+uint32_t Tracer::_floor[portNUM_PROCESSORS] = {};
+Tracer::TaskEntry Tracer::_tasks[TRACE_MAX_TASKS] = {};
+
+// ========================================
+// Public Methods
+// ========================================
+
+bool Tracer::init() {
+    if (_rings[0]) {
+        return true;
+    }
+
+    snprintf(_tasks[0].name, sizeof(_tasks[0].name), "other");
+
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        size_t bytes = sizeof(Slot) * TRACE_BUFFER_EVENTS;
+        Slot* ring = (Slot*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+        if (!ring) {
+            Serial.println("[Tracer] ✗ Failed to allocate trace buffers");
+            for (int i = 0; i < core; i++) {
+                free(_rings[i]);
+                _rings[i] = nullptr;
+            }
+            return false;
+        }
+        memset(ring, 0, bytes);
+        _rings[core] = ring;
+    }
+
+    Serial.printf("[Tracer] ✓ Initialized (%u events per core)\n", (unsigned)TRACE_BUFFER_EVENTS);
+    return true;
+}
+
+void Tracer::complete(const char* category, const char* name, int64_t startUs) {
+    _record(category, name, startUs, (uint32_t)(now() - startUs), PHASE_SPAN);
+}
+
+void Tracer::instant(const char* category, const char* name) {
+    _record(category, name, now(), 0, PHASE_INSTANT);
+}
+
+uint32_t Tracer::snapshot(std::vector<Event>& out) {
+    uint32_t overwritten = 0;
+    out.clear();
+    out.reserve(TRACE_BUFFER_EVENTS * portNUM_PROCESSORS);
+
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        const Slot* ring = _rings[core];
+        if (!ring) continue;
+
+        uint32_t head = _head[core].load(std::memory_order_acquire);
+        uint32_t pos = _floor[core];
+        if (head - pos > TRACE_BUFFER_EVENTS) {
+            overwritten += head - pos - TRACE_BUFFER_EVENTS;
+            pos = head - TRACE_BUFFER_EVENTS;
+        }
+
+        for (; pos != head; pos++) {
+            const Slot& slot = ring[pos & RING_MASK];
+
+            // Skip slots still being written, or rewritten while copying
+            if (slot.sequence != pos + 1) continue;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            Event event = slot.event;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence != pos + 1) continue;
+
+            out.push_back(event);
+        }
+    }
+
+    return overwritten;
+}
+
+void Tracer::clear() {
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        _floor[core] = _head[core].load(std::memory_order_acquire);
+    }
+}
+
+const char* Tracer::getTaskName(uint8_t task) {
+    return task < TRACE_MAX_TASKS ? _tasks[task].name : _tasks[0].name;
+}
+
+// ========================================
+// Private Methods
+// ========================================
+
+void Tracer::_record(const char* category, const char* name, int64_t startUs,
+                     uint32_t durationUs, Phase phase) {
+    uint8_t core = (uint8_t)xPortGetCoreID();
+    Slot* ring = _rings[core];
+    if (!ring) return;
+
+    uint32_t pos = _head[core].fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = ring[pos & RING_MASK];
+
+    // Readers must not take a half-written slot for the old event
+    slot.sequence = 0;
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.event.category = category;
+    slot.event.name = name;
+    slot.event.startUs = startUs;
+    slot.event.durationUs = durationUs;
+    slot.event.task = _taskIndex();
+    slot.event.core = core;
+    slot.event.phase = phase;
+
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.sequence = pos + 1;
+}
+
+uint8_t Tracer::_taskIndex() {
+    if (xPortInIsrContext()) {
+        return 0;
+    }
+
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    for (uint8_t i = 1; i < TRACE_MAX_TASKS; i++) {
+        TaskHandle_t handle = _tasks[i].handle.load(std::memory_order_acquire);
+        if (handle == self) {
+            return i;
+        }
+        if (handle == nullptr) {
+            // Losing the race means another task took it: keep looking
+            if (_tasks[i].handle.compare_exchange_strong(handle, self, std::memory_order_acq_rel)) {
+                snprintf(_tasks[i].name, sizeof(_tasks[i].name), "%s", pcTaskGetName(nullptr));
+                return i;
+            }
+        }
+    }
+
+    return 0;
+}
+
+// ========================================
+// Chrome Trace Export
+// ========================================
+
+TraceExport::TraceExport()
+    : _overwritten(0), _seenTasks(), _stage(STAGE_HEADER), _next(0), _first(true),
+      _lineLen(0), _lineSent(0) {
+    _overwritten = Tracer::snapshot(_events);
+
+    for (const Tracer::Event& event : _events) {
+        _seenTasks[event.core] |= 1UL << event.task;
+    }
+}
+
+size_t TraceExport::read(uint8_t* buffer, size_t maxLen) {
+    size_t written = 0;
+
+    while (written < maxLen) {
+        if (_lineSent == _lineLen && !_nextLine()) {
+            break;
+        }
+
+        size_t n = _lineLen - _lineSent;
+        if (n > maxLen - written) {
+            n = maxLen - written;
+        }
+        memcpy(buffer + written, _line + _lineSent, n);
+        written += n;
+        _lineSent += n;
+    }
+
+    return written;
+}
+
+bool TraceExport::_nextLine() {
+    const char* sep = _first ? "" : ",";
+
+    switch (_stage) {
+        case STAGE_HEADER:
+            _format("{\"traceEvents\":[\n");
+            _stage = STAGE_PROCESSES;
+            return true;
+
+        case STAGE_PROCESSES:
+            if (_next < portNUM_PROCESSORS) {
+                _format("%s{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":%u,\"args\":{\"name\":\"Core %u\"}}\n",
+                        sep, (unsigned)_next, (unsigned)_next);
+                _first = false;
+                _next++;
+                return true;
+            }
+            _stage = STAGE_THREADS;
+            _next = 0;
+            return _nextLine();
+
+        case STAGE_THREADS:
+            // _next walks (core, task) pairs
+            while (_next < (size_t)portNUM_PROCESSORS * TRACE_MAX_TASKS) {
+                unsigned core = _next / TRACE_MAX_TASKS;
+                unsigned task = _next % TRACE_MAX_TASKS;
+                _next++;
+                if (!(_seenTasks[core] & (1UL << task))) continue;
+
+                _format("%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":\"%s\"}}\n",
+                        sep, core, task, Tracer::getTaskName(task));
+                _first = false;
+                return true;
+            }
+            _stage = STAGE_EVENTS;
+            _next = 0;
+            return _nextLine();
+
+        case STAGE_EVENTS:
+            if (_next < _events.size()) {
+                const Tracer::Event& e = _events[_next++];
+                if (e.phase == Tracer::PHASE_SPAN) {
+                    _format("%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lu,\"pid\":%u,\"tid\":%u}\n",
+                            sep, e.name, e.category, (long long)e.startUs, (unsigned long)e.durationUs,
+                            (unsigned)e.core, (unsigned)e.task);
+                } else {
+                    _format("%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%lld,\"pid\":%u,\"tid\":%u}\n",
+                            sep, e.name, e.category, (long long)e.startUs, (unsigned)e.core, (unsigned)e.task);
+                }
+                _first = false;
+                return true;
+            }
+            _stage = STAGE_FOOTER;
+            return _nextLine();
+
+        case STAGE_FOOTER:
+            _format("],\"displayTimeUnit\":\"ms\",\"otherData\":{\"overwritten\":%lu}}\n",
+                    (unsigned long)_overwritten);
+            _stage = STAGE_DONE;
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+void TraceExport::_format(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(_line, sizeof(_line), fmt, args);
+    va_end(args);
+
+    _lineLen = n < 0 ? 0 : ((size_t)n < sizeof(_line) ? (size_t)n : sizeof(_line) - 1);
+    _lineSent = 0;
+}
+
+} // namespace Doki
+
+#endif // DOKI_TRACE
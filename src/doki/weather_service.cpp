@@ -5,6 +5,7 @@
 
 #include "doki/weather_service.h"
 #include "doki/api_client.h"
+#include "hardware_config.h"
 #include <ArduinoJson.h>
 
 namespace Doki {
@@ -16,6 +17,11 @@ namespace Doki {
 String WeatherService::_apiKey = "";
 WeatherData WeatherService::_cachedData;
 String WeatherService::_cachedLocation = "";
+SemaphoreHandle_t WeatherService::_mutex = nullptr;
+TaskHandle_t WeatherService::_fetchTask = nullptr;
+String WeatherService::_requestedLocation = "";
+String WeatherService::_fetchingLocation = "";
+String WeatherService::_failedLocation = "";
 
 // ========================================
 // Public Methods
@@ -25,28 +31,90 @@ void WeatherService::init(const char* apiKey) {
     _apiKey = String(apiKey);
     Serial.printf("[WeatherService] Initialized with API key: %s...\n", 
                   _apiKey.substring(0, 8).c_str());
+
+    if (_fetchTask) {
+        return;
+    }
+
+    if (!_mutex) {
+        _mutex = xSemaphoreCreateMutex();
+    }
+    if (!_mutex) {
+        Serial.println("[WeatherService] ✗ Failed to create mutex");
+        return;
+    }
+
+    BaseType_t created = xTaskCreatePinnedToCore(
+        _fetchTaskEntry,
+        "Weather_Fetch",
+        TASK_STACK_WEATHER,
+        nullptr,
+        TASK_PRIORITY_WEATHER,
+        &_fetchTask,
+        TASK_CORE_WEATHER
+    );
+    if (created != pdPASS) {
+        _fetchTask = nullptr;
+        Serial.println("[WeatherService] ✗ Failed to start fetch task");
+    }
 }
 
 bool WeatherService::getCurrentWeather(const String& location, WeatherData& data) {
     // Check if we have valid cached data for this location
-    if (_cachedLocation == location && isCacheValid()) {
+    _lock();
+    if (_cacheValidFor(location)) {
         Serial.printf("[WeatherService] Using cached data for '%s' (age: %lu ms)\n",
                       location.c_str(), millis() - _cachedData.lastUpdated);
         data = _cachedData;
+        _unlock();
         return true;
     }
+    _unlock();
     
     // Fetch fresh data
     return refreshWeather(location, data);
 }
 
-bool WeatherService::isCacheValid() {
-    if (!_cachedData.valid) {
+bool WeatherService::requestWeather(const String& location) {
+    if (!_fetchTask || _apiKey.isEmpty()) {
         return false;
     }
-    
-    uint32_t age = millis() - _cachedData.lastUpdated;
-    return age < CACHE_DURATION_MS;
+
+    _lock();
+    if (_cacheValidFor(location) || _fetchingLocation == location) {
+        _unlock();
+        return true;
+    }
+    _requestedLocation = location;
+    _failedLocation = "";
+    _unlock();
+
+    xTaskNotifyGive(_fetchTask);
+    return true;
+}
+
+WeatherService::FetchStatus WeatherService::pollWeather(const String& location, WeatherData& data) {
+    FetchStatus status;
+
+    _lock();
+    if (_requestedLocation == location || _fetchingLocation == location) {
+        status = FetchStatus::PENDING;
+    } else if (_failedLocation != location && _cacheValidFor(location)) {
+        data = _cachedData;
+        status = FetchStatus::READY;
+    } else {
+        status = FetchStatus::FAILED;
+    }
+    _unlock();
+
+    return status;
+}
+
+bool WeatherService::isCacheValid() {
+    _lock();
+    bool valid = _cacheValidFor(_cachedLocation);
+    _unlock();
+    return valid;
 }
 
 bool WeatherService::refreshWeather(const String& location, WeatherData& data) {
@@ -56,8 +124,10 @@ bool WeatherService::refreshWeather(const String& location, WeatherData& data) {
     
     if (success) {
         // Update cache
+        _lock();
         _cachedData = data;
         _cachedLocation = location;
+        _unlock();
         
         Serial.printf("[WeatherService] ✓ Weather updated: %.1f°C, %s\n",
                       data.tempC, data.condition.c_str());
@@ -69,19 +139,68 @@ bool WeatherService::refreshWeather(const String& location, WeatherData& data) {
 }
 
 WeatherData WeatherService::getCachedData() {
-    return _cachedData;
+    _lock();
+    WeatherData data = _cachedData;
+    _unlock();
+    return data;
 }
 
 void WeatherService::clearCache() {
     Serial.println("[WeatherService] Cache cleared");
+    _lock();
     _cachedData = WeatherData();
     _cachedLocation = "";
+    _unlock();
 }
 
 // ========================================
 // Private Methods
 // ========================================
 
+void WeatherService::_lock() {
+    if (_mutex) xSemaphoreTake(_mutex, portMAX_DELAY);
+}
+
+void WeatherService::_unlock() {
+    if (_mutex) xSemaphoreGive(_mutex);
+}
+
+bool WeatherService::_cacheValidFor(const String& location) {
+    if (!_cachedData.valid || _cachedLocation != location) {
+        return false;
+    }
+    
+    uint32_t age = millis() - _cachedData.lastUpdated;
+    return age < CACHE_DURATION_MS;
+}
+
+void WeatherService::_fetchTaskEntry(void* param) {
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // Requests made during a fetch are served right after it
+        while (true) {
+            _lock();
+            String location = _requestedLocation;
+            _requestedLocation = "";
+            _fetchingLocation = location;
+            _unlock();
+
+            if (location.isEmpty()) {
+                break;
+            }
+
+            WeatherData data;
+            bool success = refreshWeather(location, data);
+
+            _lock();
+            _fetchingLocation = "";
+            _failedLocation = success ? "" : location;
+            _unlock();
+        }
+    }
+}
+
 bool WeatherService::_fetchWeather(const String& location, WeatherData& data) {
     if (_apiKey.isEmpty()) {
         Serial.println("[WeatherService] Error: API key not set");
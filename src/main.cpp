@@ -23,6 +23,7 @@
 #include "doki/setup_portal.h"
 #include "doki/qr_generator.h"
 #include "doki/app_manager.h"
+#include "doki/app_profiler.h"
 #include "doki/weather_service.h"
 #include "doki/time_service.h"
 #include "doki/simple_http_server.h"
@@ -34,6 +35,15 @@
 #include "doki/lvgl_manager.h"
 #include "doki/js_engine.h"
 #include "doki/js_app.h"
+#include "doki/js_context_pool.h"
+#include "doki/js_http_worker.h"
+#include "doki/js_module_cache.h"
+#include "doki/js_ui_template.h"
+#include "doki/js_benchmarks.h"
+#include "doki/event_system.h"
+#include "doki/event_benchmarks.h"
+#include "doki/tracer.h"
+#include "doki/logger.h"
 
 // WebSocket support (if enabled)
 #define ENABLE_WEBSOCKET_SUPPORT  // Enable for C++ test
@@ -215,13 +225,25 @@ void lvgl_flush_display_generic(lv_disp_drv_t* disp, const lv_area_t* area,
 
 // Display-specific wrappers (for LVGL callback compatibility)
 void lvgl_flush_display0(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p) {
+    DOKI_TRACE_SCOPE("lvgl", "flush display 0");
     lvgl_flush_display_generic(disp, area, color_p, DISP0_CS, DISP0_DC);
 }
 
 void lvgl_flush_display1(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p) {
+    DOKI_TRACE_SCOPE("lvgl", "flush display 1");
     lvgl_flush_display_generic(disp, area, color_p, DISP1_CS, DISP1_DC);
 }
 
+// Called by LVGL after each completed refresh (feeds /api/perf first-frame times)
+void lvgl_monitor_display(lv_disp_drv_t* disp, uint32_t time, uint32_t px) {
+    for (uint8_t i = 0; i < DISPLAY_COUNT; i++) {
+        if (&displays[i].disp_drv == disp) {
+            Doki::AppProfiler::frameDone(i);
+            return;
+        }
+    }
+}
+
 // ========================================
 // Display Initialization (Original Working Code)
 // ========================================
@@ -257,6 +279,7 @@ bool initDisplay(uint8_t id, uint8_t cs, uint8_t dc, uint8_t rst) {
     d->disp_drv.hor_res = TFT_WIDTH;
     d->disp_drv.ver_res = TFT_HEIGHT;
     d->disp_drv.flush_cb = (id == 0) ? lvgl_flush_display0 : lvgl_flush_display1;
+    d->disp_drv.monitor_cb = lvgl_monitor_display;
     d->disp_drv.draw_buf = &d->draw_buf;
 
     // Register LVGL display
@@ -448,6 +471,12 @@ void setup() {
     Serial.println("║                  Version 0.2.0                     ║");
     Serial.println("╚═══════════════════════════════════════════════════╝\n");
 
+    // Start the async logger before anything else logs
+    Doki::Logger::init();
+#ifdef DOKI_TRACE
+    Doki::Tracer::init();
+#endif
+
     // Step 1: Initialize Storage (NVS for WiFi credentials)
     Serial.println("[Main] Step 1/6: Initializing storage...");
     if (!Doki::StorageManager::init()) {
@@ -523,6 +552,12 @@ void setup() {
     Doki::LVGLManager::unlock();
     delay(2000);
 
+    // Event callbacks run on this task (setup() and loop() share it)
+    Doki::EventSystem::init();
+#ifdef DOKI_EVENT_BENCHMARKS
+    Doki::EventBenchmarks::run();
+#endif
+
     // Step 3.5: Initialize StatePersistence
     Serial.println("\n[Main] Step 3.5/8: Initializing StatePersistence...");
     if (!Doki::StatePersistence::init()) {
@@ -534,6 +569,15 @@ void setup() {
     Serial.println("\n[Main] Step 3.6/8: Initializing JavaScript Engine...");
     if (!Doki::JSEngine::init()) {
         Serial.println("[Main] ⚠️  JavaScript support not available (continuing without it)");
+    } else {
+        Doki::JSContextPool::init();
+        Doki::JSHttpWorker::init();
+        Doki::JSModuleCache::init();
+        Doki::JSUITemplate::init();
+#ifdef DOKI_JS_BENCHMARKS
+        Doki::JSBenchmarks::runJsonConversion();
+        Doki::JSBenchmarks::runContextFootprint();
+#endif
     }
 
     // Step 3.7: Initialize AppManager
@@ -572,24 +616,38 @@ void setup() {
     // Advanced Demo - Showcases all JavaScript features (animations, MQTT, WebSocket, HTTP, multi-display)
     Doki::AppManager::registerApp("advanced_demo", "Advanced Demo",
         []() -> Doki::DokiApp* {
-            return new Doki::JSApp("advanced_demo", "Advanced Demo", "/apps/advanced_demo.js");
+            return new Doki::JSApp("advanced_demo", "Advanced Demo", "/apps/advanced_demo.js", true);
         },
         "Comprehensive demo of animations, MQTT, WebSocket, and multi-display features");
 
     // WebSocket Test - Diagnostic app for WebSocket connectivity testing
     Doki::AppManager::registerApp("websocket_test", "WebSocket Test",
         []() -> Doki::DokiApp* {
-            return new Doki::JSApp("websocket_test", "WebSocket Test", "/apps/websocket_test.js");
+            return new Doki::JSApp("websocket_test", "WebSocket Test", "/apps/websocket_test.js", true);
         },
         "WebSocket diagnostic and testing tool");
 
     // Cloud Weather - Animated cloud weather display
     Doki::AppManager::registerApp("cloud_weather", "Cloud Weather",
         []() -> Doki::DokiApp* {
-            return new Doki::JSApp("cloud_weather", "Cloud Weather", "/apps/cloud_weather.js");
+            return new Doki::JSApp("cloud_weather", "Cloud Weather", "/apps/cloud_weather.js", true);
         },
         "Animated cloud weather visualization (30 frames, 200x150)");
 
+    // Binding Benchmark - Measures native binding calls per second
+    Doki::AppManager::registerApp("binding_bench", "Binding Benchmark",
+        []() -> Doki::DokiApp* {
+            return new Doki::JSApp("binding_bench", "Binding Benchmark", "/apps/binding_bench.js", true);
+        },
+        "Measures JS-to-native binding calls per second");
+
+    // Particles - Procedural graphics on a JS canvas
+    Doki::AppManager::registerApp("particles", "Particles",
+        []() -> Doki::DokiApp* {
+            return new Doki::JSApp("particles", "Particles", "/apps/particles.js", true);
+        },
+        "Particle fountain drawn on a canvas (no object per particle)");
+
     Doki::AppManager::printStatus();
 
     // Step 4: Initialize WiFi Manager
@@ -849,6 +907,12 @@ void setup() {
         enterNormalMode();
     }
 
+    // From here on LVGL renders on its own task; loop() only runs apps
+    if (!Doki::LVGLManager::startRenderTask()) {
+        Serial.println("[Main] ✗ LVGL render task failed to start!");
+        while (1) delay(1000);
+    }
+
     Serial.println("\n[Main] ✓ Setup complete!\n");
 }
 
@@ -857,6 +921,9 @@ void setup() {
 // ========================================
 
 void loop() {
+    // Events published by other tasks (HTTP server, workers) since the last pass
+    Doki::EventSystem::dispatch();
+
     if (setupMode) {
         // Setup Mode: Handle captive portal
         Doki::SetupPortal::update();
@@ -872,13 +939,21 @@ void loop() {
 
         // Handle WiFi reconnection
         Doki::WiFiManager::handleReconnection();
-    }
 
-    // Always update LVGL (protected by mutex)
-    Doki::LVGLManager::lock();
-    lv_timer_handler();
-    Doki::LVGLManager::unlock();
+        // Commit app states once saves have quietened down
+        Doki::StatePersistence::update();
+    }
 
-    // OPTIMIZATION: Removed delay(5) to maximize FPS
-    // Run loop as fast as possible for best animation performance
+    // Sleep until the next app deadline. While any app updates every
+    // loop (JS apps, sprite player) this is 0 and the loop runs flat out
+    // for animation performance. LVGL renders on its own task.
+    if (!setupMode) {
+        uint32_t idle = Doki::AppManager::getNextUpdateDelay();
+        if (idle > LOOP_MAX_IDLE_MS) {
+            idle = LOOP_MAX_IDLE_MS;
+        }
+        if (idle > 0) {
+            delay(idle);
+        }
+    }
 }